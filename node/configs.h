@@ -47,6 +47,295 @@
 
 #define TASK_NUMBER				4
 
+/*
+ * Sensor discovery
+ *
+ * 	- The bus is scanned at boot and the chip id of each known
+ * 	  driver (drivers.cpp) is read, the matching drivers are
+ * 	  instantiated and their caches registered.
+ * 	- NUMBER_OF_SENSORS is then the most sensors kept.
+ * 	- Undefined, node.ino hard wires the sensors.
+ */
+#define SENSOR_DISCOVERY
+
+/*
+ * System clock
+ *
+ * 	- Free running hardware timer extended to a 64 bit us clock.
+ */
+#define CLOCK_TIMER_BASE		(TIMERA2_BASE)
+#define CLOCK_TIMER_PRCM		(PRCM_TIMERA2)
+
+/*
+ * Scheduler configuration
+ *
+ * 	- SCHEDULER_HEAP_MODE keeps the enabled tasks in a deadline
+ * 	  ordered min-heap so a pass only touches the due tasks.
+ * 	  Comment it out to fall back to the linear list walk.
+ */
+#define SCHEDULER_HEAP_MODE
+#define SCHEDULER_MAX_TASKS		(32)
+
+/*
+ * Tickless idle
+ *
+ * 	- After a pass the BIOS sleeps until the next task deadline.
+ * 	- Sleeps shorter than the minimum are skipped.
+ * 	- A wake request ends the sleep: any interrupt ends the MCU
+ * 	  sleep, a sleep hook that interrupts do not end comes with its
+ * 	  wake hook (scheduler::set_sleep()).
+ */
+#define SCHEDULER_TICKLESS_IDLE
+#define SCHEDULER_IDLE_MIN_MS	(2)
+#define SCHEDULER_IDLE_MAX_MS	(1000)
+
+/*
+ * Task profiling
+ *
+ * 	- Per task run time, start latency and missed deadlines.
+ * 	- The CPU load is computed over the profiling window.
+ */
+#define SCHEDULER_PROFILE
+#define SCHEDULER_PROFILE_WINDOW_MS	(10000)
+
+/*
+ * Task control mailbox
+ *
+ * 	- Fixed size ring of control commands (power of two, <= 128).
+ * 	- Tasks are looked up by thread id, ids must be below the max.
+ * 	- TASK_ID_ALL addresses every registered task.
+ */
+#define SCHEDULER_MAILBOX_SIZE	(16)
+#define SCHEDULER_MAX_THREAD_ID	(32)
+#define TASK_ID_ALL				(255)
+
+/*
+ * Load shedding
+ *
+ * 	- Low priority tasks get their interval doubled per shed level
+ * 	  while the utilisation stays above the high threshold (%), and
+ * 	  relaxed one level at a time below the low threshold.
+ * 	- Needs SCHEDULER_PROFILE for the busy time.
+ */
+#define SCHEDULER_LOAD_SHEDDING
+#define SCHEDULER_SHED_WINDOW_MS	(1000)
+#define SCHEDULER_SHED_HIGH		(80)
+#define SCHEDULER_SHED_LOW		(50)
+#define SCHEDULER_SHED_MAX_LEVEL	(3)
+
+/*
+ * Dataflow pipeline
+ *
+ * 	- A DAQ pass schedules the UPDATE task, which schedules the
+ * 	  PUBLISH task. The task intervals stay as the fallback.
+ * 	- A stage is not triggered more often than its min gap (ms),
+ * 	  stretched by the load shedding level.
+ */
+#define SCHEDULER_PIPELINE
+#define PIPELINE_UPDATE_MIN_GAP	(100)
+#define PIPELINE_PUBLISH_MIN_GAP	(500)
+
+/*
+ * Task watchdog
+ *
+ * 	- A hardware timer checks the running task against its budget.
+ * 	- A task that returns over budget is disabled or restarted.
+ * 	- The MCU watchdog is fed only while no task is over budget and
+ * 	  every enabled critical task ran within the feed period, so a
+ * 	  task that never returns resets the MCU.
+ * 	- The feed period must be longer than the critical task intervals.
+ * 	- It is half the MCU timeout at most, so a feed held back by a
+ * 	  late check in still lands before the first timeout.
+ * 	- TASK_WDT_RESTART runs the task body from its start again (the
+ * 	  task restart callback resets its coroutine).
+ */
+#define SCHEDULER_WATCHDOG
+#define WATCHDOG_TIMER_BASE		(TIMERA3_BASE)
+#define WATCHDOG_TIMER_PRCM		(PRCM_TIMERA3)
+#define WATCHDOG_TICK_MS		(10)
+#define WATCHDOG_FEED_MS		(1000)
+#define WATCHDOG_MCU_ENABLE
+#define WATCHDOG_MCU_TIMEOUT_MS	(2000)		// Resets after two timeouts
+
+#if (WATCHDOG_FEED_MS > (WATCHDOG_MCU_TIMEOUT_MS / 2))
+#error "WATCHDOG_FEED_MS must be at most half of WATCHDOG_MCU_TIMEOUT_MS"
+#endif
+
+/*
+ * Compile time task table
+ *
+ * 	- The tasks are instantiated in a task_table and dispatched
+ * 	  in table order through direct (inlinable) run() calls, one
+ * 	  virtual call per pass for the whole table.
+ * 	- The table is the only task declaration, it fills the boot
+ * 	  list (task_table::collect) so the controls, the watchdog and
+ * 	  the profiling still apply. It must hold TASK_NUMBER tasks.
+ */
+// #define SCHEDULER_STATIC_TABLE
+
+/*
+ * Schedulability analysis at boot
+ *
+ * 	- The worst case execution times are the declared ones (set_wcet),
+ * 	  or the measured maximum when larger, or the watchdog budget.
+ * 	- Response time analysis in rate monotonic order. A cooperative
+ * 	  task is blocked by the longest task of a lower rate.
+ * 	- An infeasible set is re-planned by doubling the LOW, then the
+ * 	  NORMAL periods, up to the max period. CRITICAL periods are kept.
+ * 	- Without the re-plan, or when it fails, the boot is rejected.
+ */
+#define SCHEDULER_ANALYSIS
+#define SCHEDULER_ANALYSIS_REPLAN
+#define SCHEDULER_REPLAN_STEPS		(8)
+#define SCHEDULER_REPLAN_MAX_MS		(10000)
+
+/*
+ * Fleet phase spreading
+ *
+ * 	- Every task starts on a phase hashed from DEVICE_ID plus a
+ * 	  random jitter, so the nodes booted together (i.e. after a
+ * 	  power outage) do not publish together.
+ * 	- Every broker (re)connection waits a random jitter.
+ * 	- The broker may assign a slot (COMMAND_TYPE_SLOT, argument = slot),
+ * 	  the tasks then run slot * FLEET_SLOT_MS after the command. The
+ * 	  broker sends the assignments of a fleet at once.
+ * 	- The slots stop at the shortest task period, a slot at or past
+ * 	  period / FLEET_SLOT_MS is rejected (100 ms tasks: slots 0-9).
+ */
+#define FLEET_PHASE_SPREAD
+#define FLEET_PHASE_MAX_MS			(1000)
+#define FLEET_JITTER_MS				(100)
+#define FLEET_RECONNECT_JITTER_MS	(5000)
+#define FLEET_SLOT_MS				(10)
+
+/*
+ * Event reactor
+ *
+ * 	- Interrupts and pollers post events to one queue. The timers
+ * 	  stay in the scheduler, as task deadlines.
+ * 	- The BIOS loop dispatches them to one handler per event type
+ * 	  before and after each scheduler pass.
+ * 	- The pollers (socket, link) also run while idle, the sleep
+ * 	  wakes every REACTOR_POLL_MS for them while any is registered.
+ * 	- The queue size must be a power of 2.
+ */
+#define BIOS_REACTOR
+#define REACTOR_QUEUE_SIZE		(16)
+#define REACTOR_MAX_POLLERS		(4)
+#define REACTOR_POLL_MS			(10)
+
+/*
+ * Preemptive backend
+ *
+ * 	- Every task runs in its own thread at its task priority, the
+ * 	  task API does not change.
+ * 	- Tasks of the same priority never preempt each other (one lock
+ * 	  per priority), a slow publish cannot stall the DAQ.
+ * 	- The pipeline triggers signal the downstream thread.
+ * 	- TI-RTOS (Energia MT) by default, OS_BACKEND_POSIX for Linux.
+ * 	- The task watchdog and the static table need the cooperative
+ * 	  scheduler.
+ */
+// #define SCHEDULER_PREEMPTIVE
+// #define OS_BACKEND_POSIX
+#define OS_PRIORITY_CRITICAL	(5)
+#define OS_PRIORITY_NORMAL		(3)
+#define OS_PRIORITY_LOW			(1)
+#define OS_STACK_SIZE			(2048)
+
+/*
+ * Interrupt driven sampling
+ *
+ * 	- An interrupt reads the accelerometer at a fixed rate (Hz, up to
+ * 	  1 kHz) into a preallocated lock free ring, each sample stamped
+ * 	  with its read time and its lateness past the trigger.
+ * 	- SAMPLER_DATA_READY: the accelerometer new data interrupt is the
+ * 	  trigger, every sample the chip makes is captured (the rate is
+ * 	  rounded down to its output data rate). Otherwise a hardware
+ * 	  timer ticks at the rate.
+ * 	- SAMPLER_FIFO: with data ready, a BMA222E keeps the samples in its
+ * 	  FIFO and interrupts once per watermark (frames), one drain per
+ * 	  batch instead of one read per sample. Timestamps are spread back
+ * 	  over the drain interval, FIFO overruns show in the statistics.
+ * 	  The BMA222 falls back to one read per sample.
+ * 	- A trigger that finds the bus taken by a task is read after the
+ * 	  task transaction, from the BIOS loop (reactor) or the DAQ task,
+ * 	  with the interrupts on. The delay shows in the statistics.
+ * 	- The DAQ task drains the ring in blocks, each block goes to the
+ * 	  sinks (sampler_t::add_sink), its newest sample to the sensor
+ * 	  cache. Samples drained with no sink show in the statistics.
+ * 	- A read is ~0.9 ms at 100 kHz on the bus, 1 kHz needs 400 kHz.
+ * 	- The ring size must be a power of 2.
+ * 	- Opt-in, SAMPLER_DATA_READY and SAMPLER_FIFO need SENSOR_SAMPLER.
+ */
+// #define SENSOR_SAMPLER
+// #define SAMPLER_DATA_READY
+// #define SAMPLER_FIFO
+#define SAMPLER_FIFO_WATERMARK	(16)
+#define SAMPLER_FRAMES_MAX		(32)
+#define SAMPLER_TIMER_BASE		(TIMERA1_BASE)
+#define SAMPLER_TIMER_PRCM		(PRCM_TIMERA1)
+#define SAMPLER_TIMER_INT		(INT_TIMERA1A)
+#define SAMPLER_TIMER_PRIORITY	(INT_PRIORITY_LVL_0)
+#define SAMPLER_RATE_HZ			(250)
+#define SAMPLER_RATE_MAX_HZ		(1000)
+#define SAMPLER_BUFFER_SIZE		(256)
+#define SAMPLER_SINKS_MAX		(2)
+
+/*
+ * I2C bus
+ *
+ * 	- The bus starts in standard mode to identify the devices, each
+ * 	  driver then registers its fastest clock (sensor_caps_t) and the
+ * 	  bus is raised to I2C_SPEED, clamped to the slowest of them.
+ * 	- A failed transaction is issued again up to I2C_RETRIES times, a
+ * 	  bus clear (I2C_CLEAR_PULSES SCL pulses, STOP, re-init) first.
+ * 	- The clear drives the bus pins as GPIOs (Energia pin numbers).
+ * 	- A queued transaction that makes no progress for I2C_TIMEOUT_MS
+ * 	  is failed and the bus cleared, a task waiting on it goes on.
+ */
+#define I2C_SPEED				(400000)
+#define I2C_BUS_BASE			(I2CA0_BASE)
+#define I2C_BUS_PRCM			(PRCM_I2CA0)
+#define I2C_SCL_PIN				(9)
+#define I2C_SDA_PIN				(10)
+#define I2C_RETRIES				(2)
+#define I2C_CLEAR_PULSES		(9)
+#define I2C_CLEAR_HALF_US		(5)
+#define I2C_TIMEOUT_MS			(20)
+
+/*
+ * I2C transaction queue
+ *
+ * 	- Drivers submit transaction descriptors (register index, span,
+ * 	  completion callback), the I2C master interrupt runs them back
+ * 	  to back while the CPU does other work.
+ * 	- The queue holds the bus until it is empty, the blocking calls
+ * 	  wait for it, and the interrupt readers defer as for a task
+ * 	  transaction.
+ * 	- I2C_BACKEND_SIM replaces the master with simulated devices
+ * 	  (i2c_sim_attach()) to run the queue on Linux.
+ * 	- The queue size must be a power of 2.
+ */
+#define I2C_ASYNC
+// #define I2C_BACKEND_SIM
+#define I2C_QUEUE_SIZE			(16)
+#define I2C_QUEUE_BASE			(I2CA0_BASE)
+#define I2C_QUEUE_INT			(INT_I2CA0)
+#define I2C_QUEUE_PRIORITY		(INT_PRIORITY_LVL_1)
+
+/*
+ * Host builds
+ *
+ * 	- The host test target (test/host) builds the platform independent
+ * 	  modules against stubs of Energia and driverlib, on a simulated
+ * 	  clock and simulated interrupts.
+ * 	- Its host_configs.h adjusts the options above for each test.
+ */
+#ifdef HOST_BUILD
+#include "host_configs.h"
+#endif
+
 /**
  * @brief WIFI definitons
  */
@@ -87,6 +376,12 @@ const char WIFI_LOCAL_SUBNET[4]	= {0xFF, 0xFF, 0xFF, 0x00}; // 255.255.255.0
 #define MQTT_PUBLISH_DATA_ACC		("sensor/01/data/acc")
 #define MQTT_PUBLISH_STATUS			("sensor/01/status")
 
+/*!
+ * Largest payload that fits a packet on the longest topic, past the
+ * fixed header (5) and the topic length (2)
+ */
+#define MQTT_MAX_PAYLOAD_SIZE		(MQTT_MAX_PACKET_SIZE - 5 - 2 - (sizeof(MQTT_PUBLISH_DATA_TEMP) - 1))
+
 /*!
  * Subscribe
  * 	- global_cmd
@@ -203,6 +498,7 @@ typedef enum {
  */
 typedef enum {
 
+	CACHE_TYPE_PROFILE		= 0x0800,	//!< CACHE_TYPE_PROFILE
 	CACHE_TYPE_HEARTBEAT	= 0x0600,	//!< CACHE_TYPE_HEARTBEAT
 	CACHE_TYPE_STATUS		= 0x0400,	//!< CACHE_TYPE_STATUS
 	CACHE_TYPE_TEMP_DATA	= 0x0200,	//!< CACHE_TYPE_TEMP_DATA
@@ -34,6 +34,16 @@ using namespace system_base;
  */
 bus_i2c_t* bus 		= new bus_i2c_t();
 
+#ifdef SENSOR_DISCOVERY
+
+/*
+ * Sensor list, filled from the bus scan
+ */
+sensor_t* sensors[NUMBER_OF_SENSORS + 1]	= {
+		(sensor_t*)NULL
+};
+#else
+
 /*
  * Sensors
  */
@@ -48,6 +58,7 @@ sensor_t* sensors[NUMBER_OF_SENSORS + 1]	= {
 		(sensor_t*)bma222,
 		(sensor_t*)NULL
 };
+#endif
 
 
 /*
@@ -55,6 +66,23 @@ sensor_t* sensors[NUMBER_OF_SENSORS + 1]	= {
  */
 static coms_t* coms = new coms_t();
 
+#ifdef SCHEDULER_STATIC_TABLE
+
+/*
+ * Compile time task table, dispatched in this order
+ */
+static task_table<
+	task_list<daq_t,
+	task_list<update_t,
+	task_list<publish_t,
+	task_list<idle_t> > > > > table;
+
+/*
+ * Task list, filled from the table in setup()
+ */
+static task_t* tasks[TASK_NUMBER];
+#else
+
 /*
  * Task list
  */
@@ -109,6 +137,25 @@ static task_t* tasks[TASK_NUMBER] 	= {
 		new idle_t		(/*  NULL         		*/),
 #endif
 };
+#endif
+
+/**
+ * @brief Registers the cache of every listed sensor
+ *
+ * @return status_code_t		The first failure, STATUS_OK otherwise
+ */
+static status_code_t register_sensors(){
+
+	status_code_t result;
+
+	for(uint8_t i = 0; sensors[i]; i ++){
+		if((result = system_base::BIOS_register(sensors[i])) != STATUS_OK){
+			NOTIFY_ERROR("Sensor not registered : " + String(sensors[i]->caps.name));
+			return result;
+		}
+	}
+	return STATUS_OK;
+}
 
 void setup() {
 
@@ -130,6 +177,40 @@ void setup() {
 	 * 	- db
 	 */
 
+#ifdef SENSOR_DISCOVERY
+	/*
+	 * Bring up the sensors that answer
+	 */
+	if(!sensor_discover(bus, sensors, NUMBER_OF_SENSORS)){
+		NOTIFY_ERROR("No sensors found.");
+	}
+#endif
+
+#ifdef SCHEDULER_STATIC_TABLE
+	/*
+	 * The table declares the tasks, boot them from its list
+	 */
+	if(table.collect(tasks, TASK_NUMBER) != TASK_NUMBER){
+		NOTIFY_ERROR("Task table does not hold TASK_NUMBER tasks.");
+		BIOS_hang();
+	}
+#endif
+
+	/*
+	 * The sensors are known, clock the bus as fast as they allow
+	 */
+	bus->set_speed(I2C_SPEED);
+
+#if defined(SCHEDULER_PIPELINE) && defined(DAQ_TASK_ENABLE) && \
+	defined(UPDATE_TASK_ENABLE) && defined(PUBLISH_TASK_ENABLE)
+
+	/*
+	 * Chain the stages: DAQ -> UPDATE -> PUBLISH
+	 */
+	tasks[0]->set_downstream(tasks[1], PIPELINE_UPDATE_MIN_GAP);
+	tasks[1]->set_downstream(tasks[2], PIPELINE_PUBLISH_MIN_GAP);
+#endif
+
 	/*
 	 * Init the system
 	 */
@@ -149,12 +230,8 @@ void setup() {
 	/*
 	 * Register the sensor caches
 	 */
-	else if((result = system_base::BIOS_register((sensor_t*)tmp006)) != STATUS_OK){
-		NOTIFY_ERROR("Problem in BIOS sensor register (tmp006) : " + String(result));
-		BIOS_hang();
-	}
-	else if((result = system_base::BIOS_register((sensor_t*)bma222)) != STATUS_OK){
-		NOTIFY_ERROR("Problem in BIOS sensor register (bma222) : " + String(result));
+	else if((result = register_sensors()) != STATUS_OK){
+		NOTIFY_ERROR("Problem in BIOS sensor register : " + String(result));
 		BIOS_hang();
 	}
 
@@ -165,6 +242,12 @@ void setup() {
 		NOTIFY_ERROR("Problem in BIOS boot : " + String(result));
 		BIOS_hang();
 	}
+#ifdef SCHEDULER_STATIC_TABLE
+	else if ((result = system_base::BIOS_boot_table(&table)) != STATUS_OK){
+		NOTIFY_ERROR("Problem in BIOS table boot : " + String(result));
+		BIOS_hang();
+	}
+#endif
 	else {
 		NOTIFY_INFO("BIOS setup complete : " + String(result));
 	}
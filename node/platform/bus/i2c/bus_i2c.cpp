@@ -6,6 +6,28 @@
  */
 
 #include <platform/bus/i2c/bus_i2c.h>
+#include <platform/bus/i2c/i2c_queue.h>
+#include <configs.h>
+#include <platform/clock/clock.h>
+#include <string.h>
+#include <inc/hw_memmap.h>
+#include <driverlib/prcm.h>
+#include <driverlib/i2c.h>
+#include <driverlib/interrupt.h>
+
+/*
+ * One Wire interface behind every instance
+ */
+TwoWire*		bus_i2c::busif 			= &Wire;
+volatile bool 	bus_i2c::busy 			= false;
+void 			(*bus_i2c::on_release)() = NULL;
+
+/*
+ * Clock and error counters, shared as well
+ */
+uint32_t			bus_i2c::speed 		= I2C_SPEED_STANDARD;
+uint32_t			bus_i2c::speed_max 	= I2C_SPEED_HW_MAX;
+i2c_bus_stats_t		bus_i2c::stats;
 
 /*!
  * \internal Initialize the bus I/O interface.
@@ -19,69 +41,356 @@ bus_i2c::bus_i2c() : bus(){
 	status		= STATUS_OK;
 
 	/*
-	 * We wrap the TwoWire class with our class.
+	 * Start the I2C Engine
 	 */
-	busif 		= &Wire;
+	busif->begin();
 
 	/*
-	 * Start the I2C Engine
+	 * Standard mode until the devices are known
 	 */
-	busif->begin();
+	clock(speed);
+
+#ifdef I2C_ASYNC
+	/*
+	 * The transaction queue shares the master
+	 */
+	i2c_queue::start();
+#endif
 }
 
 
 /*!
  * \brief Read multiple Bytes from a bus interface.
  *
+ * The bytes land in the caller buffer packet->buf.data, which
+ * must hold packet->size bytes. Nothing is allocated.
+ *
  * \param   addr    The device register or memory address.
  * \param 	packet	The device packet to read into.
  *
- * \return The number of Bytes read, which may be less than the
- *         requested number of Bytes in the event of an error.
+ * \return The number of Bytes read, 0 in the event of an error.
  */
 size_t bus_i2c::read(uint8_t addr, i2c_bus_packet_t* packet){
 
+	return (read_block(addr, packet->buf.mem, packet->buf.data, packet->size));
+}
+
+/*!
+ * \brief Burst read into a caller buffer, no allocation.
+ *
+ * For the interrupt readers (hardware timed sampling). Only
+ * call it while the bus is free (is_busy()), the bus status
+ * is left untouched.
+ *
+ * \param   addr    The device address.
+ * \param	index	The first register to read
+ * \param	data	Where to store the bytes
+ * \param	size	The number of bytes to read
+ *
+ * \return The number of Bytes read, 0 in the event of an error.
+ */
+size_t bus_i2c::read_burst(uint8_t addr, uint8_t index, uint8_t* data, uint8_t size){
+
+	/*
+	 * Register address, repeated start, then the burst
+	 */
+	busif->beginTransmission(addr);
+	busif->write(index);
+	if(busif->endTransmission(false)){
+		return (0);
+	}
+
+	if(size != busif->requestFrom(addr, size)){
+		return (0);
+	}
+
+	return (busif->readBytes((char*)data, size));
+}
+
+/*!
+ * \brief Burst read into a caller buffer (task context).
+ *
+ * One repeated start transaction, no allocation. Holds the
+ * bus against the interrupt readers and sets the bus status.
+ *
+ * \param   addr    The device address.
+ * \param	index	The first register to read
+ * \param	data	Where to store the bytes
+ * \param	size	The number of bytes to read
+ *
+ * \return The number of Bytes read, 0 in the event of an error.
+ */
+size_t bus_i2c::read_block(uint8_t addr, uint8_t index, uint8_t* data, uint8_t size){
+
 	// Container
 	size_t read;
 
+	take();
+	for(uint8_t attempt = 0;; attempt++){
+
+		read = read_burst(addr, index, data, size);
+		if(read == size){
+			break;
+		}
+
+		/*
+		 * Clear the bus and go again, or give up
+		 */
+		stats.errors++;
+		if(I2C_RETRIES <= attempt){
+			stats.failures++;
+			read = 0;
+			break;
+		}
+		stats.retries++;
+		recover();
+	}
+	status = (read == size) ? STATUS_OK : ERR_IO_ERROR;
+	release();
+
+	return (read);
+}
+
+/*!
+ * \brief Programs the master clock.
+ *
+ * \param	hz		The bus clock
+ */
+void bus_i2c::clock(uint32_t hz){
+
 	/*
-	 * Address the chip with the address passed (addr)
-	 * Read the number of bytes in the queue.
+	 * The master has two settings, fast mode from 400 kHz up
 	 */
-	busif->beginTransmission(addr);
-	busif->write(packet->buf.mem);
-	busif->endTransmission();
+	I2CMasterInitExpClk(I2C_BUS_BASE, PRCMPeripheralClockGet(I2C_BUS_PRCM),
+			(I2C_SPEED_FAST <= hz));
+}
+
+/*!
+ * \brief Sets the bus clock.
+ *
+ * Clamped to the slowest attached device and the master.
+ *
+ * \param	hz		The bus clock
+ *
+ * \return The bus clock applied (Hz)
+ */
+uint32_t bus_i2c::set_speed(uint32_t hz){
 
-	// Get the data
-	read = busif->requestFrom(addr, packet->size);
+	if(hz > speed_max){
+		hz = speed_max;
+	}
 
 	/*
-	 * Do a sanity check on the received data
+	 * Only the two master settings exist
 	 */
-	if(!(read & busif->available())){
+	hz = (I2C_SPEED_FAST <= hz) ? I2C_SPEED_FAST : I2C_SPEED_STANDARD;
 
-		/*
-		 * The number of read bytes does not correspond
-		 * to the bytes that are in the queue.
-		 *
-		 * Return 0 and set the status to error.
-		 */
-		status = ERR_IO_ERROR;
-		return (0);
+	take();
+	speed = hz;
+	clock(speed);
+	release();
+
+	return (speed);
+}
+
+/*!
+ * \brief Registers the fastest clock of a device on the bus.
+ *
+ * Lowers the bus clock at once if it is faster.
+ *
+ * \param	hz		The device limit, 0 for standard mode only
+ */
+void bus_i2c::limit_speed(uint32_t hz){
+
+	if(!hz){
+		hz = I2C_SPEED_STANDARD;
+	}
+
+	if(hz < speed_max){
+		speed_max = hz;
+	}
+
+	if(speed > speed_max){
+		set_speed(speed_max);
+	}
+}
+
+/*!
+ * \internal Drives an I2C line open drain.
+ *
+ * Low pulls the line down, high lets the pull-up take it: a slave
+ * holding the line low is never driven against.
+ *
+ * \param	pin		The line
+ * \param	level	HIGH or LOW
+ */
+static void line(uint8_t pin, uint8_t level){
+
+	if(level == LOW){
+		pinMode(pin, OUTPUT);
+		digitalWrite(pin, LOW);
+	}else{
+		pinMode(pin, INPUT_PULLUP);
+	}
+}
+
+/*!
+ * \brief Clears a hung bus and restarts the master.
+ *
+ * A slave stuck in a read holds SDA low, SCL is pulsed until it
+ * lets go, then a STOP ends its transaction. The lines are
+ * driven open drain. Call with the bus taken.
+ */
+void bus_i2c::recover(){
+
+	stats.recoveries++;
 
+	/*
+	 * Take the pins from the master, the bus idles high
+	 */
+	line(I2C_SDA_PIN, HIGH);
+	line(I2C_SCL_PIN, HIGH);
+	delayMicroseconds(I2C_CLEAR_HALF_US);
+
+	/*
+	 * Clock the slave out of its byte, at most one byte and the ack
+	 */
+	for(uint8_t pulse = 0; (pulse < I2C_CLEAR_PULSES) && !digitalRead(I2C_SDA_PIN); pulse++){
+		line(I2C_SCL_PIN, LOW);
+		delayMicroseconds(I2C_CLEAR_HALF_US);
+		line(I2C_SCL_PIN, HIGH);
+		delayMicroseconds(I2C_CLEAR_HALF_US);
+	}
+
+	/*
+	 * STOP, SDA rises while SCL is high. Only once the slave let
+	 * go of SDA, else the STOP cannot be seen on the bus.
+	 */
+	if(digitalRead(I2C_SDA_PIN)){
+		line(I2C_SCL_PIN, LOW);
+		line(I2C_SDA_PIN, LOW);
+		delayMicroseconds(I2C_CLEAR_HALF_US);
+		line(I2C_SCL_PIN, HIGH);
+		delayMicroseconds(I2C_CLEAR_HALF_US);
+		line(I2C_SDA_PIN, HIGH);
+		delayMicroseconds(I2C_CLEAR_HALF_US);
 	}else{
+		stats.stuck++;
+	}
+
+	/*
+	 * Pins back to the master, at the bus clock
+	 */
+	busif->begin();
+	clock(speed);
+
+#ifdef I2C_ASYNC
+	/*
+	 * The queue interrupt as well
+	 */
+	i2c_backend_init();
+#endif
+}
+
+/*!
+ * \brief Gets the error counters.
+ *
+ * \param	copy	Where to copy the counters
+ */
+void bus_i2c::get_stats(i2c_bus_stats_t* copy){
+
+	bool masked = IntMasterDisable();
+	*copy = stats;
+	if (!masked) {
+		IntMasterEnable();
+	}
+}
+
+/*!
+ * \brief Takes the bus for a task transaction.
+ *
+ * Waits for the queued transactions to finish first. If the
+ * queue makes no progress for I2C_TIMEOUT_MS, the transaction
+ * on the bus is failed and the bus cleared.
+ */
+void bus_i2c::take(){
+
+#ifdef I2C_ASYNC
+	// Containers
+	uint32_t	seen 	= i2c_queue::progress();
+	clock_us_t	since 	= sys_clock::now();
+#endif
+
+	for(;;){
 
 		/*
-		 * Create a buffer to hold the data
+		 * The queue may start from an interrupt meanwhile
 		 */
-		packet->buf.data = (uint8_t*)malloc(packet->size);
-		busif->readBytes((char*)packet->buf.data, read);
+		bool masked = IntMasterDisable();
+		bool taken = !busy;
+		busy = true;
+		if (!masked) {
+			IntMasterEnable();
+		}
+
+		if(taken){
+			return;
+		}
+
+#ifdef I2C_ASYNC
+		/*
+		 * The queue moves, wait on
+		 */
+		clock_us_t now = sys_clock::now();
+		if(seen != i2c_queue::progress()){
+			seen 	= i2c_queue::progress();
+			since 	= now;
+			continue;
+		}
+
+		/*
+		 * Stalled, a lost completion or a hung bus. The bus is ours
+		 * once its transaction is failed, clear it before use.
+		 */
+		if(clock_reached(since + CLOCK_MS(I2C_TIMEOUT_MS), now)){
+			if(i2c_queue::abort()){
+				stats.timeouts++;
+				recover();
+				return;
+			}
+			since = now;
+		}
+#endif
+	}
+}
+
+/*!
+ * \brief Releases the bus after a task transaction.
+ */
+void bus_i2c::release(){
+
+#ifdef I2C_ASYNC
+	/*
+	 * The queue interrupt stays off while Wire polls the master
+	 */
+	i2c_backend_idle();
+#endif
+
+	busy = false;
+
+	/*
+	 * Let a deferred interrupt reader in
+	 */
+	if(on_release){
+		on_release();
 	}
 
+#ifdef I2C_ASYNC
 	/*
-	 * We return the number of bytes read (> 0)
+	 * Then the transactions queued meanwhile
 	 */
-	return (read);
+	i2c_queue::kick();
+#endif
 }
 
 size_t bus_i2c::read_bytes(int addr, int size,
@@ -89,37 +398,28 @@ size_t bus_i2c::read_bytes(int addr, int size,
 
 	// Container
 	i2c_bus_packet_t packet;
-	uint8_t read_byte;
 
 	/*
-	 * Packetize
+	 * Packetize, the read lands in data
 	 */
 	this->packetize(size, index, data, &packet);
 
 	/*
-	 * Read
-	 */
-	read_byte = read(addr, &packet);
-
-	/*
-	 * Get the data
-	 */
-	get_data(data, &packet, size);
-
-	/*
-	 * Return the size
+	 * Read and return the size
 	 */
-	return read_byte;
+	return read(addr, &packet);
 }
 
 /*!
  * \brief Write multiple Bytes to a bus interface.
  *
+ * The register index packet->buf.mem goes first, then the
+ * packet->size bytes of the caller buffer.
+ *
  * \param   addr    The device register or memory address.
  * \param 	packet	The device packet to write
  *
- * \return The number of Bytes written, which may be less than the
- *         requested number of Bytes in the event of an error.
+ * \return The number of Bytes written, 0 in the event of an error.
  */
 size_t bus_i2c::write(uint8_t addr, i2c_bus_packet_t* packet){
 
@@ -127,18 +427,41 @@ size_t bus_i2c::write(uint8_t addr, i2c_bus_packet_t* packet){
 	size_t written;
 
 	/*
-	 * Begin the transmission to a specified chip id and
-	 * write the number of bytes provided.
+	 * Interrupt readers keep off until the transaction ends
 	 */
-	busif->beginTransmission(addr);
-	written = busif->write((uint8_t*)packet->buf.data, packet->size);
+	take();
+	for(uint8_t attempt = 0;; attempt++){
 
-	/*
-	 * If there is an error in the i/o interaction
-	 */
-	if(busif->endTransmission()){
-		status = ERR_IO_ERROR;
+		/*
+		 * Begin the transmission to a specified chip id and
+		 * write the number of bytes provided.
+		 */
+		busif->beginTransmission(addr);
+		busif->write(packet->buf.mem);
+		written = busif->write((uint8_t*)packet->buf.data, packet->size);
+
+		/*
+		 * Done if the i/o interaction went through
+		 */
+		if(!busif->endTransmission()){
+			status = STATUS_OK;
+			break;
+		}
+
+		/*
+		 * Clear the bus and go again, or give up
+		 */
+		stats.errors++;
+		if(I2C_RETRIES <= attempt){
+			stats.failures++;
+			status = ERR_IO_ERROR;
+			written = 0;
+			break;
+		}
+		stats.retries++;
+		recover();
 	}
+	release();
 
 	/*
 	 * Return the size that was written to the bus.
@@ -175,11 +498,13 @@ size_t bus_i2c::write_bytes(int addr, unsigned int size,
 uint8_t bus_i2c::get(uint8_t addr, uint8_t index){
 
 	/*
-	 * Create a packet
+	 * Create a packet, read into the value
 	 */
+	uint8_t value;
 	i2c_bus_packet_t packet;
 	packet.size = I2C_BUS_BYTE;
 	packet.buf.mem = index;
+	packet.buf.data = &value;
 
 	/*
 	 * Send the packet
@@ -188,9 +513,8 @@ uint8_t bus_i2c::get(uint8_t addr, uint8_t index){
 
 		/*
 		 * We have received some data
-		 * Return the value at the packet data location
 		 */
-		return (*packet.buf.data);
+		return (value);
 	}else{
 
 		/*
@@ -266,6 +590,55 @@ bool bus_i2c::probe(){
 	return(false);
 }
 
+/*!
+ * \brief Checks for a device at an address.
+ *
+ * An empty write, the device acknowledges its address or not.
+ * Not retried nor counted as an error, absence is an answer.
+ *
+ * \param   addr    The device address.
+ *
+ * \retval  true    A device responded to the bus address.
+ * \retval  false   A device did not respond to the bus address.
+ */
+bool bus_i2c::probe(uint8_t addr){
+
+	// Container
+	bool present;
+
+	take();
+	busif->beginTransmission(addr);
+	present = !busif->endTransmission();
+	release();
+
+	status = STATUS_OK;
+	return (present);
+}
+
+/*!
+ * \brief Scans the bus for devices.
+ *
+ * Probes the addresses I2C_ADDR_FIRST to I2C_ADDR_LAST.
+ *
+ * \param	found	Where to store the responding addresses
+ * \param	max		The room in found
+ *
+ * \return The number of devices found, up to max.
+ */
+uint8_t bus_i2c::scan(uint8_t* found, uint8_t max){
+
+	// Container
+	uint8_t count = 0;
+
+	for(uint8_t addr = I2C_ADDR_FIRST; (addr <= I2C_ADDR_LAST) && (count < max); addr++){
+		if(probe(addr)){
+			found[count++] = addr;
+		}
+	}
+
+	return (count);
+}
+
 /*!
  * \brief Returns the next byte to read.
  *
@@ -355,9 +728,12 @@ void bus_i2c::get_data(void* rec, i2c_bus_packet_t* packet, size_t size){
 
 	/*
 	 * We take the the structure pointer and copy "size" data
-	 * into it to fill it up.
+	 * into it to fill it up. Reads land in the packet buffer,
+	 * so only a packet read into another buffer needs this.
 	 */
-	memcpy(packet->buf.data, rec, size);
+	if(rec != packet->buf.data){
+		memcpy(rec, packet->buf.data, size);
+	}
 }
 
 /*
@@ -17,6 +17,28 @@
  */
 #define I2C_BUS_BYTE		(sizeof(uint8_t))
 
+/**
+ * @brief Longest burst, the Wire receive buffer
+ */
+#define I2C_BURST_MAX		(BUFFER_LENGTH)
+
+/**
+ * @brief Bus clocks (Hz)
+ *
+ * The CC3200 master runs standard and fast mode, fast mode plus
+ * is clamped to fast mode on this part.
+ */
+#define I2C_SPEED_STANDARD	(100000)
+#define I2C_SPEED_FAST		(400000)
+#define I2C_SPEED_FAST_PLUS	(1000000)
+#define I2C_SPEED_HW_MAX	(I2C_SPEED_FAST)
+
+/**
+ * @brief Scanned addresses, the others are reserved
+ */
+#define I2C_ADDR_FIRST		(0x08)
+#define I2C_ADDR_LAST		(0x77)
+
 /**
  * @brief Define I2C Master Address
  */
@@ -34,6 +56,19 @@ typedef struct {
 	uint8_t 		size;		/**< The size to read / write **/
 }i2c_bus_packet_t;
 
+/**
+ * @brief I2C Bus error counters
+ */
+typedef struct {
+
+	uint32_t		errors;		/**< Transactions that failed on the bus **/
+	uint32_t		retries;	/**< Transactions issued again **/
+	uint32_t		recoveries;	/**< Bus clears (SCL pulses, STOP, re-init) **/
+	uint32_t		failures;	/**< Transactions failed after every retry **/
+	uint32_t		timeouts;	/**< Queued transactions failed for a stall **/
+	uint32_t		stuck;		/**< Bus clears that left SDA low, no STOP **/
+}i2c_bus_stats_t;
+
 /*!
  * \name System Bus I/O Access Methods (i2c)
  */
@@ -52,13 +87,51 @@ class bus_i2c: public bus {
 	 * State the friend class
 	 */
 	friend TwoWire;
+	friend class i2c_queue;
+	friend class sampler;
 
 	/**
 	 * Private class attributes
 	 */
 	private:
 
-		TwoWire*		busif;				/**< Bus interface **/
+		static TwoWire*			busif;		/**< Bus interface, one behind every instance **/
+
+		static volatile bool	busy;		/**< Task or queued transaction in flight **/
+
+		static uint32_t			speed;		/**< Bus clock (Hz) **/
+		static uint32_t			speed_max;	/**< Slowest attached device limit (Hz) **/
+		static i2c_bus_stats_t	stats;		/**< Error counters **/
+
+		/*!
+		 * \brief Programs the master clock.
+		 *
+		 * \param	hz		The bus clock
+		 */
+		static void clock(uint32_t hz);
+
+		/*!
+		 * \brief Clears a hung bus and restarts the master.
+		 *
+		 * A slave stuck in a read holds SDA low, SCL is pulsed until it
+		 * lets go, then a STOP ends its transaction. The lines are
+		 * driven open drain. Call with the bus taken.
+		 */
+		static void recover();
+
+		/*!
+		 * \brief Takes the bus for a task transaction.
+		 *
+		 * Waits for the queued transactions to finish first. If the
+		 * queue makes no progress for I2C_TIMEOUT_MS, the transaction
+		 * on the bus is failed and the bus cleared.
+		 */
+		static void take();
+
+		/*!
+		 * \brief Releases the bus after a task transaction.
+		 */
+		static void release();
 
 	/**
 	 * Public Class methods
@@ -82,23 +155,105 @@ class bus_i2c: public bus {
 		/*!
 		 * \brief Read multiple Bytes from a bus interface.
 		 *
+		 * The bytes land in the caller buffer packet->buf.data, which
+		 * must hold packet->size bytes. Nothing is allocated.
+		 *
 		 * \param   addr    The device register or memory address.
 		 * \param 	packet	The device packet to read into.
 		 *
-		 * \return The number of Bytes read, which may be less than the
-		 *         requested number of Bytes in the event of an error.
+		 * \return The number of Bytes read, 0 in the event of an error.
 		 */
 		size_t read(uint8_t addr, i2c_bus_packet_t* packet);
 		size_t read_bytes(int addr, int size, uint8_t index, uint8_t* data);
 
+		/*!
+		 * \brief Burst read into a caller buffer, no allocation.
+		 *
+		 * For the interrupt readers (hardware timed sampling). Only
+		 * call it while the bus is free (is_busy()), the bus status
+		 * is left untouched.
+		 *
+		 * \param   addr    The device address.
+		 * \param	index	The first register to read
+		 * \param	data	Where to store the bytes
+		 * \param	size	The number of bytes to read
+		 *
+		 * \return The number of Bytes read, 0 in the event of an error.
+		 */
+		size_t read_burst(uint8_t addr, uint8_t index, uint8_t* data, uint8_t size);
+
+		/*!
+		 * \brief Burst read into a caller buffer (task context).
+		 *
+		 * One repeated start transaction, no allocation. Holds the
+		 * bus against the interrupt readers and sets the bus status.
+		 *
+		 * \param   addr    The device address.
+		 * \param	index	The first register to read
+		 * \param	data	Where to store the bytes
+		 * \param	size	The number of bytes to read
+		 *
+		 * \return The number of Bytes read, 0 in the event of an error.
+		 */
+		size_t read_block(uint8_t addr, uint8_t index, uint8_t* data, uint8_t size);
+
+		/*!
+		 * \brief Sets the bus clock.
+		 *
+		 * Clamped to the slowest attached device and the master.
+		 *
+		 * \param	hz		The bus clock
+		 *
+		 * \return The bus clock applied (Hz)
+		 */
+		uint32_t set_speed(uint32_t hz);
+
+		/*!
+		 * \brief Gets the bus clock (Hz).
+		 */
+		uint32_t get_speed(){
+			return speed;
+		}
+
+		/*!
+		 * \brief Registers the fastest clock of a device on the bus.
+		 *
+		 * Lowers the bus clock at once if it is faster.
+		 *
+		 * \param	hz		The device limit, 0 for standard mode only
+		 */
+		void limit_speed(uint32_t hz);
+
+		/*!
+		 * \brief Gets the error counters.
+		 *
+		 * \param	copy	Where to copy the counters
+		 */
+		static void get_stats(i2c_bus_stats_t* copy);
+
+		/**
+		 * @brief True while a task or queued transaction holds the bus (ISR safe).
+		 */
+		static bool is_busy(){
+			return busy;
+		}
+
+		/*
+		 * Called when a task transaction releases the bus, so an
+		 * interrupt reader that found it taken catches up. NULL for none.
+		 */
+		static void (*on_release)();
+
 		/*!
 		 * \brief Write multiple Bytes to a bus interface.
 		 *
+		 * The register index packet->buf.mem goes first, then the
+		 * packet->size bytes of the caller buffer.
+		 *
 		 * \param   addr    The device register or memory address.
 		 * \param 	packet	The device packet to write
 		 *
-		 * \return The number of Bytes written, which may be less than the
-		 *         requested number of Bytes in the event of an error.
+		 * \return The number of Bytes written, 0 in the event of an error.
 		 */
 		size_t write(uint8_t addr, i2c_bus_packet_t* packet);
 		size_t write_bytes(int addr, unsigned int size, uint8_t index, uint8_t* data);
@@ -138,6 +293,31 @@ class bus_i2c: public bus {
 		 */
 		bool probe();
 
+		/*!
+		 * \brief Checks for a device at an address.
+		 *
+		 * An empty write, the device acknowledges its address or not.
+		 * Not retried nor counted as an error, absence is an answer.
+		 *
+		 * \param   addr    The device address.
+		 *
+		 * \retval  true    A device responded to the bus address.
+		 * \retval  false   A device did not respond to the bus address.
+		 */
+		bool probe(uint8_t addr);
+
+		/*!
+		 * \brief Scans the bus for devices.
+		 *
+		 * Probes the addresses I2C_ADDR_FIRST to I2C_ADDR_LAST.
+		 *
+		 * \param	found	Where to store the responding addresses
+		 * \param	max		The room in found
+		 *
+		 * \return The number of devices found, up to max.
+		 */
+		uint8_t scan(uint8_t* found, uint8_t max);
+
 		/*!
 		 * \brief Returns the next byte to read.
 		 *
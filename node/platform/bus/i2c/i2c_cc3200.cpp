@@ -0,0 +1,192 @@
+/*
+ * i2c_cc3200.cpp
+ */
+
+#include <platform/bus/i2c/i2c_queue.h>
+
+#if defined(I2C_ASYNC) && !defined(I2C_BACKEND_SIM)
+
+#include <inc/hw_memmap.h>
+#include <inc/hw_ints.h>
+#include <driverlib/i2c.h>
+#include <driverlib/interrupt.h>
+
+/**
+ * @brief Where the transaction is
+ */
+typedef enum {
+
+	I2C_PHASE_INDEX,				//!< Register index sent
+	I2C_PHASE_WRITE,				//!< Sending the span
+	I2C_PHASE_READ					//!< Receiving the span
+}i2c_phase_t;
+
+/*
+ * The transaction on the bus
+ */
+static i2c_transaction_t*	current 	= NULL;
+static i2c_phase_t			phase 		= I2C_PHASE_INDEX;
+static uint8_t				position 	= 0;
+
+/**
+ * @brief Ends the transaction.
+ *
+ * @param 	ok				True if it completed
+ */
+static void i2c_backend_end(bool ok){
+
+	current = NULL;
+	i2c_queue::complete(ok);
+}
+
+/**
+ * @brief Master interrupt, one per byte on the bus.
+ *
+ * The blocking Wire calls poll the same master for their own
+ * completions, so the interrupt is only unmasked while a queued
+ * transaction holds the bus (i2c_backend_idle() masks it again).
+ * A late one with no transaction masks it and leaves the status
+ * to the poller.
+ */
+static void i2c_backend_isr(){
+
+	if(!current){
+		I2CMasterIntDisableEx(I2C_QUEUE_BASE, I2C_MASTER_INT_DATA);
+		return;
+	}
+	I2CMasterIntClearEx(I2C_QUEUE_BASE, I2CMasterIntStatusEx(I2C_QUEUE_BASE, true));
+
+	/*
+	 * Not acknowledged or arbitration lost, stop the bus
+	 */
+	if(I2C_MASTER_ERR_NONE != I2CMasterErr(I2C_QUEUE_BASE)){
+		I2CMasterControl(I2C_QUEUE_BASE, (I2C_PHASE_READ == phase) ?
+				I2C_MASTER_CMD_BURST_RECEIVE_ERROR_STOP : I2C_MASTER_CMD_BURST_SEND_ERROR_STOP);
+		i2c_backend_end(false);
+		return;
+	}
+
+	switch(phase){
+
+	/*
+	 * Index out, on to the span
+	 */
+	case I2C_PHASE_INDEX:
+		if(I2C_TXN_WRITE == current->dir){
+			if(!current->size){
+				i2c_backend_end(true);
+				return;
+			}
+			I2CMasterDataPut(I2C_QUEUE_BASE, current->data[0]);
+			position 	= 1;
+			phase 		= I2C_PHASE_WRITE;
+			I2CMasterControl(I2C_QUEUE_BASE, (1 == current->size) ?
+					I2C_MASTER_CMD_BURST_SEND_FINISH : I2C_MASTER_CMD_BURST_SEND_CONT);
+		}else{
+			/*
+			 * Repeated start in receive
+			 */
+			position 	= 0;
+			phase 		= I2C_PHASE_READ;
+			I2CMasterSlaveAddrSet(I2C_QUEUE_BASE, current->addr, true);
+			I2CMasterControl(I2C_QUEUE_BASE, (1 == current->size) ?
+					I2C_MASTER_CMD_SINGLE_RECEIVE : I2C_MASTER_CMD_BURST_RECEIVE_START);
+		}
+		break;
+
+	/*
+	 * Next byte out, the last one with a stop
+	 */
+	case I2C_PHASE_WRITE:
+		if(position == current->size){
+			i2c_backend_end(true);
+			return;
+		}
+		I2CMasterDataPut(I2C_QUEUE_BASE, current->data[position++]);
+		I2CMasterControl(I2C_QUEUE_BASE, (position == current->size) ?
+				I2C_MASTER_CMD_BURST_SEND_FINISH : I2C_MASTER_CMD_BURST_SEND_CONT);
+		break;
+
+	/*
+	 * Next byte in, the last one not acknowledged with a stop
+	 */
+	case I2C_PHASE_READ:
+		current->data[position++] = (uint8_t)I2CMasterDataGet(I2C_QUEUE_BASE);
+		if(position == current->size){
+			i2c_backend_end(true);
+			return;
+		}
+		I2CMasterControl(I2C_QUEUE_BASE, (position == (current->size - 1)) ?
+				I2C_MASTER_CMD_BURST_RECEIVE_FINISH : I2C_MASTER_CMD_BURST_RECEIVE_CONT);
+		break;
+	}
+}
+
+/**
+ * @brief Initialises the backend.
+ *
+ * Wire.begin() has clocked and configured the master already.
+ */
+void i2c_backend_init(){
+
+	I2CIntRegister(I2C_QUEUE_BASE, i2c_backend_isr);
+	IntPrioritySet(I2C_QUEUE_INT, I2C_QUEUE_PRIORITY);
+
+	/*
+	 * Masked until a queued transaction takes the bus
+	 */
+	I2CMasterIntDisableEx(I2C_QUEUE_BASE, I2C_MASTER_INT_DATA);
+}
+
+/**
+ * @brief Masks the master interrupt, the bus goes back to Wire.
+ *
+ * Drops the transaction on the bus, if any.
+ */
+void i2c_backend_idle(){
+
+	current = NULL;
+	I2CMasterIntDisableEx(I2C_QUEUE_BASE, I2C_MASTER_INT_DATA);
+}
+
+/**
+ * @brief Puts a transaction on the bus, it ends with i2c_queue::complete().
+ *
+ * @param 	txn				The transaction
+ */
+void i2c_backend_start(i2c_transaction_t* txn){
+
+	/*
+	 * An empty read has nothing to do
+	 */
+	if((I2C_TXN_READ == txn->dir) && !txn->size){
+		i2c_queue::complete(true);
+		return;
+	}
+
+	current 	= txn;
+	phase 		= I2C_PHASE_INDEX;
+	position 	= 0;
+
+	/*
+	 * A retry follows the error STOP, let it out first
+	 */
+	while(I2CMasterBusy(I2C_QUEUE_BASE)){
+	}
+
+	/*
+	 * Ours until i2c_backend_idle(), stale Wire completions dropped
+	 */
+	I2CMasterIntClearEx(I2C_QUEUE_BASE, I2C_MASTER_INT_DATA);
+	I2CMasterIntEnableEx(I2C_QUEUE_BASE, I2C_MASTER_INT_DATA);
+
+	/*
+	 * Address and register index, no stop before the span
+	 */
+	I2CMasterSlaveAddrSet(I2C_QUEUE_BASE, txn->addr, false);
+	I2CMasterDataPut(I2C_QUEUE_BASE, txn->index);
+	I2CMasterControl(I2C_QUEUE_BASE, ((I2C_TXN_WRITE == txn->dir) && !txn->size) ?
+			I2C_MASTER_CMD_SINGLE_SEND : I2C_MASTER_CMD_BURST_SEND_START);
+}
+
+#endif /* I2C_ASYNC && !I2C_BACKEND_SIM */
@@ -0,0 +1,245 @@
+/*
+ * i2c_queue.cpp
+ */
+
+#include <platform/bus/i2c/i2c_queue.h>
+
+#ifdef I2C_ASYNC
+
+#include <string.h>
+#include <driverlib/interrupt.h>
+#include <platform/bus/i2c/bus_i2c.h>
+
+/*
+ * Transaction queue
+ */
+i2c_transaction_t*		i2c_queue::queue[I2C_QUEUE_SIZE];
+volatile uint8_t		i2c_queue::head 		= 0;
+volatile uint8_t		i2c_queue::tail 		= 0;
+i2c_transaction_t* volatile	i2c_queue::active 	= NULL;
+uint8_t					i2c_queue::attempt 		= 0;
+volatile uint32_t		i2c_queue::moves 		= 0;
+bool					i2c_queue::started 		= false;
+
+/*
+ * Statistics
+ */
+i2c_queue_stats_t		i2c_queue::stats;
+
+/**
+ * @brief Starts the backend, once.
+ */
+void i2c_queue::start(){
+
+	if(started){
+		return;
+	}
+
+	memset(&stats, 0, sizeof(stats));
+	i2c_backend_init();
+	started = true;
+}
+
+/**
+ * @brief Queues a transaction (ISR safe).
+ *
+ * @param 	txn				The transaction
+ * @return	status			ERR_BUFFER_OVERFLOW if the queue is full
+ */
+status_code_t i2c_queue::submit(i2c_transaction_t* txn){
+
+	/*
+	 * Sanity check
+	 */
+	if(!txn || (!txn->data && txn->size)){
+		return ERR_INVALID_ARG;
+	}
+
+	/*
+	 * Producers may be interrupts, mask them around the slot claim
+	 */
+	bool masked = IntMasterDisable();
+	uint8_t slot = head;
+
+	/*
+	 * Full
+	 */
+	if((uint8_t)(slot - tail) >= I2C_QUEUE_SIZE){
+		stats.rejected++;
+		if (!masked) {
+			IntMasterEnable();
+		}
+		return ERR_BUFFER_OVERFLOW;
+	}
+
+	txn->state 								= I2C_TXN_QUEUED;
+	queue[slot & (I2C_QUEUE_SIZE - 1)] 		= txn;
+	head 									= slot + 1;
+
+	if((uint8_t)(head - tail) > stats.high_water){
+		stats.high_water = (uint8_t)(head - tail);
+	}
+
+	/*
+	 * Runs now if the bus is free
+	 */
+	kick();
+
+	if (!masked) {
+		IntMasterEnable();
+	}
+	return STATUS_OK;
+}
+
+/**
+ * @brief Waits for a transaction (task context).
+ *
+ * A stalled queue is failed and the bus cleared after
+ * I2C_TIMEOUT_MS, the wait then ends as well.
+ *
+ * @param 	txn				The transaction
+ * @return	bool			True if it completed
+ */
+bool i2c_queue::wait(const i2c_transaction_t* txn){
+
+	/*
+	 * Taking the bus waits the queue out, with the stall timeout
+	 */
+	while(!ended(txn)){
+		bus_i2c_t::take();
+		bus_i2c_t::release();
+	}
+	return (I2C_TXN_DONE == txn->state);
+}
+
+/**
+ * @brief Fails the transaction on the bus, the caller keeps the bus.
+ *
+ * For a stalled queue, the caller clears the bus next.
+ *
+ * @return	bool			True if a transaction was on the bus
+ */
+bool i2c_queue::abort(){
+
+	bool masked = IntMasterDisable();
+	i2c_transaction_t* txn = active;
+
+	if(txn){
+
+		/*
+		 * The backend forgets it, a late interrupt finds nothing
+		 */
+		i2c_backend_idle();
+		active 		= NULL;
+		moves++;
+		stats.failed++;
+		txn->state 	= I2C_TXN_FAILED;
+		if(txn->done){
+			txn->done(txn);
+		}
+	}
+
+	if (!masked) {
+		IntMasterEnable();
+	}
+	return (NULL != txn);
+}
+
+/**
+ * @brief Starts the next transaction if the bus is free.
+ */
+void i2c_queue::kick(){
+
+	bool masked = IntMasterDisable();
+
+	/*
+	 * Busy with one of ours or a blocking call, or nothing to do
+	 */
+	if(active || bus_i2c_t::busy || (head == tail)){
+		if (!masked) {
+			IntMasterEnable();
+		}
+		return;
+	}
+
+	/*
+	 * The queue holds the bus until it is empty
+	 */
+	bus_i2c_t::busy 	= true;
+	active 				= queue[tail & (I2C_QUEUE_SIZE - 1)];
+	tail 				= tail + 1;
+	attempt 			= 0;
+	active->state 		= I2C_TXN_ACTIVE;
+	i2c_backend_start(active);
+
+	if (!masked) {
+		IntMasterEnable();
+	}
+}
+
+/**
+ * @brief Ends the transaction on the bus (backend, ISR context).
+ *
+ * A failed one is issued again, up to I2C_RETRIES times.
+ *
+ * @param 	ok				True if it completed
+ */
+void i2c_queue::complete(bool ok){
+
+	i2c_transaction_t* txn = active;
+	if(!txn){
+		return;
+	}
+	moves++;
+
+	/*
+	 * A glitch, issue it again while it holds the bus
+	 */
+	if(!ok && (attempt < I2C_RETRIES)){
+		attempt++;
+		stats.retried++;
+		i2c_backend_start(txn);
+		return;
+	}
+
+	if(ok){
+		stats.completed++;
+	}else{
+		stats.failed++;
+	}
+
+	/*
+	 * The callback may submit again
+	 */
+	active 		= NULL;
+	txn->state 	= ok ? I2C_TXN_DONE : I2C_TXN_FAILED;
+	if(txn->done){
+		txn->done(txn);
+	}
+
+	/*
+	 * Back to back, or the bus goes back to the other users
+	 */
+	if(head != tail){
+		bus_i2c_t::busy = false;
+		kick();
+	}else{
+		bus_i2c_t::release();
+	}
+}
+
+/**
+ * @brief Gets the queue statistics.
+ *
+ * @param 	copy			Where to copy the statistics
+ */
+void i2c_queue::get_stats(i2c_queue_stats_t* copy){
+
+	bool masked = IntMasterDisable();
+	*copy = stats;
+	if (!masked) {
+		IntMasterEnable();
+	}
+}
+
+#endif /* I2C_ASYNC */
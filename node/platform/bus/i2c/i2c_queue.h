@@ -0,0 +1,236 @@
+/*
+ * i2c_queue.h
+ */
+
+#ifndef PLATFORM_BUS_I2C_I2C_QUEUE_H_
+#define PLATFORM_BUS_I2C_I2C_QUEUE_H_
+
+#include <configs.h>
+#include <stdint.h>
+#include <status_codes.h>
+
+#ifdef I2C_ASYNC
+
+/*
+ * Interrupt driven I2C transactions.
+ *
+ * 	- default			: CC3200 I2C master interrupt (driverlib)
+ * 	- I2C_BACKEND_SIM	: simulated devices, runs the queue on Linux
+ */
+
+/**
+ * @brief Transaction direction
+ */
+typedef enum {
+
+	I2C_TXN_WRITE,					//!< Register index, then the bytes
+	I2C_TXN_READ					//!< Register index, repeated start, then the bytes
+}i2c_txn_dir_t;
+
+/**
+ * @brief Transaction state
+ */
+typedef enum {
+
+	I2C_TXN_IDLE,					//!< Not submitted
+	I2C_TXN_QUEUED,					//!< Waiting for the bus
+	I2C_TXN_ACTIVE,					//!< On the bus
+	I2C_TXN_DONE,					//!< Completed
+	I2C_TXN_FAILED					//!< Not acknowledged or bus error
+}i2c_txn_state_t;
+
+struct i2c_transaction;
+
+/**
+ * @brief Completion callback, interrupt context
+ */
+typedef void (*i2c_txn_done_t)(struct i2c_transaction* txn);
+
+/**
+ * @brief A transaction descriptor
+ *
+ * Owned by the submitter, it must stay alive until the completion.
+ * The data span is read into or written from in place.
+ */
+typedef struct i2c_transaction {
+
+	uint8_t					addr;		//!< Device address
+	uint8_t					index;		//!< Register index
+	uint8_t*				data;		//!< The span
+	uint8_t					size;		//!< The span size
+	i2c_txn_dir_t			dir;		//!< Direction
+	i2c_txn_done_t			done;		//!< Completion callback, NULL for none
+	void*					context;	//!< Submitter context
+	volatile i2c_txn_state_t state;		//!< Transaction state
+}i2c_transaction_t;
+
+/**
+ * @brief Queue statistics
+ */
+typedef struct {
+
+	uint32_t				completed;	//!< Transactions completed
+	uint32_t				failed;		//!< Transactions failed
+	uint32_t				retried;	//!< Transactions issued again
+	uint32_t				rejected;	//!< Submits on a full queue
+	uint8_t					high_water;	//!< Largest queue fill
+}i2c_queue_stats_t;
+
+/**
+ * @brief The I2C transaction queue
+ *
+ * Interrupt and task users submit transaction descriptors, the
+ * interrupt driven backend runs them back to back and calls their
+ * completion callbacks. The queue owns the bus while it has work,
+ * the blocking bus_i2c calls wait for it and hold it the other way
+ * around, so both kinds are serialised. The CPU is free during the
+ * transfers of the queued transactions.
+ */
+class i2c_queue {
+
+	/*
+	 * Public access methods
+	 */
+	public:
+
+		/**
+		 * @brief Starts the backend, once.
+		 */
+		static void start();
+
+		/**
+		 * @brief Queues a transaction (ISR safe).
+		 *
+		 * @param 	txn				The transaction
+		 * @return	status			ERR_BUFFER_OVERFLOW if the queue is full
+		 */
+		static status_code_t submit(i2c_transaction_t* txn);
+
+		/**
+		 * @brief Checks if a transaction has ended.
+		 *
+		 * @param 	txn				The transaction
+		 * @return	bool			True once done or failed
+		 */
+		static bool ended(const i2c_transaction_t* txn){
+			return ((I2C_TXN_DONE == txn->state) || (I2C_TXN_FAILED == txn->state));
+		}
+
+		/**
+		 * @brief Waits for a transaction (task context).
+		 *
+		 * A stalled queue is failed and the bus cleared after
+		 * I2C_TIMEOUT_MS, the wait then ends as well.
+		 *
+		 * @param 	txn				The transaction
+		 * @return	bool			True if it completed
+		 */
+		static bool wait(const i2c_transaction_t* txn);
+
+		/**
+		 * @brief Fails the transaction on the bus, the caller keeps the bus.
+		 *
+		 * For a stalled queue, the caller clears the bus next.
+		 *
+		 * @return	bool			True if a transaction was on the bus
+		 */
+		static bool abort();
+
+		/**
+		 * @brief Counts the transaction ends and retries (ISR safe).
+		 */
+		static uint32_t progress(){
+			return moves;
+		}
+
+		/**
+		 * @brief Starts the next transaction if the bus is free.
+		 */
+		static void kick();
+
+		/**
+		 * @brief Ends the transaction on the bus (backend, ISR context).
+		 *
+		 * A failed one is issued again, up to I2C_RETRIES times.
+		 *
+		 * @param 	ok				True if it completed
+		 */
+		static void complete(bool ok);
+
+		/**
+		 * @brief Gets the queue statistics.
+		 *
+		 * @param 	copy			Where to copy the statistics
+		 */
+		static void get_stats(i2c_queue_stats_t* copy);
+
+	/*
+	 * Private access methods
+	 */
+	private:
+
+		/*
+		 * Transaction queue (multiple producers, backend consumer)
+		 */
+		static i2c_transaction_t*		queue[I2C_QUEUE_SIZE];
+		static volatile uint8_t			head;
+		static volatile uint8_t			tail;
+		static i2c_transaction_t* volatile	active;
+		static uint8_t					attempt;
+		static volatile uint32_t		moves;
+		static bool						started;
+
+		/*
+		 * Statistics
+		 */
+		static i2c_queue_stats_t		stats;
+};
+
+/**< Typedef */
+typedef i2c_queue i2c_queue_t;
+
+/**
+ * @brief Initialises the backend.
+ */
+void i2c_backend_init();
+
+/**
+ * @brief Puts a transaction on the bus, it ends with i2c_queue::complete().
+ *
+ * @param 	txn				The transaction
+ */
+void i2c_backend_start(i2c_transaction_t* txn);
+
+/**
+ * @brief Masks the master interrupt, the bus goes back to Wire.
+ *
+ * Drops the transaction on the bus, if any.
+ */
+void i2c_backend_idle();
+
+#ifdef I2C_BACKEND_SIM
+/**
+ * @brief A simulated device, moves the span and returns the acknowledge.
+ */
+typedef bool (*i2c_sim_device_t)(i2c_transaction_t* txn);
+
+/**
+ * @brief Attaches the simulated devices, one handler for the bus.
+ *
+ * @param 	device			The handler, NULL to detach
+ */
+void i2c_sim_attach(i2c_sim_device_t device);
+
+/**
+ * @brief Stalls the simulated bus, as a lost completion interrupt.
+ *
+ * The transactions started meanwhile stay on the bus until
+ * i2c_queue::abort(), a late completion comes from the test.
+ *
+ * @param 	on				True to stall
+ */
+void i2c_sim_stall(bool on);
+#endif
+
+#endif /* I2C_ASYNC */
+#endif /* PLATFORM_BUS_I2C_I2C_QUEUE_H_ */
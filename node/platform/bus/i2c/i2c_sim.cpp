@@ -0,0 +1,65 @@
+/*
+ * i2c_sim.cpp
+ */
+
+#include <platform/bus/i2c/i2c_queue.h>
+
+#if defined(I2C_ASYNC) && defined(I2C_BACKEND_SIM)
+
+/*
+ * The simulated devices
+ */
+static i2c_sim_device_t		sim_device 	= NULL;
+static bool					sim_stalled = false;
+
+/**
+ * @brief Attaches the simulated devices, one handler for the bus.
+ *
+ * @param 	device			The handler, NULL to detach
+ */
+void i2c_sim_attach(i2c_sim_device_t device){
+	sim_device = device;
+}
+
+/**
+ * @brief Stalls the simulated bus, as a lost completion interrupt.
+ *
+ * @param 	on				True to stall
+ */
+void i2c_sim_stall(bool on){
+	sim_stalled = on;
+}
+
+/**
+ * @brief Initialises the backend.
+ */
+void i2c_backend_init(){
+}
+
+/**
+ * @brief Masks the master interrupt, the bus goes back to Wire.
+ *
+ * Drops the transaction on the bus, if any.
+ */
+void i2c_backend_idle(){
+}
+
+/**
+ * @brief Puts a transaction on the bus, it ends with i2c_queue::complete().
+ *
+ * The transfer takes no time, the completion comes from within
+ * the start as if the interrupt fired at once. Nothing attached
+ * is an empty bus, nobody acknowledges. A stalled bus never
+ * completes.
+ *
+ * @param 	txn				The transaction
+ */
+void i2c_backend_start(i2c_transaction_t* txn){
+
+	if(sim_stalled){
+		return;
+	}
+	i2c_queue::complete(sim_device ? sim_device(txn) : false);
+}
+
+#endif /* I2C_ASYNC && I2C_BACKEND_SIM */
@@ -0,0 +1,101 @@
+/*
+ * clock.cpp
+ */
+
+#include <platform/clock/clock.h>
+
+#include <inc/hw_memmap.h>
+#include <driverlib/prcm.h>
+#include <driverlib/timer.h>
+
+/*
+ * Statics
+ */
+volatile uint32_t 	sys_clock::high 	= 0;
+uint64_t 			sys_clock::offset 	= 0;
+bool 				sys_clock::started 	= false;
+
+/**
+ * @brief Starts the hardware timer.
+ *
+ * The clock continues from the current micros() value.
+ *
+ * @return	status			The status to return
+ */
+status_code_t sys_clock::start(){
+
+	/*
+	 * Once
+	 */
+	if(started){
+		return STATUS_OK;
+	}
+
+	/*
+	 * Continue from the fallback time
+	 */
+	offset = (uint64_t)micros() * CLOCK_TICKS_PER_US;
+	high = 0;
+
+	/*
+	 * 32 bit periodic timer counting down from the top
+	 */
+	PRCMPeripheralClkEnable(CLOCK_TIMER_PRCM, PRCM_RUN_MODE_CLK);
+	PRCMPeripheralReset(CLOCK_TIMER_PRCM);
+	TimerConfigure(CLOCK_TIMER_BASE, TIMER_CFG_PERIODIC);
+	TimerLoadSet(CLOCK_TIMER_BASE, TIMER_A, 0xFFFFFFFF);
+	TimerIntRegister(CLOCK_TIMER_BASE, TIMER_A, overflow_isr);
+	TimerIntEnable(CLOCK_TIMER_BASE, TIMER_TIMA_TIMEOUT);
+	TimerEnable(CLOCK_TIMER_BASE, TIMER_A);
+
+	started = true;
+	NOTIFY_INFO("Clock started.");
+	return STATUS_OK;
+}
+
+/**
+ * @brief Gets the monotonic time (ISR safe).
+ *
+ * @return	us				The time since boot in us
+ */
+clock_us_t sys_clock::now(){
+
+	/*
+	 * Fallback
+	 */
+	if(!started){
+		return (clock_us_t)micros();
+	}
+
+	/*
+	 * Read a consistent high/low pair
+	 */
+	uint32_t hi, lo;
+	do{
+		hi = high;
+		lo = TimerValueGet(CLOCK_TIMER_BASE, TIMER_A);
+	}while(hi != high);
+
+	/*
+	 * An overflow is pending (interrupts masked), the counter already
+	 * reloaded if it reads in the upper half.
+	 */
+	if((TimerIntStatus(CLOCK_TIMER_BASE, false) & TIMER_TIMA_TIMEOUT) &&
+			(lo & 0x80000000)){
+		hi++;
+	}
+
+	/*
+	 * Down counter to elapsed ticks
+	 */
+	uint64_t ticks = (((uint64_t)hi << 32) | (0xFFFFFFFF - lo)) + offset;
+	return (ticks / CLOCK_TICKS_PER_US);
+}
+
+/**
+ * @brief Timer overflow interrupt.
+ */
+void sys_clock::overflow_isr(){
+	TimerIntClear(CLOCK_TIMER_BASE, TIMER_TIMA_TIMEOUT);
+	high++;
+}
@@ -0,0 +1,108 @@
+/*
+ * clock.h
+ */
+
+#ifndef PLATFORM_CLOCK_CLOCK_H_
+#define PLATFORM_CLOCK_CLOCK_H_
+
+#include <configs.h>
+#include <status_codes.h>
+
+/**
+ * @brief Monotonic time in us
+ *
+ * 64 bits of us never wrap in the life of a node. Still compare
+ * with clock_before()/clock_reached() so the code does not care.
+ */
+typedef uint64_t clock_us_t;
+
+/**
+ * @brief Clock ticks per us
+ */
+#define CLOCK_TICKS_PER_US			(F_CPU / 1000000)
+
+/**
+ * @brief Converts ms to us
+ */
+#define CLOCK_MS(ms)				((clock_us_t)(ms) * 1000)
+
+/**
+ * @brief Returns true if time a is before time b (wrap safe).
+ */
+static inline bool clock_before(clock_us_t a, clock_us_t b){
+	return ((int64_t)(a - b) < 0);
+}
+
+/**
+ * @brief Returns true if the deadline is reached at now (wrap safe).
+ */
+static inline bool clock_reached(clock_us_t deadline, clock_us_t now){
+	return ((int64_t)(now - deadline) >= 0);
+}
+
+/**
+ * @brief The system clock interface
+ *
+ * A free running 32 bit hardware timer at the core clock, extended
+ * to 64 bits by counting its overflows. Before start() the clock
+ * falls back on micros() so static constructors see a sane time.
+ */
+class sys_clock {
+
+	/*
+	 * Public access methods
+	 */
+	public:
+
+		/**
+		 * @brief Starts the hardware timer.
+		 *
+		 * The clock continues from the current micros() value.
+		 *
+		 * @return	status			The status to return
+		 */
+		static status_code_t start();
+
+		/**
+		 * @brief Gets the monotonic time (ISR safe).
+		 *
+		 * @return	us				The time since boot in us
+		 */
+		static clock_us_t now();
+
+		/**
+		 * @brief Gets the monotonic time in ms.
+		 *
+		 * @return	ms				The time since boot in ms
+		 */
+		static uint64_t now_ms(){
+			return (now() / 1000);
+		}
+
+	/*
+	 * Private access methods
+	 */
+	private:
+
+		/**
+		 * @brief Timer overflow interrupt.
+		 */
+		static void overflow_isr();
+
+		/*
+		 * Upper 32 bits of the tick count
+		 */
+		static volatile uint32_t	high;
+
+		/*
+		 * Ticks at start, keeps the clock continuous with micros()
+		 */
+		static uint64_t				offset;
+
+		static bool					started;
+};
+
+/**< Typedef */
+typedef sys_clock sys_clock_t;
+
+#endif /* PLATFORM_CLOCK_CLOCK_H_ */
@@ -14,6 +14,12 @@
  */
 static queue<mqtt_message_t*>* mqtt_msg_qeue = new queue<mqtt_message_t*>();
 
+/**
+ * Receive led, turned off by mqtt::tick()
+ */
+static bool 	receive_led 	= false;
+static uint32_t receive_led_on;
+
 /**
  * @breif The Default callback for the MQTT engine.
  *
@@ -49,7 +55,8 @@ void __default_callback(char* topic, byte* payload, unsigned int length){
 	msg->topic 		= topic;
 
 	/*
-	 * Push the data on the queue
+	 * Push the data on the queue, mqtt::__process() frees it while
+	 * the payload is still in the client buffer
 	 */
 	mqtt_msg_qeue->push(msg);
 
@@ -57,13 +64,8 @@ void __default_callback(char* topic, byte* payload, unsigned int length){
 	 * Notify the USER
 	 */
 	digitalWrite(RECEIVE_LED, HIGH);
-	delay(MQTT_DELAY);
-	digitalWrite(RECEIVE_LED, LOW);
-
-	/*
-	 * Prevent memory leaks
-	 */
-	free(msg);
+	receive_led 	= true;
+	receive_led_on 	= millis();
 	return;
 }
 
@@ -99,6 +101,7 @@ mqtt::mqtt(Client* wifistack, mqtt_params_t* mqttparams){
 	 */
 	client_if 	= wifistack;
 	mqtt_params = mqttparams;
+	callbacks 	= NULL;
 
 	/*
 	 * Create a new PubSubClient
@@ -302,6 +305,20 @@ mqtt_status_t mqtt::run(){
 	}
 }
 
+/**
+ * @brief Services the receive led, never blocks.
+ */
+void mqtt::tick(){
+
+	/*
+	 * Turn the led off once it was on long enough
+	 */
+	if(receive_led && ((millis() - receive_led_on) >= MQTT_DELAY)){
+		digitalWrite(RECEIVE_LED, LOW);
+		receive_led = false;
+	}
+}
+
 /**
  * @brief Process a payload from the queue.
  */
@@ -310,7 +327,7 @@ mqtt_status_t mqtt::__process(){
 	/*
 	 * The status
 	 */
-	mqtt_status_t rc;
+	mqtt_status_t rc = MQTT_SUCCESS_STATUS;
 
 	/*
 	 * The read message from the queue
@@ -320,47 +337,48 @@ mqtt_status_t mqtt::__process(){
 	/*
 	 * Callback pointer
 	 */
-	mqtt_callback_entry_t* temp = callbacks;
+	mqtt_callback_entry_t* temp;
 
 	/*
 	 * Gets the data from the queue and processes it.
 	 */
-	if(!mqtt_msg_qeue->isEmpty()){
-
-		NOTIFY_INFO("There is a msg to process.");
+	while(mqtt_msg_qeue->count() > 0){
 
 		/*
-		 * Get the messages
+		 * Get the message and trigger the callback
 		 */
-		while(mqtt_msg_qeue->count() > 0){
+		msg = mqtt_msg_qeue->pop();
+		temp = callbacks;
+		while(temp != NULL){
 
 			/*
-			 * Get the message and trigger the callback
+			 * Check for a match
 			 */
-			msg = mqtt_msg_qeue->pop();
-			while(temp->next != NULL){
+			if(strcmp(temp->topic, msg->topic) == COMPARE_SUCCESS){
 
 				/*
-				 * Check for a match
+				 * We have a match... Now trigger the callback
 				 */
-				if(strcmp(temp->topic, msg->topic) == COMPARE_SUCCESS){
-
-					/*
-					 * We have a match... Now trigger the callback
-					 */
-					temp->callback(temp->context, msg->payload, msg->length);
-					return rc;
-				}
+				temp->callback(temp->context, msg->payload, msg->length);
+				break;
 			}
+			temp = temp->next;
+		}
 
-			/*
-			 * Not a valid command
-			 */
+		/*
+		 * Not a valid command
+		 */
+		if(temp == NULL){
 			NOTIFY_ERROR("Not a valid command: " + String(msg->topic));
 			rc = MQTT_FAILURE_STATUS;
-			return rc;
 		}
+
+		/*
+		 * Prevent memory leaks
+		 */
+		free(msg);
 	}
+	return rc;
 }
 
 /**
@@ -388,9 +406,17 @@ mqtt_status_t mqtt::__register_callback(mqtt_callback_entry_t* entry){
 	}
 
 	/*
-	 * Cycle to the end of the list
+	 * Cycle to the end of the list, a topic is only registered
+	 * once (the subscription is redone on every reconnect)
 	 */
-	while(tmp->next != NULL){
+	while(tmp != NULL){
+		if(strcmp(tmp->topic, entry->topic) == COMPARE_SUCCESS){
+			status = STATUS_OK;
+			return MQTT_SUCCESS_STATUS;
+		}
+		if(tmp->next == NULL){
+			break;
+		}
 		tmp = tmp->next;
 	}
 
@@ -398,14 +424,25 @@ mqtt_status_t mqtt::__register_callback(mqtt_callback_entry_t* entry){
 	 * Create a new entry struct to enter the list.
 	 * We are now at the end of the list.
 	 */
-	tmp->next = (mqtt_callback_entry_t*)malloc(sizeof(mqtt_callback_entry_t));
+	mqtt_callback_entry_t* node = (mqtt_callback_entry_t*)malloc(sizeof(mqtt_callback_entry_t));
+	if(!node){
+		status = STATUS_ERR_DENIED;
+		return MQTT_FAILURE_STATUS;
+	}
 
 	/*
 	 * Copy over the new entry
 	 */
-	memcpy(tmp->next, entry, sizeof(mqtt_callback_entry_t));
+	memcpy(node, entry, sizeof(mqtt_callback_entry_t));
+	node->next = NULL;
 
-	status = STATUS_ERR_DENIED;
+	if(tmp){
+		tmp->next = node;
+	}else{
+		callbacks = node;
+	}
+
+	status = STATUS_OK;
 	return MQTT_SUCCESS_STATUS;
 }
 
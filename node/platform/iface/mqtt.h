@@ -19,7 +19,7 @@
  * Maximum registered callbacks
  */
 #define MQTT_MAX_CALLBACKS			(255)
-#define MQTT_DELAY					(100) // Delay 1 sec
+#define MQTT_DELAY					(100) // Receive led on time (ms)
 
 /*
  * Local defines
@@ -216,6 +216,20 @@ class mqtt {
 		 */
 		mqtt_status_t run();
 
+		/**
+		 * @brief Services the receive led, never blocks.
+		 */
+		void tick();
+
+		/**
+		 * @brief Checks the broker connection.
+		 *
+		 * @return bool			True if connected
+		 */
+		bool connected(){
+			return iface->connected();
+		}
+
 	    /**
 	     * @brief Gets the internal status of the driver.
 	     *
@@ -66,9 +66,9 @@ wifi::wifi(wifi_attributes_t* settings){
 /**
  * @brief The Connect method for connecting to the wifi AP
  *
- * This method connects this node to a wifi AP based on the
- * SSID past and th epast password. We should return true or false
- * base don th esuccess of the connection.
+ * This method starts the association of this node to a wifi AP
+ * based on the SSID and the password. It does not wait for an ip,
+ * poll has_ip() for that.
  *
  * @param ssid		The SSID of the wifi AP
  * @param pass		The password of the wifi AP
@@ -82,27 +82,10 @@ wl_status_t wifi::connect(wifi_ssid_t ssid, wifi_pass_t pass){
 	PRINT("Connecting to wifi: ");
 	PRINTLN(ssid);
 
-	wifi_if->begin(ssid, pass);
-
-	/*
-	 * Wait for an IP
-	 */
-	while(wifi_if->localIP() == INADDR_NONE){
-		PRINT(".");
-		delay(300);
-	}
-
-	/*
-	 * We have an ip
-	 */
-	PRINTLN();
-	PRINT("Ip Address obtained: ");
-	PRINTLN(wifi_if->localIP());
-
 	/*
-	 * Return the status
+	 * Return the status, the ip comes later
 	 */
-	return wifi_if->WiFi_status;
+	return (wl_status_t)wifi_if->begin(ssid, pass);
 }
 
 /**
@@ -96,9 +96,9 @@ class wifi {
 		/**
 		 * @brief The Connect method for connecting to the wifi AP
 		 *
-		 * This method connects this node to a wifi AP based on the
-		 * SSID past and th epast password. We should return true or false
-		 * base don th esuccess of the connection.
+		 * This method starts the association of this node to a wifi AP
+		 * based on the SSID and the password. It does not wait for an ip,
+		 * poll has_ip() for that.
 		 *
 		 * @param ssid		The SSID of the wifi AP
 		 * @param pass		The password of the wifi AP
@@ -106,6 +106,15 @@ class wifi {
 		 */
 		wl_status_t connect(wifi_ssid_t ssid, wifi_pass_t pass);
 
+		/**
+		 * @brief Checks if an ip was obtained.
+		 *
+		 * @return bool		True if the node has an ip
+		 */
+		bool has_ip(){
+			return (wifi_if->localIP() != INADDR_NONE);
+		}
+
 		/**
 		 * @brief The Disconnection mechansim for the wifi conenction.
 		 *
@@ -0,0 +1,135 @@
+/*
+ * os.h
+ */
+
+#ifndef PLATFORM_OS_OS_H_
+#define PLATFORM_OS_OS_H_
+
+#include <configs.h>
+#include <status_codes.h>
+
+/*
+ * Thin threading layer used by the preemptive scheduler backend.
+ *
+ * 	- OS_BACKEND_POSIX	: pthreads, runs the task framework on Linux
+ * 	- default			: TI-RTOS (SYS/BIOS) as shipped with Energia MT
+ */
+#ifdef SCHEDULER_PREEMPTIVE
+
+#ifdef OS_BACKEND_POSIX
+#include <pthread.h>
+#else
+#include <xdc/std.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/gates/GateMutexPri.h>
+#endif
+
+/**
+ * @brief Wait without a timeout
+ */
+#define OS_WAIT_FOREVER				(0xFFFFFFFF)
+
+/**
+ * @brief Thread entry point
+ */
+typedef void (*os_thread_fxn_t)(void* arg);
+
+#ifdef OS_BACKEND_POSIX
+
+/**
+ * @brief Binary semaphore (signal)
+ */
+typedef struct {
+
+	pthread_mutex_t			mutex;
+	pthread_cond_t			cond;
+	bool					signaled;
+}os_sem_t;
+
+/**
+ * @brief Mutex with priority inheritance
+ */
+typedef pthread_mutex_t 	os_mutex_t;
+#else
+
+/**
+ * @brief Binary semaphore (signal)
+ */
+typedef Semaphore_Handle 	os_sem_t;
+
+/**
+ * @brief Mutex with priority inheritance
+ */
+typedef struct {
+
+	GateMutexPri_Handle		gate;
+	IArg					key;
+}os_mutex_t;
+#endif
+
+/**
+ * @brief Creates and starts a thread.
+ *
+ * @param 	fxn				The thread entry point
+ * @param 	arg				The argument, also the thread context
+ * @param 	priority		The priority, higher runs first
+ * @param 	stack			The stack size in bytes
+ * @return	status			The status to return
+ */
+status_code_t os_thread_create(os_thread_fxn_t fxn, void* arg, uint8_t priority, uint32_t stack);
+
+/**
+ * @brief Gets the context of the calling thread.
+ *
+ * @return	context			The thread argument, NULL outside the threads
+ */
+void* os_thread_context();
+
+/**
+ * @brief Initializes a semaphore, not signaled.
+ *
+ * @param 	sem				The semaphore
+ * @return	status			The status to return
+ */
+status_code_t os_sem_init(os_sem_t* sem);
+
+/**
+ * @brief Waits on a semaphore.
+ *
+ * @param 	sem				The semaphore
+ * @param 	timeout			The timeout in ms, OS_WAIT_FOREVER for none
+ * @return	bool			True if signaled, false on a timeout
+ */
+bool os_sem_wait(os_sem_t* sem, uint32_t timeout);
+
+/**
+ * @brief Signals a semaphore (ISR safe on TI-RTOS).
+ *
+ * @param 	sem				The semaphore
+ */
+void os_sem_post(os_sem_t* sem);
+
+/**
+ * @brief Initializes a mutex.
+ *
+ * @param 	mutex			The mutex
+ * @return	status			The status to return
+ */
+status_code_t os_mutex_init(os_mutex_t* mutex);
+
+/**
+ * @brief Locks a mutex.
+ *
+ * @param 	mutex			The mutex
+ */
+void os_mutex_lock(os_mutex_t* mutex);
+
+/**
+ * @brief Unlocks a mutex.
+ *
+ * @param 	mutex			The mutex
+ */
+void os_mutex_unlock(os_mutex_t* mutex);
+
+#endif /* SCHEDULER_PREEMPTIVE */
+#endif /* PLATFORM_OS_OS_H_ */
@@ -0,0 +1,241 @@
+/*
+ * os_posix.cpp
+ */
+
+#include <platform/os/os.h>
+
+#if defined(SCHEDULER_PREEMPTIVE) && defined(OS_BACKEND_POSIX)
+
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * The thread context key
+ */
+static pthread_key_t 	context_key;
+static pthread_once_t 	context_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Thread start arguments
+ */
+typedef struct {
+
+	os_thread_fxn_t			fxn;
+	void*					arg;
+}os_thread_start_t;
+
+/**
+ * @brief Creates the context key.
+ */
+static void os_context_init(){
+	pthread_key_create(&context_key, NULL);
+}
+
+/**
+ * @brief Thread trampoline
+ *
+ * @param 	start			The start arguments
+ */
+static void* os_thread_entry(void* start){
+
+	os_thread_start_t 	run = *(os_thread_start_t*)start;
+	free(start);
+
+	pthread_setspecific(context_key, run.arg);
+	run.fxn(run.arg);
+	return NULL;
+}
+
+/**
+ * @brief Creates and starts a thread.
+ *
+ * Real time priorities need the privilege, the thread falls
+ * back on the default policy without it.
+ *
+ * @param 	fxn				The thread entry point
+ * @param 	arg				The argument, also the thread context
+ * @param 	priority		The priority, higher runs first
+ * @param 	stack			The stack size in bytes
+ * @return	status			The status to return
+ */
+status_code_t os_thread_create(os_thread_fxn_t fxn, void* arg, uint8_t priority, uint32_t stack){
+
+	pthread_t 			thread;
+	pthread_attr_t 		attr;
+	struct sched_param 	param;
+	int 				rc;
+
+	pthread_once(&context_once, os_context_init);
+
+	os_thread_start_t* start = (os_thread_start_t*)malloc(sizeof(os_thread_start_t));
+	if (!start) {
+		return ERR_NO_MEMORY;
+	}
+	start->fxn = fxn;
+	start->arg = arg;
+
+	/*
+	 * Fixed priority, preemptive
+	 */
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+	param.sched_priority = sched_get_priority_min(SCHED_FIFO) + priority;
+	pthread_attr_setschedparam(&attr, &param);
+
+	/*
+	 * Host stacks are much larger than the target ones
+	 */
+	if (stack < PTHREAD_STACK_MIN) {
+		stack = PTHREAD_STACK_MIN;
+	}
+	pthread_attr_setstacksize(&attr, stack);
+
+	rc = pthread_create(&thread, &attr, os_thread_entry, start);
+	if (rc == EPERM) {
+		pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+		rc = pthread_create(&thread, &attr, os_thread_entry, start);
+	}
+	pthread_attr_destroy(&attr);
+
+	if (rc) {
+		free(start);
+		return ERR_NO_MEMORY;
+	}
+	return STATUS_OK;
+}
+
+/**
+ * @brief Gets the context of the calling thread.
+ *
+ * @return	context			The thread argument, NULL outside the threads
+ */
+void* os_thread_context(){
+
+	pthread_once(&context_once, os_context_init);
+	return pthread_getspecific(context_key);
+}
+
+/**
+ * @brief Initializes a semaphore, not signaled.
+ *
+ * @param 	sem				The semaphore
+ * @return	status			The status to return
+ */
+status_code_t os_sem_init(os_sem_t* sem){
+
+	pthread_condattr_t attr;
+
+	/*
+	 * Timeouts on the monotonic clock
+	 */
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+
+	if (pthread_mutex_init(&sem->mutex, NULL) ||
+			pthread_cond_init(&sem->cond, &attr)) {
+		pthread_condattr_destroy(&attr);
+		return ERR_NO_MEMORY;
+	}
+	pthread_condattr_destroy(&attr);
+
+	sem->signaled = false;
+	return STATUS_OK;
+}
+
+/**
+ * @brief Waits on a semaphore.
+ *
+ * @param 	sem				The semaphore
+ * @param 	timeout			The timeout in ms, OS_WAIT_FOREVER for none
+ * @return	bool			True if signaled, false on a timeout
+ */
+bool os_sem_wait(os_sem_t* sem, uint32_t timeout){
+
+	struct timespec deadline;
+	bool 			signaled;
+
+	/*
+	 * Absolute deadline
+	 */
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec 	+= timeout / 1000;
+	deadline.tv_nsec 	+= (long)(timeout % 1000) * 1000000L;
+	if (deadline.tv_nsec >= 1000000000L) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+
+	pthread_mutex_lock(&sem->mutex);
+	while (!sem->signaled) {
+		if (timeout == OS_WAIT_FOREVER) {
+			pthread_cond_wait(&sem->cond, &sem->mutex);
+		}else if (pthread_cond_timedwait(&sem->cond, &sem->mutex, &deadline) == ETIMEDOUT) {
+			break;
+		}
+	}
+	signaled 		= sem->signaled;
+	sem->signaled 	= false;
+	pthread_mutex_unlock(&sem->mutex);
+
+	return signaled;
+}
+
+/**
+ * @brief Signals a semaphore (ISR safe on TI-RTOS).
+ *
+ * @param 	sem				The semaphore
+ */
+void os_sem_post(os_sem_t* sem){
+
+	pthread_mutex_lock(&sem->mutex);
+	sem->signaled = true;
+	pthread_cond_signal(&sem->cond);
+	pthread_mutex_unlock(&sem->mutex);
+}
+
+/**
+ * @brief Initializes a mutex.
+ *
+ * @param 	mutex			The mutex
+ * @return	status			The status to return
+ */
+status_code_t os_mutex_init(os_mutex_t* mutex){
+
+	pthread_mutexattr_t attr;
+	int 				rc;
+
+	/*
+	 * Priority inheritance, the DAQ thread may wait on a low one
+	 */
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+	rc = pthread_mutex_init(mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+
+	return rc ? ERR_NO_MEMORY : STATUS_OK;
+}
+
+/**
+ * @brief Locks a mutex.
+ *
+ * @param 	mutex			The mutex
+ */
+void os_mutex_lock(os_mutex_t* mutex){
+	pthread_mutex_lock(mutex);
+}
+
+/**
+ * @brief Unlocks a mutex.
+ *
+ * @param 	mutex			The mutex
+ */
+void os_mutex_unlock(os_mutex_t* mutex){
+	pthread_mutex_unlock(mutex);
+}
+
+#endif
@@ -0,0 +1,148 @@
+/*
+ * os_tirtos.cpp
+ */
+
+#include <platform/os/os.h>
+
+#if defined(SCHEDULER_PREEMPTIVE) && !defined(OS_BACKEND_POSIX)
+
+#include <xdc/runtime/Error.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Clock.h>
+
+/**
+ * @brief Thread trampoline
+ *
+ * @param 	fxn				The thread entry point
+ * @param 	arg				The argument
+ */
+static void os_thread_entry(UArg fxn, UArg arg){
+	((os_thread_fxn_t)fxn)((void*)arg);
+}
+
+/**
+ * @brief Converts ms to clock ticks.
+ *
+ * @param 	ms				The time in ms
+ * @return	ticks			The time in ticks, BIOS_WAIT_FOREVER for ever
+ */
+static UInt32 os_ticks(uint32_t ms){
+
+	if (ms == OS_WAIT_FOREVER) {
+		return BIOS_WAIT_FOREVER;
+	}
+	return (UInt32)(((uint64_t)ms * 1000 + Clock_tickPeriod - 1) / Clock_tickPeriod);
+}
+
+/**
+ * @brief Creates and starts a thread.
+ *
+ * @param 	fxn				The thread entry point
+ * @param 	arg				The argument, also the thread context
+ * @param 	priority		The priority, higher runs first
+ * @param 	stack			The stack size in bytes
+ * @return	status			The status to return
+ */
+status_code_t os_thread_create(os_thread_fxn_t fxn, void* arg, uint8_t priority, uint32_t stack){
+
+	Task_Params params;
+	Error_Block eb;
+
+	Error_init(&eb);
+	Task_Params_init(&params);
+	params.arg0 		= (UArg)fxn;
+	params.arg1 		= (UArg)arg;
+	params.env 			= arg;
+	params.priority 	= priority;
+	params.stackSize 	= stack;
+
+	if (Task_create(os_thread_entry, &params, &eb) == NULL) {
+		return ERR_NO_MEMORY;
+	}
+	return STATUS_OK;
+}
+
+/**
+ * @brief Gets the context of the calling thread.
+ *
+ * @return	context			The thread argument, NULL outside the threads
+ */
+void* os_thread_context(){
+	return Task_getEnv(Task_self());
+}
+
+/**
+ * @brief Initializes a semaphore, not signaled.
+ *
+ * @param 	sem				The semaphore
+ * @return	status			The status to return
+ */
+status_code_t os_sem_init(os_sem_t* sem){
+
+	Semaphore_Params params;
+
+	Semaphore_Params_init(&params);
+	params.mode = Semaphore_Mode_BINARY;
+
+	*sem = Semaphore_create(0, &params, NULL);
+	return (*sem) ? STATUS_OK : ERR_NO_MEMORY;
+}
+
+/**
+ * @brief Waits on a semaphore.
+ *
+ * @param 	sem				The semaphore
+ * @param 	timeout			The timeout in ms, OS_WAIT_FOREVER for none
+ * @return	bool			True if signaled, false on a timeout
+ */
+bool os_sem_wait(os_sem_t* sem, uint32_t timeout){
+	return Semaphore_pend(*sem, os_ticks(timeout));
+}
+
+/**
+ * @brief Signals a semaphore (ISR safe on TI-RTOS).
+ *
+ * @param 	sem				The semaphore
+ */
+void os_sem_post(os_sem_t* sem){
+	Semaphore_post(*sem);
+}
+
+/**
+ * @brief Initializes a mutex.
+ *
+ * @param 	mutex			The mutex
+ * @return	status			The status to return
+ */
+status_code_t os_mutex_init(os_mutex_t* mutex){
+
+	mutex->gate = GateMutexPri_create(NULL, NULL);
+	mutex->key 	= 0;
+	return (mutex->gate) ? STATUS_OK : ERR_NO_MEMORY;
+}
+
+/**
+ * @brief Locks a mutex.
+ *
+ * @param 	mutex			The mutex
+ */
+void os_mutex_lock(os_mutex_t* mutex){
+
+	/*
+	 * Only the owner touches the key
+	 */
+	IArg key 	= GateMutexPri_enter(mutex->gate);
+	mutex->key 	= key;
+}
+
+/**
+ * @brief Unlocks a mutex.
+ *
+ * @param 	mutex			The mutex
+ */
+void os_mutex_unlock(os_mutex_t* mutex){
+	GateMutexPri_leave(mutex->gate, mutex->key);
+}
+
+#endif
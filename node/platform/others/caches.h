@@ -36,7 +36,7 @@ typedef struct {
 	struct {
 		uint8_t 				status;
 		bool 					alive;
-		uint32_t 				runtime;
+		uint32_t 				runtime;		// Uptime in s
 		uint8_t 				version;
 		uint8_t					id;
 	}device_data;
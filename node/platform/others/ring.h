@@ -0,0 +1,135 @@
+/*
+ * ring.h
+ */
+
+#ifndef PLATFORM_OTHERS_RING_H_
+#define PLATFORM_OTHERS_RING_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Lock free single producer, single consumer ring
+ *
+ * The producer (an ISR) only moves the head, the consumer (a task)
+ * only moves the tail, so neither side masks interrupts. A slot is
+ * published by the head store after it is written. A full ring keeps
+ * its oldest items and counts the overflow, the high water mark tells
+ * how much of the ring was ever used, to size it.
+ *
+ * @param T		The item type
+ * @param N		The number of slots, a power of 2 up to 32768
+ */
+template<class T, uint16_t N>
+class ring {
+
+	/*
+	 * Public access methods
+	 */
+	public:
+
+		ring(){
+			head 		= 0;
+			tail 		= 0;
+			overflows 	= 0;
+			high_water 	= 0;
+		}
+
+		/**
+		 * @brief Adds an item (producer side).
+		 *
+		 * @param 	item			The item to copy in
+		 * @return	bool			False if the ring is full
+		 */
+		bool push(const T& item){
+
+			uint16_t fill = (uint16_t)(head - tail);
+			if(fill >= N){
+				overflows++;
+				return false;
+			}
+
+			slots[head & (N - 1)] = item;
+			__sync_synchronize();
+			head = head + 1;
+
+			if(fill + 1 > high_water){
+				high_water = fill + 1;
+			}
+			return true;
+		}
+
+		/**
+		 * @brief Takes the oldest items out (consumer side).
+		 *
+		 * @param 	items			Where to copy the items
+		 * @param 	max				The room in items
+		 * @return	count			The items copied
+		 */
+		uint16_t read(T* items, uint16_t max){
+
+			uint16_t count = 0;
+			uint16_t last = head;
+			__sync_synchronize();
+
+			while((count < max) && (tail != last)){
+				items[count++] = slots[tail & (N - 1)];
+				tail = tail + 1;
+			}
+			return count;
+		}
+
+		/**
+		 * @brief Drops every item (consumer side).
+		 */
+		void flush(){
+			tail = head;
+		}
+
+		/**
+		 * @brief Gets the number of items waiting.
+		 */
+		uint16_t pending() const {
+			return (uint16_t)(head - tail);
+		}
+
+		/**
+		 * @brief Gets the items lost on a full ring.
+		 */
+		uint32_t get_overflows() const {
+			return overflows;
+		}
+
+		/**
+		 * @brief Gets the largest fill seen.
+		 */
+		uint16_t get_high_water() const {
+			return high_water;
+		}
+
+		/**
+		 * @brief Restarts the overflow and high water counts (producer
+		 * side, or with the producer masked).
+		 */
+		void clear_stats(){
+			overflows 	= 0;
+			high_water 	= 0;
+		}
+
+	/*
+	 * Private access methods
+	 */
+	private:
+
+		/*
+		 * A power of 2 keeps the free running indexes aligned on wrap
+		 */
+		typedef char size_check[((N & (N - 1)) == 0 && N <= 32768) ? 1 : -1];
+
+		T						slots[N];
+		volatile uint16_t		head;
+		volatile uint16_t		tail;
+		volatile uint32_t		overflows;
+		volatile uint16_t		high_water;
+};
+
+#endif /* PLATFORM_OTHERS_RING_H_ */
@@ -15,6 +15,7 @@
 #define INCLUDE_TMP006
 
 // #define BMA222_IRQ // Attach interrupt
+#define BMA222_BURST // Acc, temp and status in one transaction
 
 /*
  * Platform includes:
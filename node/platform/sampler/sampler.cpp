@@ -0,0 +1,452 @@
+/*
+ * sampler.cpp
+ */
+
+#include <platform/sampler/sampler.h>
+
+#ifdef SENSOR_SAMPLER
+
+#include <inc/hw_memmap.h>
+#include <inc/hw_ints.h>
+#include <driverlib/prcm.h>
+#include <driverlib/timer.h>
+#include <driverlib/interrupt.h>
+#include <platform/bus/i2c/bus_i2c.h>
+
+/*
+ * Sample ring, read batch
+ */
+ring<sensor_sample_t, SAMPLER_BUFFER_SIZE>	sampler::buffer;
+sensor_sample_t			sampler::frames[SAMPLER_FRAMES_MAX];
+clock_us_t				sampler::previous 		= 0;
+uint8_t					sampler::batch 			= 1;
+
+/*
+ * Block consumers
+ */
+sampler_sink_t			sampler::sinks[SAMPLER_SINKS_MAX];
+void*					sampler::sink_contexts[SAMPLER_SINKS_MAX];
+uint8_t					sampler::sink_count 	= 0;
+
+/*
+ * Target and timing
+ */
+sensor_t*				sampler::target 		= NULL;
+volatile bool			sampler::running 		= false;
+uint32_t				sampler::load 			= 0;
+uint32_t				sampler::period 		= 0;
+
+/*
+ * A trigger waiting for the bus
+ */
+volatile bool			sampler::waiting 		= false;
+clock_us_t				sampler::waiting_tick 	= 0;
+void					(*sampler::pending_notify)() = NULL;
+
+/*
+ * Statistics
+ */
+sampler_stats_t			sampler::stats;
+uint64_t				sampler::late_total 	= 0;
+uint32_t				sampler::overruns_base 	= 0;
+
+/**
+ * @brief Starts sampling a sensor.
+ *
+ * @param 	sensor			The sensor, it must support sample()
+ * @param 	rate			The sampling rate, or output data rate (Hz)
+ * @return	status			ERR_UNSUPPORTED_DEV if the sensor cannot be sampled
+ */
+status_code_t sampler::start(sensor_t* sensor, uint32_t rate){
+
+	/*
+	 * Once, one sensor
+	 */
+	if(running){
+		return ERR_TIMER_ALREADY_RUNNING;
+	}
+
+	if(!sensor || !rate || (rate > SAMPLER_RATE_MAX_HZ)){
+		return ERR_INVALID_ARG;
+	}
+
+	target 		= sensor;
+	load 		= (F_CPU / rate) - 1;
+	period 		= 1000000 / rate;
+	waiting 	= false;
+	previous 	= sys_clock::now();
+	batch 		= 1;
+	buffer.flush();
+	clear_stats();
+
+	/*
+	 * Catch up the triggers that found a task transaction on the bus
+	 */
+	bus_i2c_t::on_release = bus_released;
+
+#ifdef SAMPLER_DATA_READY
+	/*
+	 * The sensor paces the reads, in batches from its FIFO when
+	 * it has one, else on each new sample
+	 */
+	sensor_t::ready_notify = ready_isr;
+	running = true;
+#ifdef SAMPLER_FIFO
+	if(sensor->sampling(rate, SENSOR_TRIGGER_FIFO, SAMPLER_FIFO_WATERMARK)){
+		batch = SAMPLER_FIFO_WATERMARK;
+	}
+#endif
+	if((1 == batch) && !sensor->sampling(rate, SENSOR_TRIGGER_DATA_READY, 1)){
+		stop();
+		return ERR_UNSUPPORTED_DEV;
+	}
+
+	/*
+	 * The samples come at the sensor output data rate
+	 */
+	if(sensor->hal.sample_rate > 0){
+		period = 1000000 / sensor->hal.sample_rate;
+	}
+#else
+	/*
+	 * Awake, filtered for the rate
+	 */
+	if(!sensor->sampling(rate, SENSOR_TRIGGER_TIMER, 1)){
+		target = NULL;
+		bus_i2c_t::on_release = NULL;
+		return ERR_UNSUPPORTED_DEV;
+	}
+
+	/*
+	 * Periodic timer above the other interrupts, the counter
+	 * reloads at each tick so it gives the interrupt latency
+	 */
+	PRCMPeripheralClkEnable(SAMPLER_TIMER_PRCM, PRCM_RUN_MODE_CLK);
+	PRCMPeripheralReset(SAMPLER_TIMER_PRCM);
+	TimerConfigure(SAMPLER_TIMER_BASE, TIMER_CFG_PERIODIC);
+	TimerLoadSet(SAMPLER_TIMER_BASE, TIMER_A, load);
+	TimerIntRegister(SAMPLER_TIMER_BASE, TIMER_A, tick_isr);
+	IntPrioritySet(SAMPLER_TIMER_INT, SAMPLER_TIMER_PRIORITY);
+	TimerIntEnable(SAMPLER_TIMER_BASE, TIMER_TIMA_TIMEOUT);
+
+	running = true;
+	TimerEnable(SAMPLER_TIMER_BASE, TIMER_A);
+#endif
+
+	NOTIFY_INFO("Sampler started.");
+	return STATUS_OK;
+}
+
+/**
+ * @brief Stops the trigger and releases the sensor.
+ */
+void sampler::stop(){
+
+	if(!running){
+		return;
+	}
+
+#ifdef SAMPLER_DATA_READY
+	sensor_t::ready_notify = NULL;
+#else
+	TimerDisable(SAMPLER_TIMER_BASE, TIMER_A);
+	TimerIntDisable(SAMPLER_TIMER_BASE, TIMER_TIMA_TIMEOUT);
+	TimerIntUnregister(SAMPLER_TIMER_BASE, TIMER_A);
+#endif
+	bus_i2c_t::on_release = NULL;
+
+	running = false;
+	waiting = false;
+
+	/*
+	 * Back to the DAQ reads
+	 */
+	target->sampling(0, SENSOR_TRIGGER_TIMER, 0);
+	target = NULL;
+}
+
+/**
+ * @brief Restarts a stalled data ready trigger.
+ */
+void sampler::poll(){
+
+	if(!running){
+		return;
+	}
+
+	/*
+	 * A deferred trigger, without the BIOS loop to serve it
+	 */
+	service();
+
+#ifdef SAMPLER_DATA_READY
+	if(waiting){
+		return;
+	}
+
+	/*
+	 * Nothing for two batches, the interrupt line is stuck up
+	 */
+	clock_us_t now = sys_clock::now();
+	if((uint32_t)(now - previous) < (2 * batch * period)){
+		return;
+	}
+
+	bool masked = IntMasterDisable();
+	if(!waiting){
+		waiting_tick 	= now;
+		waiting 		= true;
+	}
+	if (!masked) {
+		IntMasterEnable();
+	}
+	service();
+#endif
+}
+
+/**
+ * @brief Reads a deferred trigger (task context).
+ *
+ * Holds the bus for the read, with the interrupts enabled, so
+ * a trigger meanwhile defers in turn. Run by the BIOS loop on
+ * pending_notify, and by poll().
+ */
+void sampler::service(){
+
+	if(!running || !waiting){
+		return;
+	}
+
+	/*
+	 * Claim the trigger and the bus together
+	 */
+	bool masked = IntMasterDisable();
+	bool claimed = running && waiting && !bus_i2c_t::busy;
+	clock_us_t tick = waiting_tick;
+	if(claimed){
+		waiting 		= false;
+		bus_i2c_t::busy = true;
+	}
+	if (!masked) {
+		IntMasterEnable();
+	}
+
+	if(!claimed){
+		return;
+	}
+
+	/*
+	 * The release reschedules a trigger deferred meanwhile
+	 */
+	capture(tick);
+	bus_i2c_t::release();
+}
+
+/**
+ * @brief Takes the oldest samples out and hands them to every sink.
+ *
+ * Single consumer, task context. With no sink the samples are
+ * counted as unclaimed.
+ *
+ * @param 	samples			Where to copy the samples
+ * @param 	max				The room in samples
+ * @return	count			The samples copied
+ */
+uint16_t sampler::drain(sensor_sample_t* samples, uint16_t max){
+
+	uint16_t count = buffer.read(samples, max);
+	if(!count){
+		return 0;
+	}
+
+	/*
+	 * Tee the block, the caller keeps its copy
+	 */
+	for(uint8_t i = 0; i < sink_count; i++){
+		sinks[i](sink_contexts[i], samples, count);
+	}
+	if(!sink_count){
+		stats.unclaimed += count;
+	}
+	return count;
+}
+
+/**
+ * @brief Registers a block consumer.
+ *
+ * @param 	sink			The consumer
+ * @param 	context			The context passed to the consumer
+ * @return	status			ERR_NO_MEMORY if there is no room
+ */
+status_code_t sampler::add_sink(sampler_sink_t sink, void* context){
+
+	/*
+	 * Sanity check
+	 */
+	if(!sink){
+		return ERR_INVALID_ARG;
+	}
+
+	/*
+	 * No more room
+	 */
+	if(sink_count >= SAMPLER_SINKS_MAX){
+		return ERR_NO_MEMORY;
+	}
+
+	sink_contexts[sink_count] 	= context;
+	sinks[sink_count++] 		= sink;
+	return STATUS_OK;
+}
+
+/**
+ * @brief Gets the sampling statistics.
+ *
+ * @param 	copy			Where to copy the statistics
+ */
+void sampler::get_stats(sampler_stats_t* copy){
+
+	bool masked = IntMasterDisable();
+	*copy = stats;
+	copy->late_mean 	= stats.reads ? (uint32_t)(late_total / stats.reads) : 0;
+	copy->overruns 		= target ? (target->get_overruns() - overruns_base) : 0;
+	copy->dropped 		= buffer.get_overflows();
+	copy->high_water 	= buffer.get_high_water();
+	if (!masked) {
+		IntMasterEnable();
+	}
+}
+
+/**
+ * @brief Restarts the statistics window.
+ */
+void sampler::clear_stats(){
+
+	bool masked = IntMasterDisable();
+	memset(&stats, 0, sizeof(stats));
+	late_total = 0;
+	overruns_base = target ? target->get_overruns() : 0;
+	buffer.clear_stats();
+	if (!masked) {
+		IntMasterEnable();
+	}
+}
+
+/**
+ * @brief Timer tick interrupt.
+ */
+void sampler::tick_isr(){
+
+	/*
+	 * Counter ticks since the reload, i.e. since the tick
+	 */
+	uint32_t elapsed = load - TimerValueGet(SAMPLER_TIMER_BASE, TIMER_A);
+	TimerIntClear(SAMPLER_TIMER_BASE, TIMER_TIMA_TIMEOUT);
+	trigger(sys_clock::now() - (elapsed / CLOCK_TICKS_PER_US));
+}
+
+/**
+ * @brief Data ready interrupt.
+ *
+ * @param 	sensor			The sensor with a new sample
+ */
+void sampler::ready_isr(sensor_t* sensor){
+
+	if(running && (sensor == target)){
+		trigger(sys_clock::now());
+	}
+}
+
+/**
+ * @brief Reads a trigger, or defers it while the bus is taken.
+ *
+ * @param 	tick			When the trigger fired
+ */
+void sampler::trigger(clock_us_t tick){
+
+	/*
+	 * A task transaction holds the bus, read when it releases it
+	 */
+	if(bus_i2c_t::is_busy()){
+		if(waiting){
+			stats.missed++;
+		}else{
+			waiting_tick = tick;
+			waiting = true;
+			stats.deferred++;
+		}
+		return;
+	}
+
+	/*
+	 * Released between its end and the hook
+	 */
+	if(waiting){
+		waiting = false;
+		capture(waiting_tick);
+	}
+	capture(tick);
+}
+
+/**
+ * @brief Schedules a deferred tick once the bus is released.
+ *
+ * May run in the I2C completion interrupt, so no bus I/O here.
+ */
+void sampler::bus_released(){
+
+	if(waiting && pending_notify){
+		pending_notify();
+	}
+}
+
+/**
+ * @brief Reads and stores a sample or a batch, the bus held.
+ *
+ * From the trigger interrupt while the bus is free, or from
+ * service() which holds it.
+ *
+ * The samples of a batch were made evenly between the previous read
+ * and this one, the newest at the read time.
+ *
+ * @param 	tick			When the trigger fired
+ */
+void sampler::capture(clock_us_t tick){
+
+	clock_us_t at = sys_clock::now();
+
+	uint16_t count = target->sample(frames, SAMPLER_FRAMES_MAX);
+	if(!count){
+		stats.errors++;
+		return;
+	}
+
+	uint32_t late 		= (uint32_t)(at - tick);
+	uint32_t spacing 	= stats.reads ? ((uint32_t)(at - previous) / count) : period;
+
+	/*
+	 * Jitter, the lateness and the spacing of the samples
+	 */
+	uint32_t error = (spacing > period) ? (spacing - period) : (period - spacing);
+	if(error > stats.spacing_max){
+		stats.spacing_max = error;
+	}
+	if(late > stats.late_max){
+		stats.late_max = late;
+	}
+	late_total += late;
+	stats.samples += count;
+	stats.reads++;
+	previous = at;
+
+	/*
+	 * Keeps the oldest on a full ring, the DAQ is behind
+	 */
+	for(uint16_t i = 0; i < count; i++){
+		frames[i].timestamp 	= at - (clock_us_t)(count - 1 - i) * spacing;
+		frames[i].late 			= (late > 0xFFFF) ? 0xFFFF : late;
+		buffer.push(frames[i]);
+	}
+}
+
+#endif /* SENSOR_SAMPLER */
@@ -0,0 +1,251 @@
+/*
+ * sampler.h
+ */
+
+#ifndef PLATFORM_SAMPLER_SAMPLER_H_
+#define PLATFORM_SAMPLER_SAMPLER_H_
+
+#include <configs.h>
+#include <status_codes.h>
+#include <platform/clock/clock.h>
+#include <platform/sensor/sensor/sensor.h>
+#include <platform/others/ring.h>
+
+#ifdef SENSOR_SAMPLER
+
+/**
+ * @brief Sampling statistics
+ *
+ * The lateness is the read time past the trigger (interrupt
+ * latency, deferred reads), the spacing error is the distance
+ * between two reads against the period. Both in us. The high
+ * water mark and the dropped samples size the ring. A read
+ * brings a batch of samples out of a sensor FIFO.
+ */
+typedef struct {
+
+	uint32_t				samples;		//!< Samples read
+	uint32_t				reads;			//!< Sensor reads (batches)
+	uint32_t				overruns;		//!< Samples lost in the sensor FIFO
+	uint32_t				dropped;		//!< Samples lost on a full ring
+	uint32_t				deferred;		//!< Ticks read after a task transaction
+	uint32_t				missed;			//!< Ticks lost behind a deferred one
+	uint32_t				errors;			//!< Failed reads
+	uint32_t				late_max;		//!< Worst lateness
+	uint32_t				late_mean;		//!< Mean lateness
+	uint32_t				spacing_max;	//!< Worst spacing error (jitter)
+	uint32_t				unclaimed;		//!< Samples drained with no sink
+	uint16_t				high_water;		//!< Largest ring fill
+}sampler_stats_t;
+
+/**
+ * @brief Block consumer, gets every sample drained (task context)
+ *
+ * @param 	context			The context given to add_sink()
+ * @param 	samples			The samples, oldest first
+ * @param 	count			The number of samples
+ */
+typedef void (*sampler_sink_t)(void* context, const sensor_sample_t* samples, uint16_t count);
+
+/**
+ * @brief The interrupt driven sampler
+ *
+ * A trigger interrupt reads one sensor into a preallocated lock free
+ * ring, away from the cooperative tasks, and the DAQ task drains it
+ * in blocks, each block teed to the sinks. The trigger is a periodic hardware timer, whose counter
+ * tells how late the ISR runs, or the sensor data ready interrupt
+ * (SAMPLER_DATA_READY), which captures every sample the chip makes.
+ * With SAMPLER_FIFO, a chip with a FIFO batches the samples and
+ * interrupts once per watermark, the batch is spread back over the
+ * read interval. Each sample carries its read time and lateness. A trigger
+ * that finds a task transaction on the bus is read after that
+ * transaction, in task context (service()) with the interrupts on.
+ */
+class sampler {
+
+	/*
+	 * Public access methods
+	 */
+	public:
+
+		/**
+		 * @brief Starts sampling a sensor.
+		 *
+		 * @param 	sensor			The sensor, it must support sample()
+		 * @param 	rate			The sampling rate, or output data rate (Hz)
+		 * @return	status			ERR_UNSUPPORTED_DEV if the sensor cannot be sampled
+		 */
+		static status_code_t start(sensor_t* sensor, uint32_t rate);
+
+		/**
+		 * @brief Stops the timer and releases the sensor.
+		 */
+		static void stop();
+
+		/**
+		 * @brief Checks if a sensor is sampled by the timer.
+		 *
+		 * @param 	sensor			The sensor
+		 * @return	bool			True if its reads belong to the sampler
+		 */
+		static bool owns(sensor_t* sensor){
+			return (running && (target == sensor));
+		}
+
+		/**
+		 * @brief Takes the oldest samples out of the ring.
+		 *
+		 * Single consumer, task context.
+		 *
+		 * @param 	samples			Where to copy the samples
+		 * @param 	max				The room in samples
+		 * @return	count			The samples copied
+		 */
+		static uint16_t read(sensor_sample_t* samples, uint16_t max){
+			return buffer.read(samples, max);
+		}
+
+		/**
+		 * @brief Takes the oldest samples out and hands them to every sink.
+		 *
+		 * Single consumer, task context. With no sink the samples are
+		 * counted as unclaimed.
+		 *
+		 * @param 	samples			Where to copy the samples
+		 * @param 	max				The room in samples
+		 * @return	count			The samples copied
+		 */
+		static uint16_t drain(sensor_sample_t* samples, uint16_t max);
+
+		/**
+		 * @brief Registers a block consumer.
+		 *
+		 * @param 	sink			The consumer
+		 * @param 	context			The context passed to the consumer
+		 * @return	status			ERR_NO_MEMORY if there is no room
+		 */
+		static status_code_t add_sink(sampler_sink_t sink, void* context);
+
+		/**
+		 * @brief Gets the number of samples in the ring.
+		 *
+		 * @return	count			The samples waiting
+		 */
+		static uint16_t pending(){
+			return buffer.pending();
+		}
+
+		/**
+		 * @brief Restarts a stalled data ready trigger.
+		 *
+		 * An edge lost on a failed read leaves the sensor interrupt
+		 * up. Called by the DAQ task, it reads again once nothing
+		 * came for two batches.
+		 */
+		static void poll();
+
+		/**
+		 * @brief Reads a deferred trigger (task context).
+		 *
+		 * Holds the bus for the read, with the interrupts enabled, so
+		 * a trigger meanwhile defers in turn. Run by the BIOS loop on
+		 * pending_notify, and by poll().
+		 */
+		static void service();
+
+		/*
+		 * Called when a deferred trigger waits for service() (ISR safe).
+		 * NULL for none, the DAQ task polls then.
+		 */
+		static void (*pending_notify)();
+
+		/**
+		 * @brief Gets the sampling statistics.
+		 *
+		 * @param 	copy			Where to copy the statistics
+		 */
+		static void get_stats(sampler_stats_t* copy);
+
+		/**
+		 * @brief Restarts the statistics window.
+		 */
+		static void clear_stats();
+
+	/*
+	 * Private access methods
+	 */
+	private:
+
+		/**
+		 * @brief Timer tick interrupt.
+		 */
+		static void tick_isr();
+
+		/**
+		 * @brief Data ready interrupt.
+		 *
+		 * @param 	sensor			The sensor with a new sample
+		 */
+		static void ready_isr(sensor_t* sensor);
+
+		/**
+		 * @brief Reads a trigger, or defers it while the bus is taken.
+		 *
+		 * @param 	tick			When the trigger fired
+		 */
+		static void trigger(clock_us_t tick);
+
+		/**
+		 * @brief Schedules a deferred tick once the bus is released.
+		 */
+		static void bus_released();
+
+		/**
+		 * @brief Reads and stores a sample or a batch, the bus held.
+		 *
+		 * @param 	tick			When the trigger fired
+		 */
+		static void capture(clock_us_t tick);
+
+		/*
+		 * Sample ring (trigger producer, DAQ consumer), read batch
+		 */
+		static ring<sensor_sample_t, SAMPLER_BUFFER_SIZE>	buffer;
+		static sensor_sample_t			frames[SAMPLER_FRAMES_MAX];
+
+		/*
+		 * Block consumers
+		 */
+		static sampler_sink_t			sinks[SAMPLER_SINKS_MAX];
+		static void*					sink_contexts[SAMPLER_SINKS_MAX];
+		static uint8_t					sink_count;
+		static clock_us_t				previous;
+		static uint8_t					batch;
+
+		/*
+		 * Target and timing
+		 */
+		static sensor_t*				target;
+		static volatile bool			running;
+		static uint32_t					load;
+		static uint32_t					period;
+
+		/*
+		 * A trigger waiting for the bus
+		 */
+		static volatile bool			waiting;
+		static clock_us_t				waiting_tick;
+
+		/*
+		 * Statistics
+		 */
+		static sampler_stats_t			stats;
+		static uint64_t					late_total;
+		static uint32_t					overruns_base;
+};
+
+/**< Typedef */
+typedef sampler sampler_t;
+
+#endif /* SENSOR_SAMPLER */
+#endif /* PLATFORM_SAMPLER_SAMPLER_H_ */
@@ -7,6 +7,11 @@
 
 #include <platform/sensor/drivers/bosch/bma222.h>
 
+/*
+ * The device behind the interrupt pin
+ */
+bma222* bma222::irq_owner = NULL;
+
 sensor_map_t ranges[4] = {
 		{{ 2000}, BMA222_RANGE_2G		},
 		{{ 4000}, BMA222_RANGE_4G		},
@@ -37,6 +42,15 @@ bma222::bma222(bus_i2c_t* iface) : sensor_i2c(iface, BMA222_TRANSACTION_BYTE) {
 	for(int i = 0; i < BMA222_CALLBACKS; i++){
 		bma222::callbacks[i].handler = default_event_handler;
 	}
+	ready_irq = false;
+	event_irq = false;
+	fifo = false;
+
+	/*
+	 * Configuration registers, cached once known
+	 */
+	shadow_init(BMA222_I2C_ADDR, BMA222_SHADOW_FIRST, BMA222_SHADOW_COUNT,
+			BMA222_SHADOW_UNCACHED, true);
 
 	/*
 	 * Get the device id
@@ -53,7 +67,7 @@ bma222::bma222(bus_i2c_t* iface) : sensor_i2c(iface, BMA222_TRANSACTION_BYTE) {
 	/*
 	 * Check for validity
 	 */
-	if (BMA222_ID_VAL == id.dev_id) {
+	if ((BMA222_ID_VAL == id.dev_id) || (BMA222E_ID_VAL == id.dev_id)) {
 
 		/*
 		 * Set the driver function table and capabilities pointer.
@@ -74,6 +88,12 @@ bma222::bma222(bus_i2c_t* iface) : sensor_i2c(iface, BMA222_TRANSACTION_BYTE) {
 		caps.units				= 	SENSOR_UNITS_deg_Celcius;
 		caps.scale				= 	SENSOR_SCALE_one;
 		caps.name				= 	"BMA222 Digital, triaxial acceleration sensor";
+		caps.bus_speed			= 	I2C_SPEED_FAST;
+
+		/*
+		 * No faster than the device on a shared bus
+		 */
+		bus->limit_speed(caps.bus_speed);
 
 		/*
 		 * Set the driver (device) default configurations and
@@ -112,11 +132,16 @@ bma222::bma222(bus_i2c_t* iface) : sensor_i2c(iface, BMA222_TRANSACTION_BYTE) {
 		band_table				= bands;
 
 		/* Check bus status and return true if ok */
-		if ((STATUS_OK == bus->get_status())
+		if (STATUS_OK == bus->get_status()){
+
 #ifdef BMA222_IRQ
-				&& irq_connect(BMA222_INT_PIN, CHANGE, bma222_t::isr)
+			/*
+			 * Register the isr, one edge per interrupt
+			 */
+			irq_owner = this;
+			irq_connect(BMA222_INT_PIN, RISING, bma222_t::isr);
 #endif
-		){ // Register the isr
+
 			/*
 			 * No Errors
 			 */
@@ -159,8 +184,12 @@ bool bma222::run(){
 	/*
 	 * We read all the pertinent values from the sensor.
 	 */
+#ifdef BMA222_BURST
+	rc |= get_burst();
+#else
 	rc |= read(SENSOR_READ_ACCELERATION);
 	rc |= read(SENSOR_READ_TEMPERATURE);
+#endif
 
 	/*
 	 * Sleep the device
@@ -170,6 +199,222 @@ bool bma222::run(){
 	return (rc);
 }
 
+/**
+ * @brief Reads the three axes in one burst, or the FIFO (sampler ISR).
+ *
+ * @param	samples	The samples to fill, oldest first
+ * @param	max		The room in samples
+ * @return	count	The samples read, 0 if none or the read failed
+ */
+uint16_t bma222::sample(sensor_sample_t* samples, uint16_t max){
+
+	if(!max){
+		return 0;
+	}
+
+	if(fifo){
+		return get_fifo(samples, max);
+	}
+
+	/*
+	 * New data flag and value per axis, from X to Z
+	 */
+	uint8_t raw[BMA222E_FIFO_FRAME];
+
+	if(sizeof(raw) != bus->read_burst(BMA222_I2C_ADDR, BMA222_NEW_DATA_X,
+			raw, sizeof(raw))){
+		return 0;
+	}
+
+	samples->value[0] = (int8_t)raw[1];
+	samples->value[1] = (int8_t)raw[3];
+	samples->value[2] = (int8_t)raw[5];
+	return 1;
+}
+
+/**
+ * @brief Drains the BMA222E FIFO (sampler ISR).
+ *
+ * The frames have the layout of the data registers, the value
+ * of each axis in the odd bytes.
+ *
+ * @param	samples	The samples to fill, oldest first
+ * @param	max		The room in samples
+ * @return	count	The frames read
+ */
+uint16_t bma222::get_fifo(sensor_sample_t* samples, uint16_t max){
+
+	uint8_t status;
+
+	if(1 != bus->read_burst(BMA222_I2C_ADDR, BMA222E_FIFO_STATUS, &status, 1)){
+		return 0;
+	}
+
+	/*
+	 * The oldest frames were overwritten, the drain was too late
+	 */
+	if(status & BMA222E_FIFO_OVERRUN){
+		overruns++;
+	}
+
+	uint16_t frames = status & BMA222E_FIFO_FRAMES;
+	if(frames > max){
+		frames = max;
+	}
+
+	uint16_t count = 0;
+	while(count < frames){
+
+		/*
+		 * As many frames as the bus buffer holds
+		 */
+		uint16_t chunk = frames - count;
+		if(chunk > BMA222E_FIFO_CHUNK){
+			chunk = BMA222E_FIFO_CHUNK;
+		}
+
+		uint16_t size = chunk * BMA222E_FIFO_FRAME;
+		if(size != bus->read_burst(BMA222_I2C_ADDR, BMA222E_FIFO_DATA,
+				fifo_raw, size)){
+			break;
+		}
+
+		for(uint16_t i = 0; i < chunk; i++, count++){
+			const uint8_t* frame = &fifo_raw[i * BMA222E_FIFO_FRAME];
+			samples[count].value[0] = (int8_t)frame[1];
+			samples[count].value[1] = (int8_t)frame[3];
+			samples[count].value[2] = (int8_t)frame[5];
+		}
+	}
+
+	return count;
+}
+
+/**
+ * @brief Keeps the device awake, filter below half the rate.
+ *
+ * The data is filtered at the bandwidth and updated at twice the
+ * bandwidth, so the widest band under half the rate does not alias.
+ * With data ready, the new data interrupt is mapped on INT1 and
+ * paces the sampler at twice the bandwidth. With the FIFO, the
+ * BMA222E keeps the frames and the watermark interrupt paces the
+ * sampler once per batch. The update rate is left in hal.sample_rate.
+ *
+ * @param	rate	The sampling rate (Hz), 0 to stop
+ * @param	trigger	What paces the reads
+ * @param	batch	The frames per watermark interrupt
+ * @return	bool	true if the call succeeds
+ */
+bool bma222::sampling(uint32_t rate, sensor_trigger_t trigger, uint8_t batch){
+
+	/*
+	 * Back to the default band, run() sleeps the device again
+	 */
+	if(!rate){
+		if(fifo){
+			fifo = false;
+			reg_bitclear(BMA222_17_INTR_EN, BMA222E_FWM_EN);
+			reg_bitclear(BMA222_1A_INTR_MAP, BMA222E_INT1_FWM);
+			reg_put(BMA222E_FIFO_CONFIG_1, BMA222E_FIFO_BYPASS);
+		}
+		if(ready_irq){
+			ready_irq = false;
+			event(SENSOR_EVENT_NEW_DATA, NULL, false);
+			reg_bitclear(BMA222_1A_INTR_MAP, BMA222_INT1_DATA);
+		}
+		hal.sample_rate = 0;
+		return set_bandwidth(ARRAYSIZE(bands) - 1);
+	}
+
+	/*
+	 * Only the BMA222E has a FIFO
+	 */
+	if(SENSOR_TRIGGER_FIFO == trigger){
+		if((BMA222E_ID_VAL != id.dev_id) || !batch || (batch >= BMA222E_FIFO_DEPTH)){
+			return false;
+		}
+	}
+
+	int16_t band = 0;
+	for(int16_t i = 0; i < (int16_t)ARRAYSIZE(bands); i++){
+		if((uint32_t)(bands[i].bandwidth_Hz * 2) <= rate){
+			band = i;
+		}
+	}
+
+	/*
+	 * Bandwidth and power mode are adjacent, one write
+	 */
+	reg_defer();
+	set_state(SENSOR_STATE_NORMAL);
+	set_bandwidth(band);
+	if(!reg_flush()){
+		return false;
+	}
+
+	mod					= SENSOR_STATE_NORMAL;
+	hal.bandwidth		= bands[band].bandwidth_Hz;
+	hal.sample_rate		= bands[band].bandwidth_Hz * 2;
+
+	if(SENSOR_TRIGGER_TIMER == trigger){
+		return true;
+	}
+
+	if(!irq_owner){
+		irq_owner = this;
+		irq_connect(BMA222_INT_PIN, RISING, bma222_t::isr);
+	}
+	ready_irq = true;
+
+	if(SENSOR_TRIGGER_DATA_READY == trigger){
+
+		/*
+		 * New data on INT1, one edge per sample
+		 */
+		reg_bitset(BMA222_1A_INTR_MAP, BMA222_INT1_DATA);
+		return event(SENSOR_EVENT_NEW_DATA, NULL, true);
+	}
+
+	/*
+	 * Stream mode keeps the newest frames, the watermark on INT1
+	 * raises one edge per batch. The mode write clears the FIFO.
+	 */
+	reg_put(BMA222E_FIFO_CONFIG_0, batch);
+	reg_put(BMA222E_FIFO_CONFIG_1, BMA222E_FIFO_STREAM | BMA222E_FIFO_XYZ);
+	reg_bitset(BMA222_1A_INTR_MAP, BMA222E_INT1_FWM);
+	reg_bitset(BMA222_17_INTR_EN, BMA222E_FWM_EN);
+	fifo = true;
+	return true;
+}
+
+/**
+ * @brief Stores the newest sample of a block, reads the temperature.
+ *
+ * The cache holds the latest reading, the whole block went to the
+ * sampler sinks before.
+ *
+ * @param	samples	The samples, oldest first
+ * @param	count	The number of samples
+ * @return	bool	true of the update was successful.
+ */
+bool bma222::commit(const sensor_sample_t* samples, uint16_t count){
+
+	if(!count){
+		return true;
+	}
+
+	const sensor_sample_t* sample = &samples[count - 1];
+	cache.acc.acc.axis.x 	= (uint8_t)sample->value[0];
+	cache.acc.acc.axis.y 	= (uint8_t)sample->value[1];
+	cache.acc.acc.axis.z 	= (uint8_t)sample->value[2];
+	cache.acc.timestamp 	= sample->timestamp;
+
+	/*
+	 * The device stays awake while sampled
+	 */
+	return read(SENSOR_READ_TEMPERATURE);
+}
+
 /**
  * \brief Read sensor data
  *
@@ -409,7 +654,7 @@ bool bma222::set_state(sensor_state_t mode){
 			} else if ((SENSOR_STATE_SUSPEND == mode) ||
 					(SENSOR_STATE_LOWEST_POWER == mode)) {
 				/* Enter suspend mode from normal mode. */
-				bus->put(BMA222_I2C_ADDR, BMA222_POWER_MODES, BMA222_SUSPEND);
+				reg_put(BMA222_POWER_MODES, BMA222_SUSPEND);
 			}
 
 			break;
@@ -422,7 +667,7 @@ bool bma222::set_state(sensor_state_t mode){
 			if ((SENSOR_STATE_SUSPEND == mode) ||
 					(SENSOR_STATE_LOWEST_POWER == mode)) {
 				/* Enter suspend mode from sleep mode. */
-				bus->put(BMA222_I2C_ADDR, BMA222_POWER_MODES, BMA222_SUSPEND);
+				reg_put(BMA222_POWER_MODES, BMA222_SUSPEND);
 			}
 
 			break;
@@ -437,7 +682,7 @@ bool bma222::set_state(sensor_state_t mode){
 			} else if ((SENSOR_STATE_NORMAL == mode) ||
 					(SENSOR_STATE_HIGHEST_POWER == mode)) {
 				/* Enter normal mode from suspend mode. */
-				bus->put(BMA222_I2C_ADDR, BMA222_POWER_MODES, 0);
+				reg_put(BMA222_POWER_MODES, 0);
 			}
 
 			break;
@@ -448,8 +693,13 @@ bool bma222::set_state(sensor_state_t mode){
 			 * \todo
 			 * Update sensor device descriptor operational settings.
 			 */
-			bus->put(BMA222_I2C_ADDR, BMA222_SOFTRESET, BMA222_RESET);
-			bus->put(BMA222_I2C_ADDR, BMA222_SOFTRESET, BMA222_RESET);
+			reg_put(BMA222_SOFTRESET, BMA222_RESET);
+			reg_put(BMA222_SOFTRESET, BMA222_RESET);
+
+			/*
+			 * Back to the power on values
+			 */
+			shadow_invalidate();
 			break;
 
 		default:
@@ -589,13 +839,13 @@ bool bma222::get_temp(){
 bool bma222::get_acc(){
 
 	/*
-	 * Get the device id
+	 * Flag and value per axis
 	 */
-	if(sizeof(uint8_t) != bus->read_bytes(
+	if(sizeof(regs.acc) != bus->read_block(
 				BMA222_I2C_ADDR,				// Destination
-				sizeof(regs.acc),				// Size to read
-				hal.burst_addr,					// Memory index to read from
-				(uint8_t*)&regs.acc				// Where to store the value
+				BMA222_NEW_DATA_X,				// Memory index to read from
+				(uint8_t*)&regs.acc,			// Where to store the value
+				sizeof(regs.acc)				// Size to read
 			)){
 
 		/*
@@ -608,7 +858,10 @@ bool bma222::get_acc(){
 	/*
 	 * Convert
 	 */
-	memcpy((void*)&cache.acc.acc.axis, (void*)&regs.acc, sizeof(regs.acc));
+	cache.acc.acc.axis.x 	= (uint8_t)regs.acc[0].value;
+	cache.acc.acc.axis.y 	= (uint8_t)regs.acc[1].value;
+	cache.acc.acc.axis.z 	= (uint8_t)regs.acc[2].value;
+	cache.acc.timestamp 	= sys_clock::now();
 
 	/*
 	 * Return the bus status
@@ -617,6 +870,49 @@ bool bma222::get_acc(){
 
 }
 
+/**
+ * @brief Read BMA222 acceleration, temperature and status at once.
+ *
+ * One repeated start transaction of the whole event register
+ * block from hal.burst_addr, decoded in place into the caches.
+ *
+ * @return bool     true if the call succeeds, else false is returned.
+ */
+bool bma222::get_burst(){
+
+	/*
+	 * 0x02 to 0x0c: axes, temperature, interrupt status
+	 */
+	if(sizeof(regs) != bus->read_block(
+				BMA222_I2C_ADDR,				// Destination
+				hal.burst_addr,					// Memory index to read from
+				(uint8_t*)&regs,				// Where to store the value
+				sizeof(regs)					// Size to read
+			)){
+
+		/*
+		 * Error present
+		 */
+		err = SENSOR_ERR_DRIVER;
+		return false;
+	}
+
+	/*
+	 * Decode, the status stays in regs for the events
+	 */
+	clock_us_t now 			= sys_clock::now();
+
+	cache.acc.acc.axis.x 	= (uint8_t)regs.acc[0].value;
+	cache.acc.acc.axis.y 	= (uint8_t)regs.acc[1].value;
+	cache.acc.acc.axis.z 	= (uint8_t)regs.acc[2].value;
+	cache.acc.timestamp 	= now;
+
+	cache.temp.temperature.value = BMA222_TEMP_OFFSET + ((int16_t)regs.temp / 2);
+	cache.temp.timestamp 	= now;
+
+	return true;
+}
+
 /**
  * @brief Enable or disable the BMA222 sleep mode.
  *
@@ -632,7 +928,7 @@ void bma222::sleep_en(bool sleep){
 
 	uint8_t const power_mode_val = (sleep == true)
 			? (BMA222_LOWPOWER_EN | BMA222_SLEEP_DUR_1ms) : 0;
-	bus->put(BMA222_I2C_ADDR, BMA222_POWER_MODES, power_mode_val);
+	reg_put(BMA222_POWER_MODES, power_mode_val);
 }
 
 /**
@@ -642,8 +938,7 @@ void bma222::sleep_en(bool sleep){
  * @return bool     true if the call succeeds, else false is returned.
  */
 bool bma222::set_range(int16_t range){
-	bus->put(BMA222_I2C_ADDR, BMA222_G_RANGE, range_table[range].reserved_val);
-	return (STATUS_OK == bus->get_status());
+	return reg_put(BMA222_G_RANGE, range_table[range].reserved_val);
 }
 
 /**
@@ -653,8 +948,7 @@ bool bma222::set_range(int16_t range){
  * @return bool     true if the call succeeds, else false is returned.
  */
 bool bma222::set_bandwidth(int16_t band){
-	bus->put(BMA222_I2C_ADDR, BMA222_BANDWIDTH, band_table[band].reserved_val);
-	return (STATUS_OK == bus->get_status());
+	return reg_put(BMA222_BANDWIDTH, band_table[band].reserved_val);
 }
 
 /**
@@ -682,7 +976,7 @@ bool bma222::set_threshold(sensor_threshold_desc_t *threshold){
 			 * value of 14h for the default 2mg range implies a threshold of
 			 * 312.5mg.
 			 */
-			bus->put(BMA222_I2C_ADDR, BMA222_SLOPE_THRESHOLD, (uint8_t)value);
+			reg_put(BMA222_SLOPE_THRESHOLD, (uint8_t)value);
 			break;
 
 		case SENSOR_THRESHOLD_TAP:
@@ -697,7 +991,7 @@ bool bma222::set_threshold(sensor_threshold_desc_t *threshold){
 			 */
 		{
 			int8_t const mask = BMA222_TAP_TH_FIELD;
-			bus->reg_fieldset(BMA222_I2C_ADDR, BMA222_TAP_CONFIG, mask, (uint8_t)value);
+			reg_fieldset(BMA222_TAP_CONFIG, mask, (uint8_t)value);
 		}
 		break;
 
@@ -712,7 +1006,7 @@ bool bma222::set_threshold(sensor_threshold_desc_t *threshold){
 			 * by 7.81mg (781/100) to calculate the register value.
 			 */
 			value = (threshold->value * 100) / 781;
-			bus->put(BMA222_I2C_ADDR, BMA222_LOW_G_THRESHOLD, (uint8_t)value);
+			reg_put(BMA222_LOW_G_THRESHOLD, (uint8_t)value);
 			break;
 
 		case SENSOR_THRESHOLD_HIGH_G:
@@ -725,7 +1019,7 @@ bool bma222::set_threshold(sensor_threshold_desc_t *threshold){
 			 * etc. will apply. The default 0ah raw value corresponds to the
 			 * default 2mg range.
 			 */
-			bus->put(BMA222_I2C_ADDR, BMA222_HIGH_G_THRESHOLD, (uint8_t)value);
+			reg_put(BMA222_HIGH_G_THRESHOLD, (uint8_t)value);
 			break;
 		}
 
@@ -746,26 +1040,25 @@ bool bma222::get_threshold(sensor_threshold_desc_t *threshold){
 
 	case SENSOR_THRESHOLD_MOTION:
 		threshold->value = raw_to_scaled(this,
-				bus->get(BMA222_I2C_ADDR, BMA222_SLOPE_THRESHOLD));
+				reg_get(BMA222_SLOPE_THRESHOLD));
 		break;
 
 	case SENSOR_THRESHOLD_TAP:
 	{
 		uint8_t const mask = BMA222_TAP_TH_FIELD;
 		threshold->value = raw_to_scaled(this,
-				bus->reg_fieldget(BMA222_I2C_ADDR, BMA222_TAP_CONFIG,
+				reg_fieldget(BMA222_TAP_CONFIG,
 				mask));
 	}
 	break;
 
 	case SENSOR_THRESHOLD_LOW_G:
-		threshold->value = (781 / 100) * bus->get(BMA222_I2C_ADDR,
-				BMA222_LOW_G_THRESHOLD);
+		threshold->value = (781 / 100) * reg_get(BMA222_LOW_G_THRESHOLD);
 		break;
 
 	case SENSOR_THRESHOLD_HIGH_G:
 		threshold->value = raw_to_scaled(this,
-				bus->get(BMA222_I2C_ADDR, BMA222_HIGH_G_THRESHOLD));
+				reg_get(BMA222_HIGH_G_THRESHOLD));
 		break;
 	}
 
@@ -798,8 +1091,8 @@ bool bma222::event(sensor_event_t sensor_event,
 
 		bool status = false;
 
-		uint8_t int_enable1 = bus->get(BMA222_I2C_ADDR, BMA222_16_INTR_EN);
-		uint8_t int_enable2 = bus->get(BMA222_I2C_ADDR, BMA222_17_INTR_EN);
+		uint8_t int_enable1 = reg_get(BMA222_16_INTR_EN);
+		uint8_t int_enable2 = reg_get(BMA222_17_INTR_EN);
 
 		if (sensor_event & SENSOR_EVENT_NEW_DATA) {
 			if (callback) {
@@ -882,8 +1175,19 @@ bool bma222::event(sensor_event_t sensor_event,
 			status = true;
 		}
 
-		bus->put(BMA222_I2C_ADDR, BMA222_16_INTR_EN, int_enable1);
-		bus->put(BMA222_I2C_ADDR, BMA222_17_INTR_EN, int_enable2);
+		/*
+		 * Both enable registers in one write
+		 */
+		reg_defer();
+		reg_put(BMA222_16_INTR_EN, int_enable1);
+		reg_put(BMA222_17_INTR_EN, int_enable2);
+		reg_flush();
+
+		/*
+		 * Whether the interrupt pin still needs the bottom half
+		 */
+		event_irq = (int_enable1 != 0) ||
+				((int_enable2 & ~(BMA222_DATA_EN | BMA222E_FWM_EN)) != 0);
 
 		return status;
 }
@@ -912,74 +1216,88 @@ bool bma222::event(sensor_event_t sensor_event,
  * installed for that event, it will always be called by this routine,
  * and the SENSOR_EVENT_MOTION indicator will be set in the event type field.
  *
- * @param sensor	The sensor to address
- * @param arg       The default args
- * @return Nothing.
+ * Bottom half, runs in task context. See isr() for the top half.
+ *
+ * @param timestamp	When the first pending interrupt fired
+ * @param count		The interrupts served at once
  */
-void bma222::isr(void* sensor, void *arg){
-#ifdef BMA222_IRQ
+void bma222::irq_work(clock_us_t timestamp, uint16_t count){
 
 	/*
-	 * NOTE !!! This code has not been updated and may pose issues
-	 * in the compile process...
-	 *
+	 * Temp
 	 */
-
+	uint16_t event = SENSOR_EVENT_UNKNOWN;
 
 	/*
-	 * Convert sensor
+	 * Read what event has happened, with the data that came with it
 	 */
-	bma222_t*	bma222 = (bma222_t*)sensor;
+	if (!get_burst()) {
+		return;
+	}
 
 	/*
-	 * Read what event has happened
+	 * Time of the interrupt, not of the read
 	 */
-	bus->read_bytes(	BMA222_I2C_ADDR,
-				sizeof(bma222_event_regs_t),
-				hal.burst_addr,
-				(uint8_t*)&regs);
+	evt_data.data.timestamp = timestamp;
+
+	if (regs.status_field.data_int) {
+		event |= SENSOR_EVENT_NEW_DATA;
+	}
+	if (regs.status_field.slope_int) {
+		event |= SENSOR_EVENT_MOTION;
+	}
+	if (regs.status_field.low_int) {
+		event |= SENSOR_EVENT_LOW_G;
+	}
+	if (regs.status_field.high_int) {
+		event |= SENSOR_EVENT_HIGH_G;
+	}
+	if (regs.status_field.s_tap_int) {
+		event |= SENSOR_EVENT_S_TAP;
+	}
+	if (regs.status_field.d_tap_int) {
+		event |= SENSOR_EVENT_D_TAP;
+	}
+	evt_data.event = (sensor_event_t)event;
 
 	/*
-	 * If the bus is in a good state we know the transaction was
-	 * a success.
+	 * Callbacks (data=0, motion=1, low-g=2, high-g=3, tap=4)
 	 */
-	if (STATUS_OK == bus->get_status()) {
-
-		/*
-		 * Get timestamp
-		 */
-		bma222->evt_data.data.timestamp = timestamp();
-		bma222->evt_data.event = SENSOR_EVENT_UNKNOWN;
-
-		if (bma222->regs.status_field.data_int) {
-			bma222->evt_data.event |= SENSOR_EVENT_NEW_DATA;
-			(callbacks[0].handler)(&bma222->evt_data, callbacks[0].arg);
-		}
-
-		if (bma222->regs.status_field.slope_int) {
-			bma222->evt_data.event |= SENSOR_EVENT_MOTION;
-			(callbacks[1].handler)(&bma222->evt_data, callbacks[1].arg);
-		}
-
-		if (bma222->regs.status_field.low_int) {
-			bma222->evt_data.event |= SENSOR_EVENT_LOW_G;
-			(callbacks[2].handler)(&bma222->evt_data, callbacks[2].arg);
-		}
+	if ((event & SENSOR_EVENT_NEW_DATA) && callbacks[0].handler) {
+		(callbacks[0].handler)(&evt_data, callbacks[0].arg);
+	}
+	if ((event & SENSOR_EVENT_MOTION) && callbacks[1].handler) {
+		(callbacks[1].handler)(&evt_data, callbacks[1].arg);
+	}
+	if ((event & SENSOR_EVENT_LOW_G) && callbacks[2].handler) {
+		(callbacks[2].handler)(&evt_data, callbacks[2].arg);
+	}
+	if ((event & SENSOR_EVENT_HIGH_G) && callbacks[3].handler) {
+		(callbacks[3].handler)(&evt_data, callbacks[3].arg);
+	}
+	if ((event & (SENSOR_EVENT_S_TAP | SENSOR_EVENT_D_TAP)) && callbacks[4].handler) {
+		(callbacks[4].handler)(&evt_data, callbacks[4].arg);
+	}
+}
 
-		if (bma222->regs.status_field.high_int) {
-			bma222->evt_data.event |= SENSOR_EVENT_HIGH_G;
-			(callbacks[3].handler)(&bma222->evt_data, callbacks[3].arg);
-		}
+/**
+ * @brief Interrupt top half, only captures the interrupt.
+ *
+ * No bus access here: the DAQ task may have a transaction in
+ * flight and the other interrupts must not wait on the bus. New
+ * data goes to the sampler, which reads it only on a free bus.
+ */
+void bma222::isr(){
 
-		if (bma222->regs.status_field.s_tap_int) {
-			bma222->evt_data.event |= SENSOR_EVENT_S_TAP;
-			(callbacks[4].handler)(&bma222->evt_data, callbacks[4].arg);
-		}
+	if (!irq_owner) {
+		return;
+	}
 
-		if (bma222->regs.status_field.d_tap_int) {
-			bma222->evt_data.event |= (sensor_event_t)SENSOR_EVENT_D_TAP;
-			(callbacks[4].handler)(&bma222->evt_data, callbacks[4].arg);
+	if (irq_owner->ready_irq && ready_notify) {
+		ready_notify(irq_owner);
+		if (!irq_owner->event_irq) {
+			return;
 		}
 	}
-#endif
+	irq_owner->irq_capture();
 }
@@ -99,6 +99,43 @@ typedef enum {
 /* BMA222_CHIP_ID (0x00) */
 
 #define BMA222_ID_VAL           (0x03)
+#define BMA222E_ID_VAL          (0xf8)      /* BMA222E, with a frame FIFO */
+
+/*
+ * BMA222E FIFO
+ *
+ * 32 frames of 6 bytes (flag/data per axis), read out of the FIFO data
+ * register. A write to BMA222E_FIFO_CONFIG_1 clears the FIFO.
+ */
+
+#define BMA222E_FIFO_STATUS     (0x0e)      /* (ro) overrun and frame count */
+#define BMA222E_FIFO_CONFIG_0   (0x30)      /* (w/r) watermark level */
+#define BMA222E_FIFO_CONFIG_1   (0x3e)      /* (w/r) mode and data select */
+#define BMA222E_FIFO_DATA       (0x3f)      /* (ro) frame data output */
+
+#define BMA222E_FIFO_OVERRUN    (1 << 7)    /* frames were lost */
+#define BMA222E_FIFO_FRAMES     (0x7f)      /* frames in the FIFO */
+#define BMA222E_FIFO_BYPASS     (0x00)      /* no FIFO (default) */
+#define BMA222E_FIFO_STREAM     (0x80)      /* the newest frames are kept */
+#define BMA222E_FIFO_XYZ        (0x00)      /* x, y and z frames */
+#define BMA222E_FIFO_DEPTH      (32)        /* frames */
+#define BMA222E_FIFO_FRAME      (6)         /* bytes per xyz frame */
+#define BMA222E_FIFO_CHUNK      (I2C_BURST_MAX / BMA222E_FIFO_FRAME)
+
+#define BMA222E_FWM_EN          (1 << 6)    /* 0x17 watermark interrupt enable */
+#define BMA222E_INT1_FWM        (1 << 1)    /* 0x1a map watermark interrupt to INT1 */
+
+/*
+ * Register shadow, the configuration registers 0x0f to 0x3e. The
+ * commands and the self clearing bits are always written.
+ */
+#define BMA222_SHADOW_FIRST     (BMA222_G_RANGE)
+#define BMA222_SHADOW_COUNT     (BMA222E_FIFO_CONFIG_1 - BMA222_G_RANGE + 1)
+#define BMA222_SHADOW_UNCACHED  ((1ULL << (BMA222_SOFTRESET - BMA222_SHADOW_FIRST))          | \
+                                 (1ULL << (BMA222_INTR_PIN_MODE - BMA222_SHADOW_FIRST))      | \
+                                 (1ULL << (BMA222_SENSOR_SELF_TEST - BMA222_SHADOW_FIRST))   | \
+                                 (1ULL << (BMA222_EEPROM_CONTROL - BMA222_SHADOW_FIRST))     | \
+                                 (1ULL << (BMA222E_FIFO_CONFIG_1 - BMA222_SHADOW_FIRST)))
 
 /* BMA222_INTR_STATUS (0x09) */
 
@@ -297,44 +334,53 @@ typedef enum {
  */
 #define hysteresis_in_g(hysteresis, range)  (((threshold) * 4) / (range))
 
-/** \brief Sensor Event Registers */
+/**
+ * \brief Sensor Event Registers
+ *
+ * The contiguous block from BMA222_NEW_DATA_X (0x02) to
+ * BMA222_ORIENTATION_STATUS (0x0c), read in one burst. The status
+ * fields are LSB first (little endian bit fields).
+ */
 typedef struct {
 
-	uint8_t acc[3];                	   /**< Acceleration data */
+	struct {
+		uint8_t new_data;              /**< New data flag (bit 0) */
+		int8_t value;                  /**< Acceleration data */
+	} acc[3];                          /**< X, Y and Z axes */
 	int8_t temp;                       /**< Temperature data */
 
 	union {
 		uint8_t status_byte[4];        /**< Status bytes */
 		struct {                       /**< Status fields */
-			uint8_t flat_int      : 1; /**< Flat interrupt triggered */
-			uint8_t orient_int    : 1; /**< Orientation interrupt triggered */
-			uint8_t s_tap_int     : 1; /**< Single-tap interrupt triggered */
-			uint8_t d_tap_int     : 1; /**< double-tap interrupt triggered */
-			uint8_t reserved_09   : 1;
-			uint8_t slope_int     : 1; /**< Slope criteria triggered */
-			uint8_t high_int      : 1; /**< High-g criteria triggered */
 			uint8_t low_int       : 1; /**< Low-g criteria triggered */
+			uint8_t high_int      : 1; /**< High-g criteria triggered */
+			uint8_t slope_int     : 1; /**< Slope criteria triggered */
+			uint8_t reserved_09   : 1;
+			uint8_t d_tap_int     : 1; /**< double-tap interrupt triggered */
+			uint8_t s_tap_int     : 1; /**< Single-tap interrupt triggered */
+			uint8_t orient_int    : 1; /**< Orientation interrupt triggered */
+			uint8_t flat_int      : 1; /**< Flat interrupt triggered */
 
-			uint8_t data_int      : 1; /**< New data interrupt triggered */
 			uint8_t reserved_0a   : 7;
+			uint8_t data_int      : 1; /**< New data interrupt triggered */
 
-			uint8_t tap_sign      : 1; /**< Tap axis motion direction */
-			uint8_t tap_first_z   : 1; /**< z-axis tap interrupt */
-			uint8_t tap_first_y   : 1; /**< y-axis tap interrupt */
-			uint8_t tap_first_x   : 1; /**< x-axis tap interrupt */
-			uint8_t slope_sign    : 1; /**< Axis motion direction */
-			uint8_t slope_first_z : 1; /**< z-axis any-motion interrupt */
-			uint8_t slope_first_y : 1; /**< y-axis any-motion interrupt */
 			uint8_t slope_first_x : 1; /**< x-axis any-motion interrupt */
+			uint8_t slope_first_y : 1; /**< y-axis any-motion interrupt */
+			uint8_t slope_first_z : 1; /**< z-axis any-motion interrupt */
+			uint8_t slope_sign    : 1; /**< Axis motion direction */
+			uint8_t tap_first_x   : 1; /**< x-axis tap interrupt */
+			uint8_t tap_first_y   : 1; /**< y-axis tap interrupt */
+			uint8_t tap_first_z   : 1; /**< z-axis tap interrupt */
+			uint8_t tap_sign      : 1; /**< Tap axis motion direction */
 
-			uint8_t flat          : 1; /**< Orientation with respect
-			                            * to gravity */
+			uint8_t high_first_x  : 1; /**< x-axis high-g interrupt */
+			uint8_t high_first_y  : 1; /**< y-axis high-g interrupt */
+			uint8_t high_first_z  : 1; /**< z-axis high-g interrupt */
+			uint8_t high_sign     : 1; /**< High-g interrupt sign */
 			uint8_t orient        : 3; /**< orientation with respect
 			                            * to gravity */
-			uint8_t high_sign     : 1; /**< High-g interrupt sign */
-			uint8_t high_first_z  : 1; /**< z-axis high-g interrupt */
-			uint8_t high_first_y  : 1; /**< y-axis high-g interrupt */
-			uint8_t high_first_x  : 1; /**< x-axis high-g interrupt */
+			uint8_t flat          : 1; /**< Orientation with respect
+			                            * to gravity */
 		} status_field;
 	};
 } bma222_event_regs_t;
@@ -454,6 +500,40 @@ class bma222: public sensor_i2c_t {
 		 */
 		bool run();
 
+		/**
+		 * @brief Reads the three axes in one burst, or the FIFO (sampler ISR).
+		 *
+		 * @param	samples	The samples to fill, oldest first
+		 * @param	max		The room in samples
+		 * @return	count	The samples read, 0 if none or the read failed
+		 */
+		uint16_t sample(sensor_sample_t* samples, uint16_t max);
+
+		/**
+		 * @brief Keeps the device awake, filter below half the rate.
+		 *
+		 * The data ready and FIFO watermark interrupts are mapped on
+		 * INT1 and pace the sampler. The FIFO needs a BMA222E.
+		 *
+		 * @param	rate	The sampling rate (Hz), 0 to stop
+		 * @param	trigger	What paces the reads
+		 * @param	batch	The frames per watermark interrupt
+		 * @return	bool	true if the call succeeds
+		 */
+		bool sampling(uint32_t rate, sensor_trigger_t trigger, uint8_t batch);
+
+		/**
+		 * @brief Stores the newest sample of a block, reads the temperature.
+		 *
+		 * The cache holds the latest reading, the whole block went to the
+		 * sampler sinks before.
+		 *
+		 * @param	samples	The samples, oldest first
+		 * @param	count	The number of samples
+		 * @return	bool	true of the update was successful.
+		 */
+		bool commit(const sensor_sample_t* samples, uint16_t count);
+
 		/**
 		 * \brief Read sensor data
 		 *
@@ -656,6 +736,28 @@ class bma222: public sensor_i2c_t {
 		 */
 		bool get_acc();
 
+		/**
+		 * @brief Read BMA222 acceleration, temperature and status at once.
+		 *
+		 * One repeated start transaction of the whole event register
+		 * block from hal.burst_addr, decoded in place into the caches.
+		 *
+		 * @return bool     true if the call succeeds, else false is returned.
+		 */
+		bool get_burst();
+
+		/**
+		 * @brief Drains the BMA222E FIFO (sampler ISR).
+		 *
+		 * Every frame in the FIFO, in bursts as long as the bus
+		 * buffer allows. An overrun is counted.
+		 *
+		 * @param	samples	The samples to fill, oldest first
+		 * @param	max		The room in samples
+		 * @return	count	The frames read
+		 */
+		uint16_t get_fifo(sensor_sample_t* samples, uint16_t max);
+
 		/**
 		 * @brief Enable or disable the BMA222 sleep mode.
 		 *
@@ -744,11 +846,34 @@ class bma222: public sensor_i2c_t {
 		 * installed for that event, it will always be called by this routine,
 		 * and the SENSOR_EVENT_MOTION indicator will be set in the event type field.
 		 *
-		 * @param sensor	The sensor to address
-		 * @param arg       The default args
-		 * @return Nothing.
+		 * Bottom half, runs in task context. See isr() for the top half.
+		 *
+		 * @param timestamp	When the first pending interrupt fired
+		 * @param count		The interrupts served at once
+		 */
+		void irq_work(clock_us_t timestamp, uint16_t count);
+
+		/**
+		 * @brief Interrupt top half, only captures the interrupt.
+		 */
+		static void isr();
+
+		/*
+		 * The device behind the interrupt pin
+		 */
+		static bma222*					irq_owner;
+
+		/*
+		 * New data read by the sampler, other events for the bottom half
+		 */
+		bool							ready_irq;
+		bool							event_irq;
+
+		/*
+		 * FIFO mode, frames read per burst
 		 */
-		static void isr(void* sensor, void *arg);
+		bool							fifo;
+		uint8_t							fifo_raw[BMA222E_FIFO_CHUNK * BMA222E_FIFO_FRAME];
 };
 
 /**< @brief Typedef */
@@ -0,0 +1,155 @@
+/*
+ * drivers.cpp
+ */
+
+#include <platform/platform.h>
+#include <string.h>
+
+#ifdef SENSOR_DISCOVERY
+
+#ifdef INCLUDE_TMP006
+/**
+ * @brief Instantiates a TMP006.
+ *
+ * @param bus			The bus
+ * @return sensor_t*	The sensor, NULL if it did not initialise
+ */
+static sensor_t* tmp006_create(bus_i2c_t* bus){
+
+	tmp006_t* device = new tmp006_t(bus);
+	if(SENSOR_ERR_NONE != device->err){
+		delete device;
+		return (NULL);
+	}
+	return ((sensor_t*)device);
+}
+#endif
+
+#ifdef INCLUDE_BMA222
+/**
+ * @brief Instantiates a BMA222 or BMA222E.
+ *
+ * @param bus			The bus
+ * @return sensor_t*	The sensor, NULL if it did not initialise
+ */
+static sensor_t* bma222_create(bus_i2c_t* bus){
+
+	bma222_t* device = new bma222_t(bus);
+	if(SENSOR_ERR_NONE != device->err){
+		delete device;
+		return (NULL);
+	}
+	return ((sensor_t*)device);
+}
+#endif
+
+/*
+ * Known drivers, in registration order
+ */
+static const sensor_driver_t known[] = {
+#ifdef INCLUDE_TMP006
+		{"tmp006", TMP006_I2C_ADDR, TMP006_CHIP_ID, 2, {TMP006_ID_VAL, 0}, 			tmp006_create},
+#endif
+#ifdef INCLUDE_BMA222
+		{"bma222", BMA222_I2C_ADDR, BMA222_CHIP_ID, 1, {BMA222_ID_VAL, BMA222E_ID_VAL},	bma222_create},
+#endif
+};
+
+/**
+ * @brief Checks if a chip id belongs to a driver.
+ *
+ * @param driver		The driver
+ * @param id			The chip id read
+ * @return bool			True if the driver accepts it
+ */
+static bool sensor_match(const sensor_driver_t* driver, uint16_t id){
+
+	for(uint8_t i = 0; i < DRIVER_IDS_MAX; i++){
+		if(driver->ids[i] && (driver->ids[i] == id)){
+			return (true);
+		}
+	}
+	return (false);
+}
+
+/**
+ * @brief Finds the sensors on a bus.
+ *
+ * Scans the bus, reads the chip id of each known driver whose
+ * device acknowledged, and instantiates the matching drivers in
+ * the table order. A device is claimed by the first match.
+ *
+ * @param bus			The bus to scan
+ * @param sensors		Where to store the sensors, NULL terminated
+ * @param max			The room in sensors, less the terminator
+ * @return uint8_t		The number of sensors found
+ */
+uint8_t sensor_discover(bus_i2c_t* bus, sensor_t* sensors[], uint8_t max){
+
+	// Containers
+	uint8_t		found[I2C_ADDR_LAST - I2C_ADDR_FIRST + 1];
+	uint8_t		claimed[I2C_ADDR_LAST - I2C_ADDR_FIRST + 1];
+	uint8_t		present;
+	uint8_t		count 		= 0;
+
+	/*
+	 * Who answers
+	 */
+	present = bus->scan(found, sizeof(found));
+	memset(claimed, 0, sizeof(claimed));
+	NOTIFY_INFO("I2C devices found : " + String(present));
+
+	/*
+	 * Match the known drivers against them
+	 */
+	for(uint8_t d = 0; (d < ARRAYSIZE(known)) && (count < max); d++){
+
+		const sensor_driver_t* driver = &known[d];
+
+		for(uint8_t i = 0; i < present; i++){
+
+			if((found[i] != driver->addr) || claimed[i]){
+				continue;
+			}
+
+			/*
+			 * Chip id, MSB first
+			 */
+			uint8_t raw[2] = {0, 0};
+			if(driver->id_size != bus->read_block(driver->addr, driver->id_reg, raw, driver->id_size)){
+				NOTIFY_ERROR("Chip id read failed (" + String(driver->name) + ") at 0x" +
+						String(driver->addr, HEX));
+				break;
+			}
+
+			/*
+			 * Another chip at the address, another driver may claim it
+			 */
+			uint16_t id = (2 == driver->id_size) ? (uint16_t)((raw[0] << 8) | raw[1]) : raw[0];
+			if(!sensor_match(driver, id)){
+				NOTIFY_INFO("Chip id 0x" + String(id, HEX) + " at 0x" +
+						String(driver->addr, HEX) + " is not a " + String(driver->name));
+				break;
+			}
+
+			/*
+			 * Ours, bring the driver up
+			 */
+			sensor_t* sensor = driver->create(bus);
+			if(!sensor){
+				NOTIFY_ERROR("Sensor not initialised : " + String(driver->name));
+				break;
+			}
+
+			NOTIFY_INFO("Sensor found : " + String(driver->name));
+			claimed[i] 			= true;
+			sensors[count++] 	= sensor;
+			break;
+		}
+	}
+
+	sensors[count] = NULL;
+	return (count);
+}
+
+#endif /* SENSOR_DISCOVERY */
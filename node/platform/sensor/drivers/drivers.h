@@ -22,4 +22,42 @@
 #ifdef INCLUDE_BMA222
 #include "bosch/bma222.h"
 #endif
+
+#ifdef SENSOR_DISCOVERY
+
+#include <platform/bus/i2c/bus_i2c.h>
+
+/**
+ * @brief Most chip id values a driver accepts
+ */
+#define DRIVER_IDS_MAX		(2)
+
+/**
+ * @brief A known driver, how to recognise its device
+ */
+typedef struct {
+
+	const char*		name;						/**< Driver name **/
+	uint8_t			addr;						/**< Device address **/
+	uint8_t			id_reg;						/**< Chip id register **/
+	uint8_t			id_size;					/**< Chip id bytes, MSB first **/
+	uint16_t		ids[DRIVER_IDS_MAX];		/**< Accepted chip ids, 0 for none **/
+	sensor_t*		(*create)(bus_i2c_t* bus);	/**< Instantiates the driver, NULL on failure **/
+}sensor_driver_t;
+
+/**
+ * @brief Finds the sensors on a bus.
+ *
+ * Scans the bus, reads the chip id of each known driver whose
+ * device acknowledged, and instantiates the matching drivers in
+ * the table order. A device is claimed by the first match.
+ *
+ * @param bus			The bus to scan
+ * @param sensors		Where to store the sensors, NULL terminated
+ * @param max			The room in sensors, less the terminator
+ * @return uint8_t		The number of sensors found
+ */
+uint8_t sensor_discover(bus_i2c_t* bus, sensor_t* sensors[], uint8_t max);
+
+#endif /* SENSOR_DISCOVERY */
 #endif /* MODULES_DRIVERS_DRIVERS_H_ */
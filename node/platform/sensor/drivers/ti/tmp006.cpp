@@ -23,6 +23,12 @@ static const sensor_map_t range_table [] = {NULL};
  */
 static const sensor_map_t band_table [] = {NULL};
 
+/** \brief TI TMP006 Conversion Times (ms)
+ *
+ * Indexed by the conversion rate field, from 4 Hz down to 0.25 Hz.
+ */
+static const uint16_t conv_times [] = {250, 500, 1000, 2000, 4000};
+
 /*!
  *\brief The default constructor for the class.
  *
@@ -32,6 +38,13 @@ static const sensor_map_t band_table [] = {NULL};
  */
 tmp006::tmp006(bus_i2c_t* iface) : sensor_i2c(iface, TMP006_TRANSACTION_BYTE){
 
+	regs.status_byte = TMP006_CONF_DEFAULT;
+	set_conv_period(regs.status_byte);
+#ifdef I2C_ASYNC
+	conv_pending = false;
+	conv_at = 0;
+#endif
+
 	/*
 	 * Get the device id
 	 */
@@ -64,6 +77,12 @@ tmp006::tmp006(bus_i2c_t* iface) : sensor_i2c(iface, TMP006_TRANSACTION_BYTE){
 		caps.units				= 	SENSOR_UNITS_deg_Celcius;
 		caps.scale				= 	SENSOR_SCALE_one;
 		caps.name				= 	"TMP006 Digital temperature sensor";
+		caps.bus_speed			= 	I2C_SPEED_FAST_PLUS;
+
+		/*
+		 * No faster than the device on a shared bus
+		 */
+		bus->limit_speed(caps.bus_speed);
 
 		/*
 		 * Set the driver (device) default configurations and
@@ -127,29 +146,40 @@ tmp006::tmp006(bus_i2c_t* iface) : sensor_i2c(iface, TMP006_TRANSACTION_BYTE){
  */
 bool tmp006::run(){
 
+#ifdef I2C_ASYNC
 	/*
-	 * Return code
+	 * The conversion read queued on a previous run
 	 */
-	bool rc;
-
-	/*
-	 * Turn on the device
-	 */
-	rc = set_state(SENSOR_STATE_NORMAL);
+	if(conv_pending){
+		if(!i2c_queue::ended(&conv_txn[0]) || !i2c_queue::ended(&conv_txn[1])){
+			return true;
+		}
+		conv_pending = false;
+		return end_burst();
+	}
+#endif
 
 	/*
-	 * We read all the pertinent values from the sensor.
+	 * The device converts continuously, a conversion is read
+	 * once when the data ready bit shows it.
 	 */
-	rc |= read(SENSOR_READ_OBJ_TEMPERATURE);
-	rc |= read(SENSOR_READ_DIE_TEMPERATURE);
-	rc |= read(SENSOR_READ_VOLTAGE);
+	bool ready;
+	if(!fresh(&ready)){
+		return false;
+	}
 
 	/*
-	 * Sleep the device
+	 * Nothing new, the cache stays
 	 */
-	rc |= set_state(SENSOR_STATE_SLEEP);
+	if(!ready){
+		return true;
+	}
 
-	return (rc);
+#ifdef I2C_ASYNC
+	return submit_burst();
+#else
+	return get_burst();
+#endif
 }
 
 
@@ -253,12 +283,12 @@ bool tmp006::reset(int arg){
 	/*
 	 * Create the command
 	 */
-	regs.status_byte ^= TMP006_SOFT_RESET;
+	uint16_t command = regs.status_byte | TMP006_SOFT_RESET;
 
 	/*
-	 * Write the command twice for reset
+	 * Write the command, the bit clears itself
 	 */
-	if(!edit_conf(regs.status_byte)){
+	if(!edit_conf(command)){
 
 		/*
 		 * IO Error
@@ -266,14 +296,13 @@ bool tmp006::reset(int arg){
 		err = SENSOR_ERR_IO;
 		return false;
 	}
-	if(!edit_conf(regs.status_byte)){
 
-		/*
-		 * IO Error
-		 */
-		err = SENSOR_ERR_IO;
-		return false;
-	}
+	/*
+	 * Back to the power on configuration, first conversion
+	 * one period away
+	 */
+	regs.status_byte = TMP006_CONF_DEFAULT;
+	set_conv_period(regs.status_byte);
 
 	/*
 	 * No problem
@@ -386,31 +415,7 @@ bool tmp006::ioctl(sensor_command_t cmd, void *arg){
 
 	case SENSOR_READ_SCALAR:
 	{
-		if(! get_die_temp()){
-
-			/*
-			 * Problem
-			 */
-			return false;
-		}else if(! get_obj_temp()){
-
-			/*
-			 * Problem
-			 */
-			return false;
-		}else if(! get_volt()){
-
-			/*
-			 * Problem
-			 */
-			return false;
-		}else {
-
-			/*
-			 * All good
-			 */
-			return true;
-		}
+		return get_burst();
 	};
 	}
 }
@@ -576,14 +581,172 @@ bool tmp006::get_state(sensor_state_t *mode){
 bool tmp006::get_device_id(){
 
 	/*
-	 * Get the device id
+	 * Get the device id, MSB first, one register at a time
+	 */
+	return (get_word((uint8_t)TMP006_MAN_ID, &id.man_id) &&
+			get_word((uint8_t)TMP006_CHIP_ID, &id.dev_id));
+}
+
+/**
+ * @brief Checks for a new conversion.
+ *
+ * Nothing goes on the bus before the conversion is due, then
+ * the data ready bit is polled.
+ *
+ * @param ready     Set true if a new conversion is ready
+ * @return bool     true if the call succeeds, else false is returned.
+ */
+bool tmp006::fresh(bool* ready){
+
+	clock_us_t now = sys_clock::now();
+	*ready = false;
+
+	/*
+	 * Still converting
+	 */
+	if(now < conv_next){
+		return true;
+	}
+
+	uint16_t config;
+	if(!get_word(TMP006_CONFIGURATION, &config)){
+		return false;
+	}
+
+	/*
+	 * Late on the device clock, look again in an eighth of a period
+	 */
+	if(!(config & TMP006_DATA_READY)){
+		conv_next = now + (conv_period / 8);
+		return true;
+	}
+
+	/*
+	 * The conversion ended since the last look, the next one is
+	 * polled a little ahead of its period
+	 */
+	conv_next = now + conv_period - (conv_period / 8);
+	*ready = true;
+	return true;
+}
+
+/**
+ * @brief Reads a conversion, voltage and die temperature.
+ *
+ * The register pointer does not increment, so the two registers
+ * are two repeated start reads back to back.
+ *
+ * @return bool     true if the call succeeds, else false is returned.
+ */
+bool tmp006::get_burst(){
+
+	if(!get_volt() || !get_die_temp()){
+		return false;
+	}
+
+	clock_us_t now 				= sys_clock::now();
+	cache.voltage.timestamp 	= now;
+	cache.temp_die.timestamp 	= now;
+	cache.temp_obj.timestamp 	= now;
+
+	return get_obj_temp();
+}
+
+#ifdef I2C_ASYNC
+/**
+ * @brief Queues the reads of a conversion.
+ *
+ * The same two reads as get_burst(), on the transaction queue.
+ * The conversion is decoded by end_burst() once they ended.
+ *
+ * @return bool     true if the reads were queued.
+ */
+bool tmp006::submit_burst(){
+
+	static const uint8_t indexes[2] = {TMP006_VOLTAGE, TMP006_TEMPERATURE};
+
+	for(uint8_t i = 0; i < 2; i++){
+		conv_txn[i].addr 		= TMP006_I2C_ADDR;
+		conv_txn[i].index 		= indexes[i];
+		conv_txn[i].data 		= conv_raw[i];
+		conv_txn[i].size 		= TMP006_TRANSACTION_BYTE;
+		conv_txn[i].dir 		= I2C_TXN_READ;
+		conv_txn[i].done 		= NULL;
+		conv_txn[i].context 	= this;
+	}
+
+	/*
+	 * The last one ends the conversion read
+	 */
+	conv_txn[1].done = conv_done;
+
+	if(STATUS_OK != i2c_queue::submit(&conv_txn[0])){
+		err = SENSOR_ERR_IO;
+		return false;
+	}
+
+	/*
+	 * No room for the second, the first still has to end
 	 */
-	if(bus->read_bytes(
-				TMP006_I2C_ADDR,				// Destination
-				sizeof(tmp006_id_regs_t),		// Size to read
-				(uint8_t)TMP006_ID_ADDR,		// Memory index to read from
-				(uint8_t*)&id					// Where to store the value
-			) != sizeof(tmp006_id_regs_t)){
+	conv_pending = true;
+	if(STATUS_OK != i2c_queue::submit(&conv_txn[1])){
+		conv_txn[1].state = I2C_TXN_FAILED;
+	}
+	return true;
+}
+
+/**
+ * @brief Stamps a conversion read (interrupt context).
+ *
+ * @param txn       The last read of the conversion
+ */
+void tmp006::conv_done(i2c_transaction_t* txn){
+	((tmp006*)txn->context)->conv_at = sys_clock::now();
+}
+
+/**
+ * @brief Decodes a queued conversion read.
+ *
+ * @return bool     true if both reads completed.
+ */
+bool tmp006::end_burst(){
+
+	if((I2C_TXN_DONE != conv_txn[0].state) || (I2C_TXN_DONE != conv_txn[1].state)){
+		err = SENSOR_ERR_IO;
+		return false;
+	}
+
+	/*
+	 * MSB first, the die temperature 14 bits left justified
+	 */
+	int16_t volt = (int16_t)(((uint16_t)conv_raw[0][0] << 8) | conv_raw[0][1]);
+	int16_t temp = (int16_t)(((uint16_t)conv_raw[1][0] << 8) | conv_raw[1][1]);
+
+	cache.voltage.voltage.value 		= volt;
+	cache.temp_die.temperature.value 	= temp >> TMP006_TEMP_SHIFT;
+	cache.temps.die_temp 				= \
+			cache.temp_die.temperature.value * TMP006_CELCIUS_CONV;
+
+	cache.voltage.timestamp 	= conv_at;
+	cache.temp_die.timestamp 	= conv_at;
+	cache.temp_obj.timestamp 	= conv_at;
+
+	return get_obj_temp();
+}
+#endif
+
+/**
+ * @brief Reads a 16 bit register, MSB first.
+ *
+ * @param index     The register to read
+ * @param value     Where to store the value
+ * @return bool     true if the call succeeds, else false is returned.
+ */
+bool tmp006::get_word(uint8_t index, uint16_t* value){
+
+	uint8_t raw[TMP006_TRANSACTION_BYTE];
+
+	if(sizeof(raw) != bus->read_block(TMP006_I2C_ADDR, index, raw, sizeof(raw))){
 
 		/*
 		 * Error present
@@ -592,33 +755,36 @@ bool tmp006::get_device_id(){
 		return false;
 	}
 
-	/*
-	 * Return the bus status
-	 */
-	return (STATUS_OK == bus->get_status());
+	*value = ((uint16_t)raw[0] << 8) | raw[1];
+	return true;
 }
 
 /**
- * @brief Read TMP006 temperature data.
+ * @brief Sets the conversion period from the configuration.
  *
- * This function obtains temperature data from the Texas Instruments
- * device.  The data is read from the 1 16 bit register.
+ * @param config    The configuration register value
+ */
+void tmp006::set_conv_period(uint16_t config){
+
+	uint16_t rate = (config & TMP006_CONV_RATE_MASK) >> TMP006_CONV_RATE_SHIFT;
+	if(rate >= ARRAYSIZE(conv_times)){
+		rate = ARRAYSIZE(conv_times) - 1;
+	}
+
+	conv_period 	= (uint32_t)conv_times[rate] * 1000;
+	conv_next 		= sys_clock::now() + conv_period;
+}
+
+/**
+ * @brief Computes the TMP006 object temperature.
  *
- * Along with the actual sensor data, the LSB byte contains a "new" flag
- * indicating if the data for this axis has been updated since the last
- * time the axis data was read.  Reading either LSB or MSB data will
- * clear this flag.
+ * The object temperature is computed from the cached sensor
+ * voltage and die temperature, the bus is not used.
  *
  * @return bool     true if the call succeeds, else false is returned.
  */
 bool tmp006::get_obj_temp(){
 
-	/*
-	 * We read the object temperature
-	 */
-	get_volt();
-	get_die_temp();
-
 	/*
 	 * Get the values
 	 */
@@ -675,31 +841,22 @@ bool tmp006::get_obj_temp(){
  */
 bool tmp006::get_die_temp(){
 
-	if(TMP006_TRANSACTION_BYTE != bus->read_bytes(
-				TMP006_I2C_ADDR,				// Destination
-				TMP006_TRANSACTION_BYTE,		// Size to read
-				(uint8_t)TMP006_TEMPERATURE,	// Memory index to read from
-				(uint8_t*)&cache.temp_die.temperature.value	// Where to store the value
-			)){
-
-		/*
-		 * Error present
-		 */
-		err = SENSOR_ERR_DRIVER;
+	uint16_t value;
+	if(!get_word(TMP006_TEMPERATURE, &value)){
 		return false;
 	}
 
+	/*
+	 * Signed, 14 bits left justified
+	 */
+	cache.temp_die.temperature.value = ((int16_t)value) >> TMP006_TEMP_SHIFT;
 
 	/*
 	 * Set the double value
 	 */
 	cache.temps.die_temp = \
 			cache.temp_die.temperature.value * TMP006_CELCIUS_CONV;
-
-	/*
-	 * Return the bus status
-	 */
-	return (STATUS_OK == bus->get_status());
+	return true;
 
 }
 
@@ -712,24 +869,12 @@ bool tmp006::get_die_temp(){
  */
 bool tmp006::get_volt(){
 
-	if(TMP006_TRANSACTION_BYTE != bus->read_bytes(
-				TMP006_I2C_ADDR,				// Destination
-				TMP006_TRANSACTION_BYTE,		// Size to read
-				(uint8_t)TMP006_VOLTAGE,		// Memory index to read from
-				(uint8_t*)&cache.voltage.voltage.value	// Where to store the value
-			)){
-
-		/*
-		 * Error present
-		 */
-		err = SENSOR_ERR_DRIVER;
+	uint16_t value;
+	if(!get_word(TMP006_VOLTAGE, &value)){
 		return false;
 	}
-
-	/*
-	 * Return the bus status
-	 */
-	return (STATUS_OK == bus->get_status());
+	cache.voltage.voltage.value = (int16_t)value;
+	return true;
 
 }
 
@@ -746,16 +891,14 @@ bool tmp006::get_volt(){
  */
 void tmp006::enable(bool enable){
 
-	uint16_t const power_mode_val = (enable == true)
-			? (TMP006_ENABLE) : (TMP006_DISABLE);
-
 	// Container
-	regs.status_byte |= power_mode_val;
+	uint16_t const config = (enable == true)
+			? (regs.status_byte | TMP006_ENABLE) : (regs.status_byte & ~TMP006_ENABLE);
 
 	/*
-	 * Return the state of the bus
+	 * Write through the configuration shadow
 	 */
-	edit_conf(regs.status_byte);
+	edit_conf(config);
 	return;
 }
 
@@ -776,14 +919,10 @@ void tmp006::poweroff(bool enable){
 	uint16_t const power_mode_val = (enable == true)
 			? (TMP006_POWER_DOWN) : (TMP006_CONT_CONV);
 
-
-	// Container
-	regs.status_byte |= power_mode_val;
-
 	/*
-	 * Return the state of the bus
+	 * Write through the configuration shadow
 	 */
-	edit_conf(regs.status_byte);
+	edit_conf((regs.status_byte & ~TMP006_MODE_MASK) | power_mode_val);
 	return;
 
 }
@@ -797,12 +936,18 @@ void tmp006::poweroff(bool enable){
 bool tmp006::set_conv_rate (tmp006_conv_rate_t *rate){
 
 	// Container
-	regs.status_byte |= (uint16_t)(*rate);
+	uint16_t config = (regs.status_byte & ~TMP006_CONV_RATE_MASK) |
+			((uint16_t)(*rate) & TMP006_CONV_RATE_MASK);
+
+	if(!edit_conf(config)){
+		return false;
+	}
 
 	/*
-	 * Return the state of the bus
+	 * The new rate restarts the conversion
 	 */
-	return edit_conf(regs.status_byte);
+	set_conv_period(config);
+	return true;
 }
 
 /**
@@ -813,39 +958,45 @@ bool tmp006::set_conv_rate (tmp006_conv_rate_t *rate){
  */
 bool tmp006::get_conv_rate (tmp006_conv_rate_t *rate){
 
-	if(sizeof(tmp006_event_regs_t) != bus->read_bytes(
-				TMP006_I2C_ADDR,					// Destination
-				sizeof(tmp006_event_regs_t),		// Size to read
-				(uint8_t)TMP006_BURST_ADDR,			// Memory index to read from
-				(uint8_t*)&regs						// Where to store the value
-			)){
-
-		/*
-		 * Error present
-		 */
-		err = SENSOR_ERR_DRIVER;
+	uint16_t config;
+	if(!get_word(TMP006_CONFIGURATION, &config)){
 		return false;
 	}
 
 	/*
-	 * Return the bus status
+	 * Return the rate field
 	 */
-	*rate = (tmp006_conv_rate_t)regs.status_field.conversion;
-	return (STATUS_OK == bus->get_status());
+	*rate = (tmp006_conv_rate_t)(config & TMP006_CONV_RATE_MASK);
+	return true;
 }
 
 /**
  * @brief Write to the config regs.
  *
+ * regs.status_byte shadows the register, an unchanged value is
+ * not written and a failed write leaves the shadow as it was.
+ *
  * @param value		The value to write
  */
 bool tmp006::edit_conf(uint16_t value){
 
-	if(TMP006_TRANSACTION_BYTE != bus->read_bytes(
+	/*
+	 * The device has it already
+	 */
+	if(value == regs.status_byte){
+		return true;
+	}
+
+	/*
+	 * MSB first
+	 */
+	uint8_t raw[TMP006_TRANSACTION_BYTE] = {(uint8_t)(value >> 8), (uint8_t)value};
+
+	if(TMP006_TRANSACTION_BYTE != bus->write_bytes(
 				TMP006_I2C_ADDR,					// Destination
-				TMP006_TRANSACTION_BYTE,			// Size to read
-				(uint8_t)TMP006_CONFIGURATION,		// Memory index to read from
-				(uint8_t*)&value					// Where to store the value
+				TMP006_TRANSACTION_BYTE,			// Size to write
+				(uint8_t)TMP006_CONFIGURATION,		// Memory index to write to
+				raw									// The value to write
 			)){
 
 		/*
@@ -855,8 +1006,6 @@ bool tmp006::edit_conf(uint16_t value){
 		return false;
 	}
 
-	/*
-	 * Return the state of the bus
-	 */
-	return (STATUS_OK == bus->get_status());
+	regs.status_byte = value;
+	return true;
 }
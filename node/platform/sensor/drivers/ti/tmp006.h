@@ -9,6 +9,7 @@
 #define PLATFORM_SENSOR_DRIVERS_TI_TMP006_H_
 
 #include <platform/sensor/sensor/i2c/sensor_i2c.h>
+#include <platform/bus/i2c/i2c_queue.h>
 
 /* TWI/I2C address (write @ 0x16 on bus, read @ 0x17 on bus) */
 #define TMP006_I2C_ADDR         	(0x18)
@@ -114,14 +115,25 @@ typedef struct {
 //! Mode settings
 #define TMP006_POWER_DOWN			(0x0000)
 #define TMP006_CONT_CONV			(0x7000)
+#define TMP006_MODE_MASK			(0x7000)
 
-//! Enable bit settings
-#define TMP006_ENABLE				(1 << 9)
+//! Conversion rate field, see tmp006_conv_rate_t
+#define TMP006_CONV_RATE_MASK		(0x0E00)
+#define TMP006_CONV_RATE_SHIFT		(9)
+
+//! Enable bit settings (DRDY pin)
+#define TMP006_ENABLE				(1 << 8)
 #define TMP006_DISABLE				(0 << 0)
 
 //! Data ready bit settings
-#define TMP006_DATA_READY			(1 << 8)
-#define TMP006_CONV_PROG			(0 << 8)
+#define TMP006_DATA_READY			(1 << 7)
+#define TMP006_CONV_PROG			(0 << 7)
+
+//! Power on configuration, continuous conversion at 1 Hz
+#define TMP006_CONF_DEFAULT			(TMP006_CONT_CONV | TMP006_CONV_RATE_1Hz)
+
+//! Die temperature, 14 bits left justified
+#define TMP006_TEMP_SHIFT			(2)
 
 /* TMP006 Manufacturer Id 			(0xFE)*/
 
@@ -174,6 +186,23 @@ class tmp006: public sensor_i2c_t {
 		 */
 		tmp006_cache_t 					cache;
 
+		/*
+		 * Conversion timing, the next conversion is not polled
+		 * before conv_next
+		 */
+		uint32_t						conv_period;
+		clock_us_t						conv_next;
+
+#ifdef I2C_ASYNC
+		/*
+		 * Queued conversion read, voltage then die temperature
+		 */
+		i2c_transaction_t				conv_txn[2];
+		uint8_t							conv_raw[2][TMP006_TRANSACTION_BYTE];
+		volatile clock_us_t				conv_at;
+		bool							conv_pending;
+#endif
+
 	/*
 	 * Public class methods
 	 */
@@ -348,15 +377,73 @@ class tmp006: public sensor_i2c_t {
 		bool get_device_id();
 
 		/**
-		 * @brief Read TMP006 temperature data.
+		 * @brief Checks for a new conversion.
 		 *
-		 * This function obtains temperature data from the Texas Instruments
-		 * device.  The data is read from the 1 16 bit register.
+		 * Nothing goes on the bus before the conversion is due, then
+		 * the data ready bit is polled.
 		 *
-		 * Along with the actual sensor data, the LSB byte contains a "new" flag
-		 * indicating if the data for this axis has been updated since the last
-		 * time the axis data was read.  Reading either LSB or MSB data will
-		 * clear this flag.
+		 * @param ready     Set true if a new conversion is ready
+		 * @return bool     true if the call succeeds, else false is returned.
+		 */
+		bool fresh(bool* ready);
+
+		/**
+		 * @brief Reads a conversion, voltage and die temperature.
+		 *
+		 * Two repeated start reads back to back, the object
+		 * temperature is computed from them.
+		 *
+		 * @return bool     true if the call succeeds, else false is returned.
+		 */
+		bool get_burst();
+
+#ifdef I2C_ASYNC
+		/**
+		 * @brief Queues the reads of a conversion.
+		 *
+		 * The same two reads as get_burst(), on the transaction queue.
+		 * The conversion is decoded by end_burst() once they ended.
+		 *
+		 * @return bool     true if the reads were queued.
+		 */
+		bool submit_burst();
+
+		/**
+		 * @brief Stamps a conversion read (interrupt context).
+		 *
+		 * @param txn       The last read of the conversion
+		 */
+		static void conv_done(i2c_transaction_t* txn);
+
+		/**
+		 * @brief Decodes a queued conversion read.
+		 *
+		 * @return bool     true if both reads completed.
+		 */
+		bool end_burst();
+#endif
+
+		/**
+		 * @brief Reads a 16 bit register, MSB first.
+		 *
+		 * @param index     The register to read
+		 * @param value     Where to store the value
+		 * @return bool     true if the call succeeds, else false is returned.
+		 */
+		bool get_word(uint8_t index, uint16_t* value);
+
+		/**
+		 * @brief Sets the conversion period from the configuration.
+		 *
+		 * @param config    The configuration register value
+		 */
+		void set_conv_period(uint16_t config);
+
+		/**
+		 * @brief Computes the TMP006 object temperature.
+		 *
+		 * The object temperature is computed from the cached sensor
+		 * voltage and die temperature, the bus is not used.
 		 *
 		 * @return bool     true if the call succeeds, else false is returned.
 		 */
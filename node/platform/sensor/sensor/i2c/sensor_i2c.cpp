@@ -21,6 +21,11 @@ sensor_i2c::sensor_i2c(bus_i2c_t* iface, uint8_t resolution): sensor() {
 
 	bus 		= iface;
 	set_resolution(resolution);
+
+	/*
+	 * No shadow until the driver sets it up
+	 */
+	shadow_init(0, 0, 0, 0, false);
 }
 
 /**
@@ -48,3 +53,140 @@ uint8_t sensor_i2c::get_resolution(){
 	 */
 	return transaction_resolution;
 }
+
+/**
+ * @brief Sets up the register shadow of the device.
+ *
+ * @param addr				The device address
+ * @param first				The first cached register
+ * @param count				The number of registers (SENSOR_SHADOW_SIZE max)
+ * @param uncached			The registers not cached, one bit per register from first
+ * @param burst				True if the device increments the index on writes
+ */
+void sensor_i2c::shadow_init(uint8_t addr, uint8_t first, uint8_t count,
+		uint64_t uncached, bool burst){
+
+	shadow_addr 		= addr;
+	shadow_first 		= first;
+	shadow_count 		= (count > SENSOR_SHADOW_SIZE) ? SENSOR_SHADOW_SIZE : count;
+	shadow_uncached 	= uncached;
+	shadow_burst 		= burst;
+	shadow_deferred 	= false;
+	shadow_invalidate();
+}
+
+/**
+ * @brief Reads a register, from the shadow when known.
+ *
+ * @param index				The register
+ * @return value			The register value
+ */
+uint8_t sensor_i2c::reg_get(uint8_t index){
+
+	if(!shadowed(index)){
+		return bus->get(shadow_addr, index);
+	}
+
+	/*
+	 * Known, no bus access
+	 */
+	uint64_t bit = 1ULL << (index - shadow_first);
+	if(shadow_valid & bit){
+		return shadow[index - shadow_first];
+	}
+
+	uint8_t value = bus->get(shadow_addr, index);
+	if(STATUS_OK == bus->get_status()){
+		shadow[index - shadow_first] 	= value;
+		shadow_valid 					|= bit;
+	}
+	return value;
+}
+
+/**
+ * @brief Writes a register through the shadow.
+ *
+ * @param index				The register
+ * @param value				The value
+ * @return bool				false if the write failed
+ */
+bool sensor_i2c::reg_put(uint8_t index, uint8_t value){
+
+	if(!shadowed(index)){
+		bus->put(shadow_addr, index, value);
+		return (STATUS_OK == bus->get_status());
+	}
+
+	uint64_t bit = 1ULL << (index - shadow_first);
+	uint8_t* reg = &shadow[index - shadow_first];
+
+	/*
+	 * The device has it already
+	 */
+	if((shadow_valid & bit) && (*reg == value)){
+		return true;
+	}
+
+	*reg 			= value;
+	shadow_valid 	|= bit;
+
+	/*
+	 * Held for reg_flush()
+	 */
+	if(shadow_deferred){
+		shadow_dirty |= bit;
+		return true;
+	}
+
+	bus->put(shadow_addr, index, value);
+	if(STATUS_OK != bus->get_status()){
+
+		/*
+		 * Unknown again
+		 */
+		shadow_valid &= ~bit;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Writes the held registers.
+ *
+ * Each register once with its last value, adjacent registers
+ * in one burst.
+ *
+ * @return bool				false if a write failed
+ */
+bool sensor_i2c::reg_flush(){
+
+	bool ok = true;
+	shadow_deferred = false;
+
+	for(uint8_t i = 0; (i < shadow_count) && shadow_dirty; ){
+
+		if(!(shadow_dirty & (1ULL << i))){
+			i++;
+			continue;
+		}
+
+		/*
+		 * The run of adjacent held registers
+		 */
+		uint8_t run = 1;
+		while(shadow_burst && ((i + run) < shadow_count) &&
+				(shadow_dirty & (1ULL << (i + run)))){
+			run++;
+		}
+
+		uint64_t bits = ((run < 64) ? ((1ULL << run) - 1) : ~0ULL) << i;
+		if(run != bus->write_bytes(shadow_addr, run, shadow_first + i, &shadow[i])){
+			shadow_valid &= ~bits;
+			ok = false;
+		}
+		shadow_dirty &= ~bits;
+		i += run;
+	}
+
+	return ok;
+}
@@ -11,6 +11,11 @@
 #include <platform/bus/i2c/bus_i2c.h>
 #include <platform/sensor/sensor/sensor.h>
 
+/**
+ * @brief The largest register shadow (bytes)
+ */
+#define SENSOR_SHADOW_SIZE			(64)
+
 /**
  * @brief The I2C Sensor Device Interface
  *
@@ -31,6 +36,30 @@ class sensor_i2c : public sensor {
 		bus_packet_t				packet;						/**< Internal bus packet */
 		uint8_t						transaction_resolution;		/**< Transaction Resolution (16bit/8bit) */
 
+		/*
+		 * Register shadow, one bit per register in the masks
+		 */
+		uint8_t						shadow[SENSOR_SHADOW_SIZE];	/**< Register values */
+		uint64_t					shadow_valid;				/**< Known registers */
+		uint64_t					shadow_dirty;				/**< Deferred writes */
+		uint64_t					shadow_uncached;			/**< Registers always on the bus */
+		uint8_t						shadow_addr;				/**< Device address */
+		uint8_t						shadow_first;				/**< First register */
+		uint8_t						shadow_count;				/**< Number of registers */
+		bool						shadow_burst;				/**< Adjacent writes in one burst */
+		bool						shadow_deferred;			/**< Writes held for reg_flush() */
+
+		/**
+		 * @brief Checks if a register is in the shadow.
+		 *
+		 * @param index				The register
+		 * @return bool				True if cached
+		 */
+		bool shadowed(uint8_t index){
+			return ((index >= shadow_first) && (index < (shadow_first + shadow_count)) &&
+					!(shadow_uncached & (1ULL << (index - shadow_first))));
+		}
+
 	/*
 	 * Protected class methods
 	 */
@@ -68,6 +97,111 @@ class sensor_i2c : public sensor {
 		 * @return resolution		The resolution that was set
 		 */
 		uint8_t get_resolution();
+
+		/**
+		 * @brief Sets up the register shadow of the device.
+		 *
+		 * The configuration registers are cached once read or written,
+		 * the read-modify-writes then take a single write and the
+		 * writes of an unchanged value none.
+		 *
+		 * @param addr				The device address
+		 * @param first				The first cached register
+		 * @param count				The number of registers (SENSOR_SHADOW_SIZE max)
+		 * @param uncached			The registers not cached (self clearing, commands),
+		 * 							one bit per register from first
+		 * @param burst				True if the device increments the index on writes
+		 */
+		void shadow_init(uint8_t addr, uint8_t first, uint8_t count,
+				uint64_t uncached, bool burst);
+
+		/**
+		 * @brief Forgets the shadow, after a device reset.
+		 */
+		void shadow_invalidate(){
+			shadow_valid = 0;
+			shadow_dirty = 0;
+		}
+
+		/**
+		 * @brief Reads a register, from the shadow when known.
+		 *
+		 * @param index				The register
+		 * @return value			The register value
+		 */
+		uint8_t reg_get(uint8_t index);
+
+		/**
+		 * @brief Writes a register through the shadow.
+		 *
+		 * @param index				The register
+		 * @param value				The value
+		 * @return bool				false if the write failed
+		 */
+		bool reg_put(uint8_t index, uint8_t value);
+
+		/**
+		 * @brief Sets bits of a register.
+		 *
+		 * @param index				The register
+		 * @param mask				The bits to set
+		 * @return bool				false if the write failed
+		 */
+		bool reg_bitset(uint8_t index, uint8_t mask){
+			return reg_put(index, reg_get(index) | mask);
+		}
+
+		/**
+		 * @brief Clears bits of a register.
+		 *
+		 * @param index				The register
+		 * @param mask				The bits to clear
+		 * @return bool				false if the write failed
+		 */
+		bool reg_bitclear(uint8_t index, uint8_t mask){
+			return reg_put(index, reg_get(index) & ~mask);
+		}
+
+		/**
+		 * @brief Reads a field of a register.
+		 *
+		 * @param index				The register
+		 * @param mask				The field
+		 * @return value			The field value
+		 */
+		uint8_t reg_fieldget(uint8_t index, uint8_t mask){
+			return ((reg_get(index) & mask) / (mask & ~(mask << 1)));
+		}
+
+		/**
+		 * @brief Writes a field of a register.
+		 *
+		 * @param index				The register
+		 * @param mask				The field
+		 * @param value				The field value
+		 * @return bool				false if the write failed
+		 */
+		bool reg_fieldset(uint8_t index, uint8_t mask, uint8_t value){
+			value *= (mask & ~(mask << 1));
+			return reg_put(index, (reg_get(index) & ~mask) | (value & mask));
+		}
+
+		/**
+		 * @brief Holds the shadowed writes until reg_flush().
+		 */
+		void reg_defer(){
+			shadow_deferred = true;
+		}
+
+		/**
+		 * @brief Writes the held registers.
+		 *
+		 * Each register once with its last value, adjacent registers
+		 * in one burst.
+		 *
+		 * @return bool				false if a write failed
+		 */
+		bool reg_flush();
 };
 
 /**
@@ -6,6 +6,7 @@
  */
 
 #include <platform/sensor/sensor/sensor.h>
+#include <driverlib/interrupt.h>
 
 /*
  * Events
@@ -32,6 +33,82 @@ void sensor::irq_connect(uint32_t pin, uint8_t mode, sensor_int_handler handler)
 	return;
 }
 
+/*
+ * The BIOS interrupt notification
+ */
+void (*sensor::irq_notify)(sensor* sensor) = NULL;
+
+/*
+ * Data ready reader, set by the sampler
+ */
+void (*sensor::ready_notify)(sensor* sensor) = NULL;
+
+/**
+ * @brief Captures an interrupt (top half, ISR safe).
+ *
+ * Only stamps the time and counts, the bus is left to the
+ * bottom half. Captures pending at once are coalesced.
+ */
+void sensor::irq_capture(){
+
+	/*
+	 * First pending capture, stamp it
+	 */
+	if (irq_count == irq_served) {
+		irq_timestamp = sys_clock::now();
+	}
+	irq_count = irq_count + 1;
+
+	/*
+	 * Schedule the bottom half
+	 */
+	if (irq_notify) {
+		irq_notify(this);
+	}
+}
+
+/**
+ * @brief Runs the deferred interrupt work (bottom half).
+ *
+ * Called in task context (BIOS loop or DAQ), never from an ISR,
+ * so the bus is never shared with a transaction in flight.
+ *
+ * @return	bool	true if an interrupt was pending
+ */
+bool sensor::irq_service(){
+
+	/*
+	 * Snapshot, the ISR keeps counting behind us
+	 */
+	uint16_t count = irq_count;
+	if (count == irq_served) {
+		return false;
+	}
+
+	uint16_t pending = count - irq_served;
+	irq_coalesced += pending - 1;
+
+	/*
+	 * Bus access and callbacks
+	 */
+	irq_work(irq_timestamp, pending);
+
+	/*
+	 * Release the slot and stamp a capture made during the work, which
+	 * the ISR could not stamp. Masked, so a capture right after the
+	 * release keeps its own stamp.
+	 */
+	bool masked = IntMasterDisable();
+	irq_served = count;
+	if (irq_count != count) {
+		irq_timestamp = sys_clock::now();
+	}
+	if (!masked) {
+		IntMasterEnable();
+	}
+	return true;
+}
+
 /**
  * \brief Install a sensor event handler.
  *
@@ -84,17 +161,17 @@ bool sensor::event(sensor_event_t sensor_event, sensor_event_callback handler,
 /**
  * \brief This function returns the current timestamp counter value.
  *
- * The timestamp facility is implemented in terms of the XMEGA or UC3
- * timer and clock function APIs.
+ * The timestamp facility is implemented in terms of the system
+ * monotonic clock.
  *
  * \return The current counter value (microseconds).
  */
-uint32_t sensor::timestamp(void){
+clock_us_t sensor::timestamp(void){
 
 	/*
-	 * return the millis past since bootup
+	 * return the us past since bootup
 	 */
-	return millis();
+	return sys_clock::now();
 }
 
 /**
@@ -11,6 +11,7 @@
 #include <configs.h>
 #include "physics/physics.h"
 #include <platform/bus/bus.h>
+#include <platform/clock/clock.h>
 //#include <service/services/coms/coms.h>
 
 /** \brief Sensor Type Constants */
@@ -140,10 +141,24 @@ typedef struct {
 		} acc;
 	};
 
-	uint32_t timestamp;             /**< Data sample timestamp */
+	clock_us_t timestamp;           /**< Data sample timestamp (us) */
 	bool scaled;                    /**< Data sample format (true => scaled) */
 } sensor_data_t;
 
+/** \brief Timed sample (sampler) */
+typedef struct {
+	clock_us_t timestamp;           /**< Read time (us) */
+	int16_t value[3];               /**< Raw axis values */
+	uint16_t late;                  /**< Read time past the trigger (us) */
+} sensor_sample_t;
+
+/** \brief Sampling trigger */
+typedef enum {
+	SENSOR_TRIGGER_TIMER,           /**< MCU timer, one read per tick */
+	SENSOR_TRIGGER_DATA_READY,      /**< New data interrupt, one read per sample */
+	SENSOR_TRIGGER_FIFO             /**< FIFO watermark interrupt, one drain per batch */
+} sensor_trigger_t;
+
 /** \brief Sensor Data Read Operations */
 typedef enum {
 	SENSOR_READ_ACCELERATION,       /**< Read acceleration data */
@@ -462,6 +477,7 @@ typedef struct {
 	sensor_units_t units;            /**< Data sample base engineering units */
 	sensor_scale_t scale;            /**< Data sample engineering unit scale */
 	const char *name;                /**< Human readable description */
+	uint32_t bus_speed;              /**< Fastest bus clock (Hz), 0 for standard mode */
 } sensor_caps_t;
 
 /** ! \name Sensor Device Descriptors */
@@ -593,10 +609,103 @@ class sensor {
 		/**
 		 * @brief Virtual method to run the update
 		 */
-		bool run(){
+		virtual bool run(){
+			return false;
+		}
+
+		/**
+		 * @brief Reads the raw samples for the sampler.
+		 *
+		 * Runs in the trigger ISR with the bus free: no allocation,
+		 * no cache or state change. One sample, or every FIFO frame.
+		 * The sampler sets the timing fields.
+		 *
+		 * @param	samples	The samples to fill, oldest first
+		 * @param	max		The room in samples
+		 * @return	count	The samples read, 0 if none or the read failed
+		 */
+		virtual uint16_t sample(sensor_sample_t* samples, uint16_t max){
+			return 0;
+		}
+
+		/**
+		 * @brief Prepares the sensor for timed sampling.
+		 *
+		 * The sensor is kept awake with its filter matched to the rate,
+		 * hal.sample_rate is set to the rate the samples come at. An
+		 * interrupt trigger calls ready_notify, per sample or per batch.
+		 *
+		 * @param	rate	The sampling rate (Hz), 0 to stop
+		 * @param	trigger	What paces the reads
+		 * @param	batch	The samples per FIFO watermark interrupt
+		 * @return	bool	false if unsupported
+		 */
+		virtual bool sampling(uint32_t rate, sensor_trigger_t trigger, uint8_t batch){
 			return false;
 		}
 
+		/**
+		 * @brief Stores a block of timed samples in the sensor cache.
+		 *
+		 * Task context, replaces run() while the sampler owns the
+		 * sensor. The other readings may still use the bus.
+		 *
+		 * @param	samples	The samples, oldest first
+		 * @param	count	The number of samples
+		 * @return	bool	true of the update was successful.
+		 */
+		virtual bool commit(const sensor_sample_t* samples, uint16_t count){
+			return false;
+		}
+
+		/**
+		 * @brief Captures an interrupt (top half, ISR safe).
+		 *
+		 * Only stamps the time and counts, the bus is left to the
+		 * bottom half. Captures pending at once are coalesced.
+		 */
+		void irq_capture();
+
+		/**
+		 * @brief Runs the deferred interrupt work (bottom half).
+		 *
+		 * Called in task context (BIOS loop or DAQ), never from an ISR,
+		 * so the bus is never shared with a transaction in flight.
+		 *
+		 * @return	bool	true if an interrupt was pending
+		 */
+		bool irq_service();
+
+		/**
+		 * @brief Gets the interrupts merged into an earlier one.
+		 *
+		 * @return	count	The coalesced interrupts
+		 */
+		uint32_t get_irq_coalesced(){
+			return irq_coalesced;
+		}
+
+		/**
+		 * @brief Gets the sample losses inside the sensor (FIFO overruns).
+		 *
+		 * @return	count	The overruns seen
+		 */
+		uint32_t get_overruns(){
+			return overruns;
+		}
+
+		/*
+		 * Tells the BIOS an interrupt was captured (ISR safe), NULL
+		 * to leave the bottom half to the DAQ task
+		 */
+		static void (*irq_notify)(sensor* sensor);
+
+		/*
+		 * Reads a data ready sample (ISR), NULL while no sampler
+		 * listens to the data ready interrupt
+		 */
+		static void (*ready_notify)(sensor* sensor);
+
 
 	/*
 	 * Protected sensor methods
@@ -609,7 +718,13 @@ class sensor {
 		 * Nothing is done in the constructor as this class is mearly an
 		 * interface to the sensor class.
 		 */
-		sensor(){};
+		sensor(){
+			irq_count 		= 0;
+			irq_served 		= 0;
+			irq_timestamp 	= 0;
+			irq_coalesced 	= 0;
+			overruns		= 0;
+		};
 
 		/*!
 		 *\brief The default deconstructor for the class.
@@ -636,6 +751,29 @@ class sensor {
 		 */
 		void irq_connect(uint32_t pin, uint8_t mode, sensor_int_handler handler);
 
+		/**
+		 * @brief The driver interrupt work: bus access and callbacks.
+		 *
+		 * @param timestamp	When the first pending interrupt fired
+		 * @param count		The interrupts served at once (>1 when coalesced)
+		 */
+		virtual void irq_work(clock_us_t timestamp, uint16_t count){}
+
+		/*
+		 * Interrupt capture, written by the ISR. The timestamp is only
+		 * written while nothing is pending, so the bottom half reads it
+		 * without masking.
+		 */
+		volatile uint16_t		irq_count;
+		volatile uint16_t		irq_served;
+		volatile clock_us_t		irq_timestamp;
+		uint32_t				irq_coalesced;
+
+		/*
+		 * Sample losses inside the sensor, written by the sampler ISR
+		 */
+		volatile uint32_t		overruns;
+
 		/**
 		 * \brief Install a sensor event handler.
 		 *
@@ -661,12 +799,12 @@ class sensor {
 		/**
 		 * \brief This function returns the current timestamp counter value.
 		 *
-		 * The timestamp facility is implemented in terms of the XMEGA or UC3
-		 * timer and clock function APIs.
+		 * The timestamp facility is implemented in terms of the system
+		 * monotonic clock.
 		 *
 		 * \return The current counter value (microseconds).
 		 */
-		uint32_t timestamp(void);
+		clock_us_t timestamp(void);
 
 		/*
 		 * Virtual Methods
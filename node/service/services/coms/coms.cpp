@@ -45,6 +45,17 @@ coms_service::coms_service(){
 	 * Create the mqtt iface
 	 */
 	mqtt_if = new mqtt_t(&wifi_stack, &mqtt_params);
+
+	/*
+	 * Link service starts from the ip wait
+	 */
+	COROUTINE_RESET(&link);
+
+	/*
+	 * Poller state
+	 */
+	link_up 		= false;
+	last_stack_run 	= 0;
 }
 
 /**
@@ -116,8 +127,8 @@ status_code_t coms_service::connect(interface_t iface){
 		 */
 		case INTERFACE_WIFI:
 
-			// Check
-			if(WL_CONNECTED != \
+			// Check, the ip is awaited by service()
+			if(WL_CONNECT_FAILED == \
 					wifi_if->connect(WIFI_SSID, WIFI_PASS)){
 
 				/*
@@ -136,10 +147,7 @@ status_code_t coms_service::connect(interface_t iface){
 		case INTERFACE_BOTH:
 
 			// Check
-			if((ERR_IO_ERROR != \
-					this->connect(INTERFACE_WIFI)) &&
-				ERR_IO_ERROR != \
-					this->connect(INTERFACE_MQTT)){
+			if(ERR_IO_ERROR == this->connect(INTERFACE_WIFI)){
 
 				/*
 				 * Problem
@@ -147,9 +155,13 @@ status_code_t coms_service::connect(interface_t iface){
 				 */
 				system_base::BIOS_alert(BIOS_ALERT_COMS_FAIL);
 				system_base::BIOS_reboot(BIOS_REBOOT_WIFI);
-				system_base::BIOS_reboot(BIOS_REBOOT_MQTT);
 				return ERR_IO_ERROR;
 			}
+
+			/*
+			 * The broker follows from service() once we have an ip
+			 */
+			COROUTINE_RESET(&link);
 			return STATUS_OK;
 
 		default:
@@ -325,6 +337,128 @@ mqtt_status_t coms_service::send(msg_type_t msg_type, msg_t* msg){
 	}
 }
 
+/**
+ * @brief Services the links
+ *
+ * Coroutine run from a task. Waits for the wifi ip, connects
+ * the broker and watches the connection without blocking.
+ */
+void coms_service::service(){
+
+	/*
+	 * Receive led
+	 */
+	mqtt_if->tick();
+
+	COROUTINE_BEGIN(&link);
+
+	/*
+	 * Wait for an IP
+	 */
+	while(!wifi_if->has_ip()){
+		PRINT(".");
+		COROUTINE_SLEEP_FOR(&link, COMS_IP_POLL);
+	}
+
+	/*
+	 * We have an ip
+	 */
+	PRINTLN();
+	PRINT("Ip Address obtained: ");
+	PRINTLN(wifi_if->get_if()->localIP());
+
+#ifdef FLEET_PHASE_SPREAD
+	/*
+	 * A whole fleet reconnects at once after an outage, spread it
+	 */
+	COROUTINE_SLEEP_FOR(&link, random(FLEET_RECONNECT_JITTER_MS));
+#endif
+
+	/*
+	 * Connect the broker, retry later on failure
+	 */
+	while(STATUS_OK != this->connect(INTERFACE_MQTT)){
+#ifdef FLEET_PHASE_SPREAD
+		COROUTINE_SLEEP_FOR(&link, COMS_SERVICE_DELAY + random(FLEET_RECONNECT_JITTER_MS));
+#else
+		COROUTINE_SLEEP_FOR(&link, COMS_SERVICE_DELAY);
+#endif
+	}
+
+	/*
+	 * Watch the connection, start over when it drops
+	 */
+	while(mqtt_if->connected()){
+		COROUTINE_SLEEP_FOR(&link, COMS_SERVICE_DELAY);
+	}
+	NOTIFY_ERROR("Broker connection lost.");
+
+	COROUTINE_END(&link);
+}
+
+/**
+ * @brief Polls the socket and the link, posts their events
+ *
+ * @param obj		The coms object
+ */
+void coms_service::poll_events(void* obj){
+
+	/*
+	 * Cast the object to a coms_service object
+	 */
+	coms_service* coms = (coms_service*)obj;
+
+	/*
+	 * Link change
+	 */
+	bool up = coms->wifi_if->has_ip() && coms->mqtt_if->connected();
+	if(up != coms->link_up){
+		coms->link_up = up;
+		reactor_t::post(REACTOR_EVENT_LINK, 0, up);
+	}
+
+	/*
+	 * Inbound data, or the stack keep alive is due
+	 */
+	if(up && ((coms->wifi_stack.available() > 0) ||
+			((millis() - coms->last_stack_run) >= COMS_KEEPALIVE))){
+		coms->last_stack_run = millis();
+		reactor_t::post(REACTOR_EVENT_NET_READABLE, 0, 0);
+	}
+}
+
+/**
+ * @brief Runs the broker stack on inbound data
+ *
+ * @param event		The event
+ * @param obj		The coms object
+ */
+void coms_service::on_readable(reactor_event_t* event, void* obj){
+
+	/*
+	 * Read and process the inbound messages
+	 */
+	((coms_service*)obj)->mqtt_if->run();
+}
+
+/**
+ * @brief Advances the link service on a link change
+ *
+ * @param event		The event
+ * @param obj		The coms object
+ */
+void coms_service::on_link(reactor_event_t* event, void* obj){
+
+	NOTIFY_INFO("Link " + String(event->argument ? "up" : "down"));
+
+	/*
+	 * Let the link service see the change now, cut its sleep short
+	 */
+	coms_service* coms = (coms_service*)obj;
+	coms->link.wake = millis();
+	coms->service();
+}
+
 /**
  * @brief Processes a local request
  *
@@ -394,6 +528,20 @@ status_code_t coms_service::__process_local(void* obj, void* payload, uint16_t l
 
 			msg_t* json = formatter_t::format(CACHE_TYPE_STATUS);
 			rc = (status_code_t)coms->send(MSG_TYPE_STATUS, json);
+
+#ifdef SCHEDULER_PROFILE
+			// Followed by the scheduler profile, one task per message
+			scheduler_t* sched = \
+				(scheduler_t*)system_base::BIOS_cache(CACHE_TYPE_PROFILE)->node;
+			task_t* task = sched->get_tasks();
+			while(task && (rc == STATUS_OK)){
+				json = formatter_t::format_profile(task);
+				if(json){
+					rc = (status_code_t)coms->send(MSG_TYPE_STATUS, json);
+				}
+				task = task->next;
+			}
+#endif
 			free(packet);
 			break;
 		};
@@ -454,6 +602,42 @@ status_code_t coms_service::__process_local(void* obj, void* payload, uint16_t l
 			break;
 		};
 
+#ifdef FLEET_PHASE_SPREAD
+		/*
+		 * Broker slot assignment, move every task on the slot
+		 */
+		case COMMAND_TYPE_SLOT:
+		{
+			if(length > 2){
+				free(packet);
+				return ERR_BAD_FORMAT;
+			}
+
+			/*
+			 * Each task takes the phase modulo its period, a slot past
+			 * the shortest one would wrap onto an earlier slot
+			 */
+			uint32_t phase 		= (uint32_t)packet->components.argument * FLEET_SLOT_MS;
+			uint32_t shortest 	= 0;
+			for(task_t* task = system_base::scheduler->get_tasks(); task; task = task->next){
+				uint32_t interval = task->get_interval();
+				if(interval && (!shortest || (interval < shortest))){
+					shortest = interval;
+				}
+			}
+			if(shortest && (phase >= shortest)){
+				NOTIFY_ERROR("Slot past the shortest period: " + \
+						String(packet->components.argument));
+				free(packet);
+				return ERR_INVALID_ARG;
+			}
+
+			rc = system_base::BIOS_control(TASK_CTRL_SET_PHASE, TASK_ID_ALL, phase);
+			free(packet);
+			break;
+		};
+#endif
+
 		/*
 		 * No request sent with substance, we sned a heartbeat.
 		 */
@@ -13,6 +13,8 @@
 #include <PubSubClient.h>
 #include <status_codes.h>
 
+#include <task/coroutine.h>
+#include <task/reactor.h>
 #include <platform/iface/wifi.h>
 #include <platform/iface/mqtt.h>
 
@@ -22,6 +24,8 @@
 #define TOPIC_DELIMITER				("/")
 #define COMPARE_SUCCESS 			(0x00)
 #define COMS_SERVICE_DELAY			(1000) // Delay 1 sec
+#define COMS_IP_POLL				(300)  // Ip poll period (ms)
+#define COMS_KEEPALIVE				(1000) // Broker stack service period (ms)
 
 #define ARGUMENT_ERROR				("ARGUMENT ERROR")
 #define ARGUMENT_ERROR_LEN			(strlen(ARGUMENT_ERROR))
@@ -39,6 +43,7 @@ typedef enum {
 	COMMAND_TYPE_SELFTEST,  //!< COMMAND_TYPE_SELFTEST
 	COMMAND_TYPE_GET,       //!< COMMAND_TYPE_GET
 	COMMAND_TYPE_ECHO,		//!< COMMAND_TYPE_ECHO
+	COMMAND_TYPE_SLOT,		//!< COMMAND_TYPE_SLOT
 
 	COMMAND_TYPE_MAX_SIZE   //!< COMMAND_TYPE_MAX_SIZE
 }command_t;
@@ -148,6 +153,14 @@ class coms_service {
 		 */
 		mqtt_status_t send(msg_type_t msg_type, msg_t* msg);
 
+		/**
+		 * @brief Services the links
+		 *
+		 * Coroutine run from a task. Waits for the wifi ip, connects
+		 * the broker and watches the connection without blocking.
+		 */
+		void service();
+
 		/**
 		 * @brief Processes a local request
 		 *
@@ -160,6 +173,29 @@ class coms_service {
 		 */
 		static status_code_t __process_local(void* obj, void* payload, uint16_t length);
 
+		/**
+		 * @brief Polls the socket and the link, posts their events
+		 *
+		 * @param obj		The coms object
+		 */
+		static void poll_events(void* obj);
+
+		/**
+		 * @brief Runs the broker stack on inbound data
+		 *
+		 * @param event		The event
+		 * @param obj		The coms object
+		 */
+		static void on_readable(reactor_event_t* event, void* obj);
+
+		/**
+		 * @brief Advances the link service on a link change
+		 *
+		 * @param event		The event
+		 * @param obj		The coms object
+		 */
+		static void on_link(reactor_event_t* event, void* obj);
+
 	/*
 	 * public attrbute access
 	 */
@@ -186,6 +222,17 @@ class coms_service {
 
 		wifi_t*				wifi_if;
 		wifi_attributes_t 	wifi_attrs;
+
+		/*
+		 * Link coroutine state
+		 */
+		coroutine_t			link;
+
+		/*
+		 * Event poller state
+		 */
+		bool				link_up;
+		uint32_t			last_stack_run;
 };
 
 typedef coms_service coms_t;
@@ -17,6 +17,9 @@ static char acc_json			[50];
 static char temp_json			[50];
 static char heartbeat_json		[50];
 static char status_json			[500];
+#ifdef SCHEDULER_PROFILE
+static char profile_json		[MQTT_MAX_PAYLOAD_SIZE + 1];
+#endif
 
 using namespace system_base;
 
@@ -37,6 +40,11 @@ static const string_table_t string_table[] = {
 		{
 				CACHE_TYPE_STATUS, 		status_json
 		},
+#ifdef SCHEDULER_PROFILE
+		{
+				CACHE_TYPE_PROFILE, 	profile_json
+		},
+#endif
 };
 
 /**
@@ -77,12 +85,20 @@ msg_t* formatter::format(cache_t type){
 	status_cache_t* status_cache;
 
 	// Message type
-	msg_t msg;
+	static msg_t msg;
+
+	/*
+	 * Get the buffer
+	 */
+	char* string = formatter::lookup(type);
+	if(string == NULL){
+		return NULL;
+	}
 
 	/*
 	 * Get the time
 	 */
-	char* time = formatter::convert_time(millis());
+	char* time = formatter::convert_time(sys_clock::now_ms());
 
 	/*
 	 * Switch on the cache type
@@ -105,7 +121,7 @@ msg_t* formatter::format(cache_t type){
 			 * Format
 			 */
 			sprintf(
-					string_table[type].string,
+					string,
 					MQTT_ACC_JSON,
 					time,
 					acc_cache->temp.temperature.value,
@@ -130,7 +146,7 @@ msg_t* formatter::format(cache_t type){
 			 * Format
 			 */
 			sprintf(
-					string_table[type].string,
+					string,
 					MQTT_TEMP_JSON,
 					time,
 					temp_cache->temps.obj_temp,
@@ -154,7 +170,7 @@ msg_t* formatter::format(cache_t type){
 			 * Format
 			 */
 			sprintf(
-					string_table[type].string,
+					string,
 					MQTT_HEARTBEAT_JSON,
 					time,
 					heart_cache->heartbeat_data.alive,
@@ -178,7 +194,7 @@ msg_t* formatter::format(cache_t type){
 			 * Format
 			 */
 			sprintf(
-					string_table[type].string,
+					string,
 					MQTT_STATUS_JSON,
 					time,
 
@@ -191,6 +207,16 @@ msg_t* formatter::format(cache_t type){
 					);
 		}break;
 
+#ifdef SCHEDULER_PROFILE
+		/*
+		 * Scheduler profile update
+		 */
+		case CACHE_TYPE_PROFILE:
+		{
+			return formatter::format_profile((task_t*)NULL);
+		}
+#endif
+
 		/*
 		 * No cache update
 		 */
@@ -201,39 +227,161 @@ msg_t* formatter::format(cache_t type){
 	/*
 	 * Create the string
 	 */
-	msg.data 		= string_table[type].string;
-	msg.length 		= strlen(string_table[type].string);
+	msg.data 		= string;
+	msg.length 		= strlen(string);
 	return &msg;
 }
 
 /**
- * @brief Converts the unsigned long time that is converted to
+ * @brief Looks up the string buffer of a cache type.
+ *
+ * @param 	type			The cache type
+ * @return	string			The buffer, NULL if the type has none
+ */
+char* formatter::lookup(cache_t type){
+
+	/*
+	 * Scan the table
+	 */
+	for(uint8_t i = 0; i < (sizeof(string_table) / sizeof(string_table_t)); i++){
+		if(string_table[i].type == type){
+			return string_table[i].string;
+		}
+	}
+	return NULL;
+}
+
+#ifdef SCHEDULER_PROFILE
+/**
+ * @brief Formats the profile of one task.
+ *
+ * One entry per message, the whole table is over
+ * MQTT_MAX_PAYLOAD_SIZE past a few tasks.
+ *
+ * @param 	task			The task, NULL for the first one
+ * @return	the string		The string formatted, NULL if none
+ */
+msg_t* formatter::format_profile(task_t* task){
+
+	static msg_t msg;
+
+	/*
+	 * Default to the first task
+	 */
+	if(task == NULL){
+		scheduler_t* sched 	= \
+			(scheduler_t*)system_base::BIOS_cache(CACHE_TYPE_PROFILE)->node;
+		task 				= sched->get_tasks();
+		if(task == NULL){
+			return NULL;
+		}
+	}
+
+	/*
+	 * Format, nothing if it does not fit
+	 */
+	char* string = formatter::lookup(CACHE_TYPE_PROFILE);
+	if(!formatter::format_profile(string, formatter::convert_time(sys_clock::now_ms()), task)){
+		NOTIFY_ERROR("Profile too long, task: " + String(task->_id));
+		return NULL;
+	}
+
+	msg.data 		= string;
+	msg.length 		= strlen(string);
+	return &msg;
+}
+
+/**
+ * @brief Formats the scheduler load and one task profile.
+ *
+ * @param 	string			The buffer to format into
+ * @param 	time			The time string
+ * @param 	task			The task
+ * @return	bool			False if it does not fit
+ */
+bool formatter::format_profile(char* string, char* time, task_t* task){
+
+	/*
+	 * Get the scheduler from the cache
+	 */
+	scheduler_t* sched 		= \
+		(scheduler_t*)system_base::BIOS_cache(CACHE_TYPE_PROFILE)->node;
+	task_profile_t* profile = task->get_profile();
+	size_t 		room 		= sizeof(profile_json) - sizeof(MQTT_PROFILE_JSON_END);
+	int 		written;
+	size_t 		length;
+
+	/*
+	 * Header
+	 */
+	written = snprintf(string, room, MQTT_PROFILE_JSON, time, sched->get_load());
+	if((written < 0) || ((size_t)written >= room)){
+		return false;
+	}
+	length = written;
+
+	/*
+	 * The entry, with room left for the close
+	 */
+	written = snprintf(
+			string + length,
+			room - length,
+			MQTT_PROFILE_TASK_JSON,
+			task->_id,
+			(unsigned long)profile->runs,
+			(unsigned long)(profile->runs ? profile->min_us : 0),
+			(unsigned long)task->get_avg_runtime(),
+			(unsigned long)profile->max_us,
+			(unsigned long)profile->missed,
+			profile->latency[0], profile->latency[1],
+			profile->latency[2], profile->latency[3],
+			profile->latency[4], profile->latency[5],
+			profile->latency[6], profile->latency[7]
+			);
+	if((written < 0) || ((size_t)written >= (room - length))){
+		return false;
+	}
+	length += written;
+
+	/*
+	 * Close
+	 */
+	strcpy(string + length, MQTT_PROFILE_JSON_END);
+	return true;
+}
+#endif
+
+/**
+ * @brief Converts the monotonic time that is converted to
  * a time string.
  *
- * Converting the unsinged long value to a string value that is
- * formatted to a conventional time string (i.e. xx:xx:xx)
+ * Converting the ms value to a string value that is formatted
+ * to a conventional time string (i.e. days:hh:mm:ss)
  *
- * @param 	time			The unsigned long time value
+ * @param 	time			The monotonic time in ms
  * @return 	string			The time formatted to the input.
  */
-char* formatter::convert_time(uint32_t time){
+char* formatter::convert_time(uint64_t time){
 
 	/*
 	 * Temp containers
 	 */
-	char* string;
+	static char string[24];
 
-	int days, hours, minutes;
+	uint32_t seconds, days;
+	int hours, minutes;
 
 	/*
 	 * Get the time
 	 */
-	days 			= time / (60 * 60 * 24);
-	time 			-= days * (60 * 60 * 24);
-	hours 			= time / (60 * 60);
-	time 			-= hours * (60 * 60);
-	minutes 		= time / 60;
-
-	sprintf(string, "%d:%d:%d", hours, minutes, time);
+	seconds 		= (uint32_t)(time / 1000);
+	days 			= seconds / (60 * 60 * 24);
+	seconds 		-= days * (60 * 60 * 24);
+	hours 			= seconds / (60 * 60);
+	seconds 		-= hours * (60 * 60);
+	minutes 		= seconds / 60;
+	seconds 		-= minutes * 60;
+
+	sprintf(string, TIME_FORMAT, (unsigned long)days, hours, minutes, (int)seconds);
 	return string;
 }
@@ -11,6 +11,7 @@
 #include <time.h>
 #include <configs.h>
 #include <platform/platform.h>
+#include <task/task.h>
 
 #include "strings.h"
 
@@ -50,22 +51,55 @@ class formatter {
 		 */
 		static msg_t* format(cache_t type);
 
+#ifdef SCHEDULER_PROFILE
+		/**
+		 * @brief Formats the profile of one task.
+		 *
+		 * One entry per message, the whole table is over
+		 * MQTT_MAX_PAYLOAD_SIZE past a few tasks.
+		 *
+		 * @param 	task			The task, NULL for the first one
+		 * @return	the string		The string formatted, NULL if none
+		 */
+		static msg_t* format_profile(task_t* task);
+#endif
+
 	/*
 	 * The Private Access methods
 	 */
 	private:
 
 		/**
-		 * @brief Converts the unsigned long time that is converted to
+		 * @brief Converts the monotonic time that is converted to
 		 * a time string.
 		 *
-		 * Converting the unsinged long value to a string value that is
-		 * formatted to a conventional time string (i.e. xx:xx:xx)
+		 * Converting the ms value to a string value that is formatted
+		 * to a conventional time string (i.e. days:hh:mm:ss)
 		 *
-		 * @param 	time			The unsigned long time value
+		 * @param 	time			The monotonic time in ms
 		 * @return 	string			The time formatted to the input.
 		 */
-		static char* convert_time(uint32_t time);
+		static char* convert_time(uint64_t time);
+
+		/**
+		 * @brief Looks up the string buffer of a cache type.
+		 *
+		 * @param 	type			The cache type
+		 * @return	string			The buffer, NULL if the type has none
+		 */
+		static char* lookup(cache_t type);
+
+#ifdef SCHEDULER_PROFILE
+		/**
+		 * @brief Formats the scheduler load and one task profile.
+		 *
+		 * @param 	string			The buffer to format into
+		 * @param 	time			The time string
+		 * @param 	task			The task
+		 * @return	bool			False if it does not fit
+		 */
+		static bool format_profile(char* string, char* time, task_t* task);
+#endif
 
 };
 
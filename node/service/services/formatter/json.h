@@ -56,10 +56,36 @@
 											"}, "						\
 										"}"								\
 
+/*!
+ * \brief Scheduler profile JSON Structure
+ */
+#define 	MQTT_PROFILE_JSON			"{"								\
+											"time:%s,"					\
+											"sched:{"					\
+												"load:%d,"				\
+												"tasks:["				\
+
+#define 	MQTT_PROFILE_JSON_END				"]"						\
+											"}"							\
+										"}"								\
+
+/*!
+ * \brief Scheduler profile task entry
+ */
+#define 	MQTT_PROFILE_TASK_JSON		"{"								\
+											"id:%d,"					\
+											"runs:%lu,"					\
+											"min:%lu,"					\
+											"avg:%lu,"					\
+											"max:%lu,"					\
+											"miss:%lu,"					\
+											"lat:[%u,%u,%u,%u,%u,%u,%u,%u]"	\
+										"}"								\
+
 /*!
  * \brief Time formatting
  */
-#define 	TIME_FORMAT					"%d:%d:%d"
+#define 	TIME_FORMAT					"%lu:%02d:%02d:%02d"
 
 
 
@@ -11,6 +11,8 @@
 #include <configs.h>
 #include <status_codes.h>
 #include <task/scheduler.h>
+#include <task/reactor.h>
+#include <platform/sampler/sampler.h>
 #include <platform/others/queue.h>
 #include <platform/others/caches.h>
 #include <service/services/coms/coms.h>
@@ -68,6 +70,9 @@ namespace system_base {
 
 	static cache_list_t 		heartbeat_cache;
 	static cache_list_t 		status_cache;
+#ifdef SCHEDULER_PROFILE
+	static cache_list_t 		profile_cache;
+#endif
 
 	/*
 	 * Sensors
@@ -147,6 +152,24 @@ namespace system_base {
 	 */
 	static status_code_t BIOS_boot(task_t* tasks[]);
 
+#ifdef FLEET_PHASE_SPREAD
+	/**
+	 * @brief Gets the phase of this node in the fleet
+	 *
+	 * @return phase		The phase in ms, hashed from DEVICE_ID plus a jitter
+	 */
+	static uint32_t BIOS_phase();
+#endif
+
+#ifdef SCHEDULER_STATIC_TABLE
+	/**
+	 * @brief Dispatches the tasks through a compile time table
+	 *
+	 * @param table			The task table, its tasks booted with BIOS_boot
+	 */
+	static status_code_t BIOS_boot_table(task_table_base* table);
+#endif
+
 	/**
 	 * @brief Runs the BIOS
 	 */
@@ -159,6 +182,61 @@ namespace system_base {
 	 */
 	static void BIOS_suspend(thread_id_t id);
 
+	/**
+	 * @brief Posts a control command to a task (ISR safe)
+	 *
+	 * @param command		The control command
+	 * @param id			The task id, TASK_ID_ALL for every task
+	 * @param argument		The interval or iterations, if any
+	 */
+	static status_code_t BIOS_control(task_ctrl_t command, thread_id_t id, uint32_t argument);
+
+	/**
+	 * @brief Wakes the BIOS out of its idle sleep (ISR safe)
+	 */
+	static void BIOS_wake();
+
+#ifdef BIOS_REACTOR
+	/**
+	 * @brief Posts an event to the BIOS loop (ISR safe)
+	 *
+	 * @param type			The event type
+	 * @param source		The event source
+	 * @param argument		The event argument
+	 */
+	static status_code_t BIOS_event(reactor_event_type_t type, uint8_t source, uint32_t argument);
+
+	/**
+	 * @brief Schedules a sensor interrupt bottom half (ISR safe)
+	 *
+	 * @param sensor		The sensor that captured an interrupt
+	 */
+	static void BIOS_sensor_irq(sensor_t* sensor);
+
+	/**
+	 * @brief Runs the pending sensor interrupt bottom halves
+	 *
+	 * @param event			The sensor event
+	 * @param context		Unused
+	 */
+	static void BIOS_sensor_work(reactor_event_t* event, void* context);
+
+#ifdef SENSOR_SAMPLER
+	/**
+	 * @brief Schedules a deferred sampler read (ISR safe)
+	 */
+	static void BIOS_sampler_irq();
+
+	/**
+	 * @brief Runs a deferred sampler read
+	 *
+	 * @param event			The sampler event
+	 * @param context		Unused
+	 */
+	static void BIOS_sampler_work(reactor_event_t* event, void* context);
+#endif
+#endif
+
 	/**
 	 * @brief Gets the cache of type specified.
 	 *
@@ -205,6 +283,12 @@ namespace system_base {
 	 */
 	static bool update_status_cache();
 
+#ifdef SCHEDULER_PROFILE
+	/**
+	 * @brief Updates the profile cache
+	 */
+	static bool update_profile_cache();
+#endif
 
 	/**
 	 * Implementation
@@ -245,14 +329,50 @@ namespace system_base {
 		system_base::status_cache.sensor			= NULL; 	// No sensor
 
 		/*
-		 * Create the list
+		 * Start the monotonic clock, then boot the scheduler
 		 */
-		list = &heartbeat_cache;
+		sys_clock::start();
+		system_base::scheduler = new scheduler_t();
 
+#ifdef BIOS_REACTOR
 		/*
-		 * Boot the scheduler
+		 * Events wake the scheduler out of its idle sleep
 		 */
-		system_base::scheduler = new scheduler_t();
+		reactor_t::start(system_base::scheduler);
+
+		/*
+		 * Sensor interrupt bottom halves run from the BIOS loop
+		 */
+		sensor_t::irq_notify = system_base::BIOS_sensor_irq;
+		reactor_t::attach(REACTOR_EVENT_SENSOR, system_base::BIOS_sensor_work, NULL);
+
+#ifdef SENSOR_SAMPLER
+		/*
+		 * So are the sampler reads deferred behind a task transaction
+		 */
+		sampler_t::pending_notify = system_base::BIOS_sampler_irq;
+		reactor_t::attach(REACTOR_EVENT_SAMPLER, system_base::BIOS_sampler_work, NULL);
+#endif
+#endif
+
+#ifdef SCHEDULER_PROFILE
+		/*
+		 * Setup the profile cache
+		 */
+		system_base::status_cache.next				= &system_base::profile_cache;
+		system_base::profile_cache.fxn.f_ptr 		= system_base::update_profile_cache;
+		system_base::profile_cache.node				= system_base::scheduler;
+		system_base::profile_cache.type 			= CACHE_TYPE_PROFILE;
+		system_base::profile_cache.msg				= MSG_TYPE_STATUS;
+		system_base::profile_cache.next				= NULL;
+		system_base::profile_cache.prev				= &system_base::status_cache;
+		system_base::profile_cache.sensor			= NULL; 	// No sensor
+#endif
+
+		/*
+		 * Create the list
+		 */
+		list = &heartbeat_cache;
 
 		/*
 		 * Add the sensors
@@ -262,6 +382,20 @@ namespace system_base {
 		for(uint8_t i = 0; i < (NUMBER_OF_SENSORS +1); i ++){
 			system_base::sensors_base[i] = sensors[i];
 		}
+
+#ifdef SENSOR_SAMPLER
+		/*
+		 * The first accelerometer is read by the hardware timer
+		 */
+		for(uint8_t i = 0; sensors[i]; i ++){
+			if(sensors[i]->type & SENSOR_TYPE_ACCELEROMETER){
+				if(STATUS_OK != sampler_t::start(sensors[i], SAMPLER_RATE_HZ)){
+					NOTIFY_ERROR("Sampler not started, DAQ reads.");
+				}
+				break;
+			}
+		}
+#endif
 		NOTIFY_INFO("System BIOS Booted.");
 		digitalWrite(STATUS_LED, HIGH);
 		return STATUS_OK;
@@ -457,7 +591,8 @@ namespace system_base {
 				 * Update
 				 */
 				if((temp->type != CACHE_TYPE_HEARTBEAT) &&
-						(temp->type != CACHE_TYPE_STATUS)){
+						(temp->type != CACHE_TYPE_STATUS) &&
+						(temp->type != CACHE_TYPE_PROFILE)){
 
 
 					/*
@@ -486,7 +621,8 @@ namespace system_base {
 				 * Look for the type to update
 				 */
 				if((type != CACHE_TYPE_HEARTBEAT) &&
-						(type != CACHE_TYPE_STATUS)){
+						(type != CACHE_TYPE_STATUS) &&
+						(type != CACHE_TYPE_PROFILE)){
 
 					/*
 					 * We need to update the caches that require a sensor handle
@@ -539,9 +675,82 @@ namespace system_base {
 			NOTIFY_INFO("Adding task: " + String(tasks[i]->_id));
 			system_base::scheduler->add_task(tasks[i]);
 		}
+
+#ifdef FLEET_PHASE_SPREAD
+		/*
+		 * Spread the fleet, every task moves by the same phase
+		 */
+		randomSeed(DEVICE_ID ^ (uint32_t)sys_clock::now());
+		uint32_t phase = BIOS_phase();
+
+		NOTIFY_INFO("Fleet phase: " + String(phase) + "ms");
+		for(uint8_t i = 0; i < TASK_NUMBER; i ++){
+			tasks[i]->set_phase(phase);
+		}
+#endif
+
+#ifdef SCHEDULER_ANALYSIS
+		/*
+		 * Check the periods can be met, re-plan or reject otherwise
+		 */
+		status_code_t rc;
+		if((rc = system_base::scheduler->analyze()) != STATUS_OK){
+			return rc;
+		}
+#endif
+
+#ifdef SCHEDULER_WATCHDOG
+		/*
+		 * Watch the tasks from now on
+		 */
+		return system_base::scheduler->watchdog_start();
+#else
 		return STATUS_OK;
+#endif
 	}
 
+#ifdef FLEET_PHASE_SPREAD
+	/**
+	 * @brief Gets the phase of this node in the fleet
+	 *
+	 * @return phase		The phase in ms, hashed from DEVICE_ID plus a jitter
+	 */
+	static uint32_t BIOS_phase(){
+
+		/*
+		 * Integer hash, close ids land far apart
+		 */
+		uint32_t hash = DEVICE_ID;
+		hash ^= hash >> 16;
+		hash *= 0x7FEB352D;
+		hash ^= hash >> 15;
+		hash *= 0x846CA68B;
+		hash ^= hash >> 16;
+
+		return (hash % FLEET_PHASE_MAX_MS) + random(FLEET_JITTER_MS);
+	}
+#endif
+
+#ifdef SCHEDULER_STATIC_TABLE
+	/**
+	 * @brief Dispatches the tasks through a compile time table
+	 *
+	 * @param table			The task table, its tasks booted with BIOS_boot
+	 */
+	static status_code_t BIOS_boot_table(task_table_base* table){
+
+		/*
+		 * Check the table
+		 */
+		if(! table){
+			return ERR_INVALID_ARG;
+		}
+
+		system_base::scheduler->set_table(table);
+		return STATUS_OK;
+	}
+#endif
+
 	/**
 	 * @brief Runs the BIOS
 	 */
@@ -552,7 +761,31 @@ namespace system_base {
 		 */
 		NOTIFY_INFO("Running the scheduler.");
 		BIOS_state(SYS_STATE_ACTIVE);
+
+#ifdef BIOS_REACTOR
+		/*
+		 * Interrupt and socket events first, they are waiting already
+		 */
+		reactor_t::poll();
+		reactor_t::dispatch();
+#endif
+
 		system_base::scheduler->run();
+
+#ifdef BIOS_REACTOR
+		/*
+		 * Events posted by the tasks
+		 */
+		reactor_t::dispatch();
+#endif
+
+#ifdef SCHEDULER_TICKLESS_IDLE
+		/*
+		 * Nothing else is due, sleep until the next deadline
+		 */
+		BIOS_state(SYS_STATE_SLEEP);
+		system_base::scheduler->idle();
+#endif
 	}
 
 	/**
@@ -566,9 +799,87 @@ namespace system_base {
 		 */
 		NOTIFY_INFO("Suspending thread id: " \
 				+ String(id));
-		system_base::scheduler->suspend_queue->push(id);
+		system_base::BIOS_control(TASK_CTRL_SUSPEND, id, 0);
 	}
 
+	/**
+	 * @brief Posts a control command to a task (ISR safe)
+	 *
+	 * @param command		The control command
+	 * @param id			The task id, TASK_ID_ALL for every task
+	 * @param argument		The interval or iterations, if any
+	 */
+	static status_code_t BIOS_control(task_ctrl_t command, thread_id_t id, uint32_t argument){
+		return system_base::scheduler->post(command, id, argument);
+	}
+
+	/**
+	 * @brief Wakes the BIOS out of its idle sleep (ISR safe)
+	 */
+	static void BIOS_wake(){
+		system_base::scheduler->wake();
+	}
+
+#ifdef BIOS_REACTOR
+	/**
+	 * @brief Posts an event to the BIOS loop (ISR safe)
+	 *
+	 * @param type			The event type
+	 * @param source		The event source
+	 * @param argument		The event argument
+	 */
+	static status_code_t BIOS_event(reactor_event_type_t type, uint8_t source, uint32_t argument){
+		return reactor_t::post(type, source, argument);
+	}
+
+	/**
+	 * @brief Schedules a sensor interrupt bottom half (ISR safe)
+	 *
+	 * A full queue loses nothing, the capture stays pending until
+	 * the next sensor event or DAQ pass.
+	 *
+	 * @param sensor		The sensor that captured an interrupt
+	 */
+	static void BIOS_sensor_irq(sensor_t* sensor){
+		reactor_t::post(REACTOR_EVENT_SENSOR, sensor->msg, 0);
+	}
+
+	/**
+	 * @brief Runs the pending sensor interrupt bottom halves
+	 *
+	 * @param event			The sensor event
+	 * @param context		Unused
+	 */
+	static void BIOS_sensor_work(reactor_event_t* event, void* context){
+
+		/*
+		 * Captures are coalesced, serve every sensor with one pending
+		 */
+		for(uint8_t i = 0; system_base::sensors_base[i]; i ++){
+			system_base::sensors_base[i]->irq_service();
+		}
+	}
+
+#ifdef SENSOR_SAMPLER
+	/**
+	 * @brief Schedules a deferred sampler read (ISR safe)
+	 */
+	static void BIOS_sampler_irq(){
+		reactor_t::post(REACTOR_EVENT_SAMPLER, 0, 0);
+	}
+
+	/**
+	 * @brief Runs a deferred sampler read
+	 *
+	 * @param event			The sampler event
+	 * @param context		Unused
+	 */
+	static void BIOS_sampler_work(reactor_event_t* event, void* context){
+		sampler_t::service();
+	}
+#endif
+#endif
+
 	/**
 	 * @brief Hangs the OS
 	 */
@@ -599,6 +910,7 @@ namespace system_base {
 			 */
 			case CACHE_TYPE_HEARTBEAT:
 			case CACHE_TYPE_STATUS:
+			case CACHE_TYPE_PROFILE:
 			case CACHE_TYPE_TEMP_DATA:
 			case CACHE_TYPE_ACC_DATA:
 
@@ -639,7 +951,22 @@ namespace system_base {
 	 */
 	static status_code_t BIOS_register_coms(coms_service* coms){
 		system_base::system_coms = coms;
+
+#ifdef BIOS_REACTOR
+		/*
+		 * The coms react to the socket and the link events
+		 */
+		status_code_t rc;
+		if((rc = reactor_t::add_poller(coms_service::poll_events, coms)) != STATUS_OK){
+			return rc;
+		}
+		if((rc = reactor_t::attach(REACTOR_EVENT_NET_READABLE, coms_service::on_readable, coms)) != STATUS_OK){
+			return rc;
+		}
+		return reactor_t::attach(REACTOR_EVENT_LINK, coms_service::on_link, coms);
+#else
 		return STATUS_OK;
+#endif
 	}
 
 	/**
@@ -689,9 +1016,21 @@ namespace system_base {
 		}
 
 		system_base::status.device_data.alive = state;
-		system_base::status.device_data.runtime = millis();
+		system_base::status.device_data.runtime = (uint32_t)(sys_clock::now_ms() / 1000);
 		return true;
 	}
+
+#ifdef SCHEDULER_PROFILE
+	/**
+	 * @brief Updates the profile cache
+	 *
+	 * The profile is accumulated by the scheduler itself, the
+	 * cache node points straight at it.
+	 */
+	static bool update_profile_cache(){
+		return (system_base::scheduler != NULL);
+	}
+#endif
 }
 
 #endif /* SERVICES_SYSTEM_SYSTEM_H_ */
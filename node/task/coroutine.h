@@ -0,0 +1,94 @@
+/*
+ * coroutine.h
+ */
+
+#ifndef TASK_COROUTINE_H_
+#define TASK_COROUTINE_H_
+
+#include <configs.h>
+#include <task/task.h>
+
+/**
+ * @brief Stackless coroutine state
+ *
+ * Task callbacks have no stack of their own, so a coroutine keeps
+ * its resume point here and every variable that must live across a
+ * yield has to be static (or a member). One state per coroutine.
+ */
+typedef struct {
+
+	uint16_t				line;		// Resume point, 0 at the start
+	uint32_t				wake;		// Wake up time of a sleep (ms)
+}coroutine_t;
+
+/**
+ * @brief Asks the scheduler to resume the running task.
+ *
+ * Only pulls the next run earlier, the regular interval still
+ * applies when the coroutine does not need to come back sooner.
+ *
+ * @param ms				- the time before resuming
+ */
+static inline void coroutine_resume_in(uint32_t ms){
+	task* current = task::running();
+	if(current){
+		current->resume_in(ms);
+	}
+}
+
+/**
+ * @brief Resets a coroutine to its start.
+ */
+#define COROUTINE_RESET(co)			do{ (co)->line = 0; }while(0)
+
+/**
+ * @brief Starts the coroutine body.
+ *
+ * Jumps to the last resume point. A single yield point per line.
+ */
+#define COROUTINE_BEGIN(co)			switch((co)->line){ case 0:
+
+/**
+ * @brief Ends the coroutine body, the next call starts over.
+ */
+#define COROUTINE_END(co)			} (co)->line = 0
+
+/**
+ * @brief Returns and resumes here on the next scheduler pass.
+ */
+#define COROUTINE_YIELD(co)											\
+	do{																\
+		(co)->line = __LINE__;										\
+		coroutine_resume_in(0);										\
+		return;														\
+		case __LINE__:;												\
+	}while(0)
+
+/**
+ * @brief Returns and resumes here once the time has elapsed.
+ */
+#define COROUTINE_SLEEP_FOR(co, ms)									\
+	do{																\
+		(co)->wake = millis() + (ms);								\
+		(co)->line = __LINE__;										\
+		case __LINE__:												\
+		if((int32_t)(millis() - (co)->wake) < 0){					\
+			coroutine_resume_in((co)->wake - millis());				\
+			return;													\
+		}															\
+	}while(0)
+
+/**
+ * @brief Returns on every pass until the condition holds.
+ */
+#define COROUTINE_WAIT_UNTIL(co, cond)								\
+	do{																\
+		(co)->line = __LINE__;										\
+		case __LINE__:												\
+		if(!(cond)){												\
+			coroutine_resume_in(0);									\
+			return;													\
+		}															\
+	}while(0)
+
+#endif /* TASK_COROUTINE_H_ */
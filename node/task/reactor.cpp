@@ -0,0 +1,232 @@
+/*
+ * reactor.cpp
+ */
+
+#include <task/reactor.h>
+#include <driverlib/interrupt.h>
+
+/*
+ * Event queue
+ */
+reactor_event_t			reactor::queue[REACTOR_QUEUE_SIZE];
+volatile uint8_t		reactor::head 			= 0;
+volatile uint8_t		reactor::tail 			= 0;
+volatile uint16_t		reactor::dropped 		= 0;
+
+/*
+ * Handlers
+ */
+reactor_handler_t		reactor::handlers[REACTOR_EVENT_MAX];
+void*					reactor::contexts[REACTOR_EVENT_MAX];
+
+/*
+ * Pollers
+ */
+reactor_poll_t			reactor::pollers[REACTOR_MAX_POLLERS];
+void*					reactor::poll_contexts[REACTOR_MAX_POLLERS];
+uint8_t					reactor::poller_count 	= 0;
+
+scheduler_t*			reactor::sched 			= NULL;
+
+/**
+ * @brief Starts the reactor.
+ *
+ * @param 	target			The scheduler to wake on an event
+ */
+void reactor::start(scheduler_t* target){
+
+	sched = target;
+
+	/*
+	 * Keep polling the sources while idle
+	 */
+	if (sched) {
+		sched->set_sleep(idle_sleep);
+	}
+}
+
+/**
+ * @brief Posts an event (ISR safe).
+ *
+ * Also the entry point of simulated interrupt sources.
+ *
+ * @param 	type			The event type
+ * @param 	source			The event source
+ * @param 	argument		The event argument
+ * @return	status			ERR_BUFFER_OVERFLOW if the queue is full
+ */
+status_code_t reactor::post(reactor_event_type_t type, uint8_t source, uint32_t argument){
+
+	/*
+	 * Sanity check
+	 */
+	if (type >= REACTOR_EVENT_MAX) {
+		return ERR_INVALID_ARG;
+	}
+
+	/*
+	 * Producers may be interrupts, mask them around the slot claim
+	 */
+	bool masked = IntMasterDisable();
+	uint8_t slot = head;
+
+	/*
+	 * Full
+	 */
+	if ((uint8_t)(slot - tail) >= REACTOR_QUEUE_SIZE) {
+		dropped++;
+		if (!masked) {
+			IntMasterEnable();
+		}
+		return ERR_BUFFER_OVERFLOW;
+	}
+
+	/*
+	 * Fill the slot and publish it
+	 */
+	reactor_event_t* event 	= &queue[slot & (REACTOR_QUEUE_SIZE - 1)];
+	event->type 			= type;
+	event->source 			= source;
+	event->argument 		= argument;
+	event->timestamp 		= sys_clock::now();
+	head 					= slot + 1;
+
+	if (!masked) {
+		IntMasterEnable();
+	}
+
+	/*
+	 * Cut the idle period short
+	 */
+	if (sched) {
+		sched->wake();
+	}
+	return STATUS_OK;
+}
+
+/**
+ * @brief Registers the handler of an event type.
+ *
+ * @param 	type			The event type
+ * @param 	handler			The handler, NULL to detach
+ * @param 	context			The context passed to the handler
+ * @return	status			STATUS_ERR_DENIED if already attached
+ */
+status_code_t reactor::attach(reactor_event_type_t type, reactor_handler_t handler, void* context){
+
+	/*
+	 * Sanity check
+	 */
+	if (type >= REACTOR_EVENT_MAX) {
+		return ERR_INVALID_ARG;
+	}
+
+	/*
+	 * One handler per type
+	 */
+	if (handler && handlers[type]) {
+		NOTIFY_ERROR("Event handler already attached: " + String(type));
+		return STATUS_ERR_DENIED;
+	}
+
+	contexts[type] = context;
+	handlers[type] = handler;
+	return STATUS_OK;
+}
+
+/**
+ * @brief Registers an event source poller.
+ *
+ * @param 	fxn				The poller
+ * @param 	context			The context passed to the poller
+ * @return	status			ERR_NO_MEMORY if there is no room
+ */
+status_code_t reactor::add_poller(reactor_poll_t fxn, void* context){
+
+	/*
+	 * Sanity check
+	 */
+	if (!fxn) {
+		return ERR_INVALID_ARG;
+	}
+
+	/*
+	 * No more room
+	 */
+	if (poller_count >= REACTOR_MAX_POLLERS) {
+		return ERR_NO_MEMORY;
+	}
+
+	poll_contexts[poller_count] = context;
+	pollers[poller_count++] 	= fxn;
+	return STATUS_OK;
+}
+
+/**
+ * @brief Runs the pollers.
+ */
+void reactor::poll(){
+
+	for (uint8_t i = 0; i < poller_count; i++) {
+		pollers[i](poll_contexts[i]);
+	}
+}
+
+/**
+ * @brief Dispatches the pending events to their handlers.
+ *
+ * Only the events pending on entry are dispatched, so a handler
+ * posting events cannot starve the scheduler.
+ *
+ * @return	count			The number of events dispatched
+ */
+uint8_t reactor::dispatch(){
+
+	/*
+	 * Temp
+	 */
+	uint8_t 			count 	= 0;
+	uint8_t				end 	= head;
+	reactor_event_t 	event;
+
+	while (tail != end) {
+
+		/*
+		 * Copy out so the slot can be reused by an ISR
+		 */
+		event 	= queue[tail & (REACTOR_QUEUE_SIZE - 1)];
+		tail 	= tail + 1;
+
+		/*
+		 * Handle it
+		 */
+		if (handlers[event.type]) {
+			handlers[event.type](&event, contexts[event.type]);
+		}
+		count++;
+	}
+	return count;
+}
+
+/**
+ * @brief Idle sleep that keeps polling the event sources.
+ *
+ * Wakes every REACTOR_POLL_MS while a poller is registered, the
+ * scheduler then sleeps again until its deadline.
+ *
+ * @param 	ms				The time to sleep
+ */
+void reactor::idle_sleep(uint32_t ms){
+
+	/*
+	 * A poller may find something to do
+	 */
+	poll();
+	if (pending()) {
+		return;
+	}
+	if (poller_count && (ms > REACTOR_POLL_MS)) {
+		ms = REACTOR_POLL_MS;
+	}
+	sleep(ms);
+}
@@ -0,0 +1,179 @@
+/*
+ * reactor.h
+ */
+
+#ifndef TASK_REACTOR_H_
+#define TASK_REACTOR_H_
+
+#include <configs.h>
+#include <status_codes.h>
+#include <platform/clock/clock.h>
+#include "scheduler.h"
+
+/**
+ * @brief The event types
+ *
+ * No timer event, the timed work stays in the scheduler on the task
+ * deadlines.
+ */
+typedef enum {
+
+	REACTOR_EVENT_SENSOR,			//!< A sensor interrupt (source = sensor msg type)
+	REACTOR_EVENT_NET_READABLE,		//!< Data waiting on the broker socket
+	REACTOR_EVENT_LINK,				//!< Link state change (argument = 1 when up)
+	REACTOR_EVENT_SAMPLER,			//!< A sampler trigger waits for the bus
+	REACTOR_EVENT_USER,				//!< Application defined
+	REACTOR_EVENT_MAX				//!< REACTOR_EVENT_MAX
+}reactor_event_type_t;
+
+/**
+ * @brief An event
+ */
+typedef struct {
+
+	uint8_t					type;		//!< The event type
+	uint8_t					source;		//!< The event source, handler defined
+	uint32_t				argument;	//!< The event argument, handler defined
+	clock_us_t				timestamp;	//!< When the event was posted
+}reactor_event_t;
+
+/**
+ * @brief Event handler, called from the BIOS loop (never from an ISR)
+ */
+typedef void (*reactor_handler_t)(reactor_event_t* event, void* context);
+
+/**
+ * @brief Event source poller, posts the events it finds
+ */
+typedef void (*reactor_poll_t)(void* context);
+
+/**
+ * @brief The event reactor
+ *
+ * A single event queue filled by interrupts and pollers and
+ * drained by the BIOS loop, one handler per event type. The
+ * idle sleep wakes every REACTOR_POLL_MS to run the pollers, so a
+ * socket or link change is seen within that time. Posting wakes
+ * the scheduler out of its idle sleep.
+ */
+class reactor {
+
+	/*
+	 * Public access methods
+	 */
+	public:
+
+		/**
+		 * @brief Starts the reactor.
+		 *
+		 * @param 	target			The scheduler to wake on an event
+		 */
+		static void start(scheduler_t* target);
+
+		/**
+		 * @brief Posts an event (ISR safe).
+		 *
+		 * Also the entry point of simulated interrupt sources.
+		 *
+		 * @param 	type			The event type
+		 * @param 	source			The event source
+		 * @param 	argument		The event argument
+		 * @return	status			ERR_BUFFER_OVERFLOW if the queue is full
+		 */
+		static status_code_t post(reactor_event_type_t type, uint8_t source, uint32_t argument);
+
+		/**
+		 * @brief Registers the handler of an event type.
+		 *
+		 * @param 	type			The event type
+		 * @param 	handler			The handler, NULL to detach
+		 * @param 	context			The context passed to the handler
+		 * @return	status			STATUS_ERR_DENIED if already attached
+		 */
+		static status_code_t attach(reactor_event_type_t type, reactor_handler_t handler, void* context);
+
+		/**
+		 * @brief Registers an event source poller.
+		 *
+		 * @param 	fxn				The poller
+		 * @param 	context			The context passed to the poller
+		 * @return	status			ERR_NO_MEMORY if there is no room
+		 */
+		static status_code_t add_poller(reactor_poll_t fxn, void* context);
+
+		/**
+		 * @brief Runs the pollers.
+		 */
+		static void poll();
+
+		/**
+		 * @brief Dispatches the pending events to their handlers.
+		 *
+		 * @return	count			The number of events dispatched
+		 */
+		static uint8_t dispatch();
+
+		/**
+		 * @brief Checks for pending events.
+		 *
+		 * @return	bool			True if an event is waiting
+		 */
+		static bool pending(){
+			return (head != tail);
+		}
+
+		/**
+		 * @brief Idle sleep that keeps polling the event sources.
+		 *
+		 * Wakes every REACTOR_POLL_MS while a poller is registered, the
+		 * scheduler then sleeps again until its deadline.
+		 *
+		 * @param 	ms				The time to sleep
+		 */
+		static void idle_sleep(uint32_t ms);
+
+		/**
+		 * @brief Gets the number of events dropped on a full queue.
+		 *
+		 * @return	count			The dropped events
+		 */
+		static uint16_t get_dropped(){
+			return dropped;
+		}
+
+	/*
+	 * Private access methods
+	 */
+	private:
+
+		/*
+		 * Event queue (multiple producers, BIOS consumer)
+		 */
+		static reactor_event_t			queue[REACTOR_QUEUE_SIZE];
+		static volatile uint8_t			head;
+		static volatile uint8_t			tail;
+		static volatile uint16_t		dropped;
+
+		/*
+		 * Handlers per event type
+		 */
+		static reactor_handler_t		handlers[REACTOR_EVENT_MAX];
+		static void*					contexts[REACTOR_EVENT_MAX];
+
+		/*
+		 * Pollers
+		 */
+		static reactor_poll_t			pollers[REACTOR_MAX_POLLERS];
+		static void*					poll_contexts[REACTOR_MAX_POLLERS];
+		static uint8_t					poller_count;
+
+		/*
+		 * The scheduler to wake
+		 */
+		static scheduler_t*				sched;
+};
+
+/**< Typedef */
+typedef reactor reactor_t;
+
+#endif /* TASK_REACTOR_H_ */
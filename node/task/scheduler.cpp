@@ -6,6 +6,19 @@
  */
 
 #include <task/scheduler.h>
+#include <driverlib/interrupt.h>
+
+#ifdef SCHEDULER_WATCHDOG
+#include <inc/hw_memmap.h>
+#include <driverlib/prcm.h>
+#include <driverlib/timer.h>
+#include <driverlib/wdt.h>
+
+/*
+ * The scheduler watched by the timer interrupt
+ */
+scheduler* scheduler::watched = NULL;
+#endif
 
 /**
  * @brief The default object constructor.
@@ -18,10 +31,55 @@ scheduler::scheduler(){
 	first 	= NULL;
 	last 	= NULL;
 
+#ifdef SCHEDULER_HEAP_MODE
+	heap_count = 0;
+	pass = 0;
+#endif
+
+	/*
+	 * Idle
+	 */
+	sleep_fxn 		= default_sleep;
+	wake_fxn 		= NULL;
+	wake_pending 	= false;
+
+#ifdef SCHEDULER_PROFILE
+	busy_us 		= 0;
+	window_start 	= millis();
+	load 			= 0;
+#endif
+
+#ifdef SCHEDULER_LOAD_SHEDDING
+	shed_busy_us 	= 0;
+	shed_start 		= millis();
+	shed_level 		= 0;
+#endif
+
+#ifdef SCHEDULER_STATIC_TABLE
+	table 			= NULL;
+#endif
+
+#ifdef SCHEDULER_PREEMPTIVE
+	os_mutex_init(&lock);
+	for (uint8_t i = 0; i <= TASK_PRIORITY_LOW; i++) {
+		os_mutex_init(&class_lock[i]);
+	}
+#endif
+
+#ifdef SCHEDULER_WATCHDOG
+	running 		= NULL;
+	run_start 		= 0;
+	hung 			= false;
+	last_feed 		= millis();
+#endif
+
 	/*
-	 * Suspending queue init
+	 * Control mailbox init
 	 */
-	scheduler::suspend_queue = new queue<thread_id_t>();
+	mailbox_head 	= 0;
+	mailbox_tail 	= 0;
+	mailbox_dropped = 0;
+	memset(tasks_by_id, 0, sizeof(tasks_by_id));
 }
 
 /**
@@ -32,6 +90,16 @@ scheduler::scheduler(){
  */
 status_code_t scheduler::add_task(task_t* task){
 
+	/*
+	 * The thread id indexes the control lookup
+	 */
+	if ((task->_id >= SCHEDULER_MAX_THREAD_ID) ||
+			(tasks_by_id[task->_id] != NULL)) {
+		NOTIFY_ERROR("Invalid thread id: " + String(task->_id));
+		return ERR_INVALID_ARG;
+	}
+	tasks_by_id[task->_id] = task;
+
 	/*
 	 * Add a task to the scheduler
 	 */
@@ -58,6 +126,21 @@ status_code_t scheduler::add_task(task_t* task){
 	task->next = NULL;
 	last = task;
 
+	/*
+	 * Queue the task on its deadline
+	 */
+	reschedule(task);
+
+#ifdef SCHEDULER_PREEMPTIVE
+	/*
+	 * Give it its own thread
+	 */
+	if (spawn(task) != STATUS_OK) {
+		NOTIFY_ERROR("Task thread failed: " + String(task->_id));
+		return ERR_NO_MEMORY;
+	}
+#endif
+
 	/*
 	 * Notify
 	 */
@@ -78,6 +161,31 @@ status_code_t scheduler::delete_task(task_t* task){
 	 */
 	NOTIFY_INFO("Deleting task: " + String(task->_id));
 
+#ifdef SCHEDULER_PREEMPTIVE
+	/*
+	 * Park the task thread
+	 */
+	os_mutex_lock(&lock);
+	task->_enabled = false;
+	os_mutex_unlock(&lock);
+	os_sem_post(&task->_signal);
+#endif
+
+#ifdef SCHEDULER_HEAP_MODE
+	/*
+	 * Take it out of the deadline queue
+	 */
+	heap_remove(task);
+#endif
+
+	/*
+	 * Drop the id lookup
+	 */
+	if ((task->_id < SCHEDULER_MAX_THREAD_ID) &&
+			(tasks_by_id[task->_id] == task)) {
+		tasks_by_id[task->_id] = NULL;
+	}
+
 	/*
 	 * delete the task
 	 */
@@ -168,157 +276,1315 @@ status_code_t scheduler::enable_all(){
 }
 
 /**
- * @brief Disable the tasks based on the thread id in the queues
+ * @brief Posts a control command to the mailbox (ISR safe).
+ *
+ * The command is applied at the start of the next pass.
+ *
+ * @param 	command			The control command
+ * @param 	id				The thread id, TASK_ID_ALL for every task
+ * @param 	argument		The interval or iterations, if any
+ * @return	status			ERR_BUFFER_OVERFLOW if the mailbox is full
  */
-void scheduler::disable_tasks(){
+status_code_t scheduler::post(task_ctrl_t command, thread_id_t id, uint32_t argument){
 
 	/*
-	 * Temp
+	 * Producers may be interrupts, mask them around the slot claim
 	 */
-	task *current = first;
-	int counter	= suspend_queue->count();
+	bool masked = IntMasterDisable();
+	uint8_t head = mailbox_head;
 
-	if (counter > 0){
-		/*
-		 * disable the tasks
-		 */
-		for(int i = 0; i < counter; i++){
+	/*
+	 * Full
+	 */
+	if ((uint8_t)(head - mailbox_tail) >= SCHEDULER_MAILBOX_SIZE) {
+		mailbox_dropped++;
+		if (!masked) {
+			IntMasterEnable();
+		}
+		return ERR_BUFFER_OVERFLOW;
+	}
 
-			/*
-			 * Check the disable queue for disabling thread
-			 */
-			thread_id_t id = \
-					(thread_id_t)suspend_queue->pop();
+	/*
+	 * Fill the slot and publish it
+	 */
+	task_ctrl_msg_t* msg 	= &mailbox[head & (SCHEDULER_MAILBOX_SIZE - 1)];
+	msg->command 			= command;
+	msg->id 				= id;
+	msg->argument 			= argument;
+	mailbox_head 			= head + 1;
 
-			// Disable the task
-			while(current){
+	if (!masked) {
+		IntMasterEnable();
+	}
 
-				/*
-				 * disable the task
-				 */
-				if(current->_id == id){
-					current->disable();
-				}
+	/*
+	 * Cut the idle period short so it applies on the next pass
+	 */
+	wake();
+	return STATUS_OK;
+}
 
-				/*
-				 * Update to the next task
-				 */
+/**
+ * @brief Applies the pending control commands.
+ */
+void scheduler::process_control(){
+
+	/*
+	 * Only the commands posted so far, later ones wait for the next pass
+	 */
+	uint8_t head = mailbox_head;
+
+	while (mailbox_tail != head) {
+
+		/*
+		 * Copy the message out before releasing the slot
+		 */
+		task_ctrl_msg_t msg = mailbox[mailbox_tail & (SCHEDULER_MAILBOX_SIZE - 1)];
+		mailbox_tail++;
+
+		/*
+		 * Every task
+		 */
+		if (msg.id == TASK_ID_ALL) {
+			task_t* current = first;
+			while (current) {
+				apply(current, &msg);
 				current = current->next;
 			}
+			continue;
+		}
+
+		/*
+		 * One task
+		 */
+		task_t* task = get_task(msg.id);
+		if (task) {
+			apply(task, &msg);
+		}else{
+			NOTIFY_ERROR("Unknown thread id: " + String(msg.id));
 		}
 	}
 }
 
+/**
+ * @brief Applies a control command to a task.
+ *
+ * @param 	task			The task to control
+ * @param 	msg				The control message
+ */
+void scheduler::apply(task_t* task, task_ctrl_msg_t* msg){
+
+	/*
+	 * Switch on the command
+	 */
+	switch (msg->command) {
+
+		case TASK_CTRL_SUSPEND:
+			task->disable();
+			break;
+
+		case TASK_CTRL_RESUME:
+			task->enable();
+			break;
+
+		case TASK_CTRL_RESTART:
+			task->restart();
+			break;
+
+		case TASK_CTRL_SET_INTERVAL:
+			task->set_interval(msg->argument);
+			break;
+
+		case TASK_CTRL_SET_ITERATIONS:
+			task->set_iterations(msg->argument);
+			reschedule(task);
+			break;
+
+		case TASK_CTRL_SET_PHASE:
+			task->set_phase(msg->argument);
+			break;
+
+		default:
+			NOTIFY_ERROR("Invalid task command: " + String(msg->command));
+			break;
+	}
+}
 
 /**
- * @brief Runs the sceduler
+ * @brief Requeues a task after its deadline or state changed.
+ *
+ * In the list walk mode this does nothing, the next pass
+ * picks the change up on its own.
+ *
+ * @param 	task			The task that changed
  */
-void scheduler::run(){
+void scheduler::reschedule(task_t* task){
+
+#ifdef SCHEDULER_PREEMPTIVE
+
+	/*
+	 * The task thread waits on its own deadline, make it look again
+	 */
+	if (task->scheduler) {
+		os_sem_post(&task->_signal);
+	}
+#elif defined(SCHEDULER_HEAP_MODE)
+
+	/*
+	 * Drop the old position, if any
+	 */
+	heap_remove(task);
+
+	/*
+	 * Only enabled tasks with work left are queued. A finished task
+	 * stays queued only when it still has to be disabled, it gets
+	 * parked otherwise until restart() requeues it.
+	 */
+	if(task->_enabled &&
+			((task->_iterations != 0) || task->_disable_on_last_iteration)){
+		if(heap_push(task) != STATUS_OK){
+			NOTIFY_ERROR("Task heap full: " + String(task->_id));
+		}
+	}
+#endif
+}
+
+/**
+ * @brief Executes the task callback and profiles it.
+ *
+ * @param 	current			The task to execute
+ * @param 	latency			How late the run starts (us)
+ */
+void scheduler::execute(task_t* current, uint32_t latency){
+
+	/*
+	 * No callback
+	 */
+	if (!current->_callback && !current->_context_callback) {
+		return;
+	}
 
 	/*
-	 * Check to see if we need to disable any tasks
+	 * Execute the task
 	 */
-	disable_tasks();
+	begin_run(current, latency);
+	if (current->_context_callback) {
+		(*(current->_context_callback))(current->_context);
+	}else{
+		(*(current->_callback))();
+	}
+	end_run(current);
+}
+
+/**
+ * @brief Book keeping before a task runs.
+ *
+ * @param 	current			The task about to run
+ * @param 	latency			How late the run starts (us)
+ */
+void scheduler::begin_run(task_t* current, uint32_t latency){
+
+#ifdef SCHEDULER_PROFILE
 
 	/*
 	 * Temp
 	 */
-	task *current = first;
+	task_profile_t*	profile 	= &current->_profile;
+	uint8_t			bin 		= 0;
 
 	/*
-	 * Until all tasks are ran
+	 * The next deadline has already passed
 	 */
-	while (current) {
+	if ((current->_interval > 0) && (latency >= current->period())) {
+		profile->missed++;
+	}
+
+	/*
+	 * Log2 bin of the latency in ms
+	 */
+	latency /= 1000;
+	while ((latency > 0) && (bin < (TASK_PROFILE_BINS - 1))) {
+		latency >>= 1;
+		bin++;
+	}
+	if (profile->latency[bin] < 0xFFFF) {
+		profile->latency[bin]++;
+	}
 
-		do {
+	current->_run_start_us = micros();
+#endif
 
-			/*
-			 * If the task is not enabled
-			 */
-			if (!current->_enabled) {
-				break;
-			}
+	/*
+	 * Mark the task as running
+	 */
+	task_t::active = current;
+	current->_last_run = sys_clock::now();
+#ifdef SCHEDULER_WATCHDOG
+	run_start 	= millis();
+	running 	= current;
+#endif
+}
 
-			/*
-			 * IF the iterations are now elapsed
-			 */
-	   		if (current->_iterations == 0) {
-
-	   			/*
-	   			 * Do we disable it?
-	   			 */
-				if (current->_disable_on_last_iteration){
-
-					/*
-					 * Disable
-					 */
-					current->disable();
-					NOTIFY_INFO("Thread " + \
-							String(current->_id) + \
-							" dead.");
-				}
-				break;
-			}
+/**
+ * @brief Book keeping after a task ran.
+ *
+ * @param 	current			The task that ran
+ */
+void scheduler::end_run(task_t* current){
 
-	   		/*
-	   		 * If the interval is still valid
-	   		 */
-			if (current->_interval > 0) {
+	task_t::active = NULL;
 
-				/*
-				 * Set the target time to execute
-				 */
-				unsigned long target_millis = \
-						current->_previous_millis + current->_interval;
+#ifdef SCHEDULER_WATCHDOG
 
-				/*
-				 * Still too small?
-				 */
-				if (target_millis <= millis()) {
-
-					/*
-					 * Update the time
-					 */
-					if (current->_iterations > 0){
-						current->_iterations--;  // do not decrement (-1) being a signal of eternal task
-					}
-
-					/*
-					 * Update
-					 */
-					current->_previous_millis += current->_interval;
-					current->_overrun = (long) (current->_previous_millis + current->_interval - millis());
-
-					/*
-					 * Execute the task
-					 */
-					if (current->_callback) {
-						(*(current->_callback))();
-					}
-					break;
-				}
-			}else {
+	/*
+	 * Check the budget, the task came back so the loop is alive
+	 */
+	running 			= NULL;
+	hung 				= false;
+	uint32_t run_ms 	= millis() - run_start;
 
-				/*
-				 * Update
-				 */
-				if (current->_iterations > 0){
-					current->_iterations--;  // do not decrement (-1) being a signal of eternal task
-				}
+	if (current->_budget && (run_ms > current->_budget)) {
+		watchdog_trip(current, run_ms);
+	}else{
+		current->_checked_in = true;
+	}
+#endif
 
-				/*
-				 * Execute
-				 */
-				if (current->_callback) {
-					(*(current->_callback))();
-				}
-			}
+#ifdef SCHEDULER_PROFILE
+
+	/*
+	 * Record the run time
+	 */
+	task_profile_t*	profile 	= &current->_profile;
+	uint32_t		elapsed 	= micros() - current->_run_start_us;
+
+	profile->runs++;
+	profile->total_us += elapsed;
+	busy_us += elapsed;
+#ifdef SCHEDULER_LOAD_SHEDDING
+	shed_busy_us += elapsed;
+#endif
+
+	if (elapsed < profile->min_us) {
+		profile->min_us = elapsed;
+	}
+	if (elapsed > profile->max_us) {
+		profile->max_us = elapsed;
+	}
+#endif
+
+#ifdef SCHEDULER_PIPELINE
+
+	/*
+	 * Hand off to the next stage
+	 */
+	if (current->_downstream) {
+		current->_downstream->trigger();
+	}
+#endif
+}
+
+#ifdef SCHEDULER_WATCHDOG
+/**
+ * @brief Starts the watchdog timer and the MCU watchdog.
+ *
+ * @return	status			The status to return
+ */
+status_code_t scheduler::watchdog_start(){
+
+	/*
+	 * One watched scheduler
+	 */
+	if (watched && (watched != this)) {
+		return ERR_BUSY;
+	}
+	watched 	= this;
+	last_feed 	= millis();
+
+#ifdef WATCHDOG_MCU_ENABLE
+	/*
+	 * MCU watchdog, resets on the second timeout without a feed
+	 */
+	PRCMPeripheralClkEnable(PRCM_WDT, PRCM_RUN_MODE_CLK);
+	WatchdogUnlock(WDT_BASE);
+	WatchdogReloadSet(WDT_BASE, (F_CPU / 1000) * WATCHDOG_MCU_TIMEOUT_MS);
+	WatchdogStallEnable(WDT_BASE);
+	WatchdogEnable(WDT_BASE);
+	WatchdogLock(WDT_BASE);
+#endif
+
+	/*
+	 * Periodic check timer
+	 */
+	PRCMPeripheralClkEnable(WATCHDOG_TIMER_PRCM, PRCM_RUN_MODE_CLK);
+	PRCMPeripheralReset(WATCHDOG_TIMER_PRCM);
+	TimerConfigure(WATCHDOG_TIMER_BASE, TIMER_CFG_PERIODIC);
+	TimerLoadSet(WATCHDOG_TIMER_BASE, TIMER_A, (F_CPU / 1000) * WATCHDOG_TICK_MS);
+	TimerIntRegister(WATCHDOG_TIMER_BASE, TIMER_A, watchdog_isr);
+	TimerIntEnable(WATCHDOG_TIMER_BASE, TIMER_TIMA_TIMEOUT);
+	TimerEnable(WATCHDOG_TIMER_BASE, TIMER_A);
+
+	NOTIFY_INFO("Watchdog started.");
+	return STATUS_OK;
+}
+
+/**
+ * @brief Watchdog timer interrupt.
+ */
+void scheduler::watchdog_isr(){
+
+	/*
+	 * Temp
+	 */
+	scheduler* 	sched 	= watched;
+	uint32_t 	now 	= millis();
+
+	TimerIntClear(WATCHDOG_TIMER_BASE, TIMER_TIMA_TIMEOUT);
+
+	if (!sched) {
+		return;
+	}
+
+	/*
+	 * The running task is over budget, stop feeding until it returns
+	 */
+	task_t* current = sched->running;
+	if (current && current->_budget &&
+			((now - sched->run_start) > current->_budget)) {
+		sched->hung = true;
+	}
+
+	if (sched->hung || ((now - sched->last_feed) < WATCHDOG_FEED_MS)) {
+		return;
+	}
+
+	/*
+	 * Every enabled critical task has to check in
+	 */
+	for (current = sched->first; current; current = current->next) {
+		if (current->_enabled &&
+				(current->_priority == TASK_PRIORITY_CRITICAL) &&
+				!current->_checked_in) {
+			return;
+		}
+	}
+
+	/*
+	 * Feed and start a new check in period
+	 */
+#ifdef WATCHDOG_MCU_ENABLE
+	WatchdogIntClear(WDT_BASE);
+#endif
+	for (current = sched->first; current; current = current->next) {
+		current->_checked_in = false;
+	}
+	sched->last_feed = now;
+}
+
+/**
+ * @brief Applies the watchdog action to a task over budget.
+ *
+ * @param 	current			The task
+ * @param 	elapsed			Its run time (ms)
+ */
+void scheduler::watchdog_trip(task_t* current, uint32_t elapsed){
+
+	current->_wdt_trips++;
+	NOTIFY_ERROR("Watchdog: thread " + String(current->_id) + \
+			" ran " + String(elapsed) + "ms, budget " + \
+			String(current->_budget) + "ms.");
+
+	/*
+	 * Recover the task
+	 */
+	switch (current->_wdt_action) {
+
+		case TASK_WDT_RESTART:
+			current->restart();
+			break;
+
+		case TASK_WDT_DISABLE:
+		default:
+			current->disable();
+			break;
+	}
+}
+#endif
+
+/**
+ * @brief Runs a single task if it is due.
+ *
+ * @param 	current			The task to dispatch
+ */
+void scheduler::dispatch(task_t* current){
+
+	uint32_t latency;
+
+	if (prepare(current, &latency)) {
+		execute(current, latency);
+	}
+}
+
+/**
+ * @brief Checks if a task is due and advances its deadline.
+ *
+ * @param 	current			The task to check
+ * @param 	latency			How late the run starts (us)
+ * @return	bool			True if the task has to run now
+ */
+bool scheduler::prepare(task_t* current, uint32_t* latency){
+
+	/*
+	 * If the task is not enabled
+	 */
+	if (!current->_enabled) {
+		return false;
+	}
 
-		} while (false); // guaranteed single run - allows use of "break" to exit
+	/*
+	 * IF the iterations are now elapsed
+	 */
+	if (current->_iterations == 0) {
 
 		/*
-		 * Update to the next task
+		 * Do we disable it?
 		 */
-		current = current->next;
+		if (current->_disable_on_last_iteration){
+
+			/*
+			 * Disable
+			 */
+			current->disable();
+			NOTIFY_INFO("Thread " + \
+					String(current->_id) + \
+					" dead.");
+		}
+		return false;
+	}
+
+	/*
+	 * If the interval is still valid
+	 */
+	if (current->_interval > 0) {
+
+		/*
+		 * Temp
+		 */
+		clock_us_t now 		= sys_clock::now();
+		clock_us_t period 	= current->period();
+		clock_us_t late 	= now - current->next_run();
+
+		/*
+		 * Still too small?
+		 */
+		if (clock_reached(current->next_run(), now)) {
+
+			/*
+			 * Update the time
+			 */
+			if (current->_iterations > 0){
+				current->_iterations--;  // do not decrement (-1) being a signal of eternal task
+			}
+
+			/*
+			 * Update following the overrun policy
+			 */
+			switch (current->_overrun_policy) {
+
+				/*
+				 * Restart the period from now
+				 */
+				case TASK_OVERRUN_SKIP:
+					current->_previous = now;
+					break;
+
+				/*
+				 * Jump over the missed slots, stay on the grid
+				 */
+				case TASK_OVERRUN_COALESCE:
+					current->_previous += period * (1 + (late / period));
+					break;
+
+				/*
+				 * One slot at a time, late runs go back to back
+				 */
+				case TASK_OVERRUN_CATCH_UP:
+				default:
+					current->_previous += period;
+					break;
+			}
+			current->_overrun = (int32_t) (current->_previous + period - now);
+
+			/*
+			 * Run it
+			 */
+			*latency = (late > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)late;
+			return true;
+		}
+		return false;
+	}else {
+
+		/*
+		 * Update
+		 */
+		if (current->_iterations > 0){
+			current->_iterations--;  // do not decrement (-1) being a signal of eternal task
+		}
+
+		/*
+		 * Run on every pass
+		 */
+		*latency = 0;
+		return true;
+	}
+}
+
+/**
+ * @brief Runs the sceduler
+ */
+void scheduler::run(){
+
+#ifdef SCHEDULER_PREEMPTIVE
+
+	/*
+	 * The tasks run in their threads, only the controls and the
+	 * measurement windows are left to the loop
+	 */
+	os_mutex_lock(&lock);
+	process_control();
+	end_pass();
+	os_mutex_unlock(&lock);
+	return;
+#endif
+
+	/*
+	 * Apply the pending control commands
+	 */
+	process_control();
+
+#ifdef SCHEDULER_STATIC_TABLE
+
+	/*
+	 * Compile time task table, dispatched without indirect calls
+	 */
+	if (table) {
+		table->dispatch(this);
+		end_pass();
+		return;
+	}
+#endif
+
+#ifdef SCHEDULER_HEAP_MODE
+
+	/*
+	 * Temp
+	 */
+	task_t*		parked[SCHEDULER_MAX_TASKS];
+	uint16_t	parked_count 	= 0;
+	clock_us_t	now 			= sys_clock::now();
+
+	pass++;
+
+	/*
+	 * Pop and run the due tasks one at a time, in deadline order.
+	 * A callback that reschedules another task moves it in the heap
+	 * at once, so it is only popped on its new deadline.
+	 */
+	while (heap_count && clock_reached(heap[0]->next_run(), now)) {
+
+		task_t* task = heap[0];
+		heap_remove(task);
+
+		/*
+		 * Due again after its run this pass (zero interval, or made
+		 * due by a callback), it waits for the next pass
+		 */
+		if (task->_pass == pass) {
+			parked[parked_count++] = task;
+			continue;
+		}
+
+		task->_pass = pass;
+		dispatch(task);
+
+		/*
+		 * Requeue on the next deadline unless the callback
+		 * already did it or the task is done.
+		 */
+		if (task->_heap_index < 0) {
+			reschedule(task);
+		}
+	}
+
+	/*
+	 * Back in the heap, unless a callback requeued or disabled them
+	 */
+	for (uint16_t i = 0; i < parked_count; i++) {
+		if (parked[i]->_heap_index < 0) {
+			reschedule(parked[i]);
+		}
+	}
+#else
+
+	/*
+	 * Temp
+	 */
+	task *current = first;
+
+	/*
+	 * Until all tasks are ran
+	 */
+	while (current) {
+
+		dispatch(current);
+
+		/*
+		 * Update to the next task
+		 */
+		current = current->next;
+	}
+#endif
+
+	end_pass();
+}
+
+/**
+ * @brief Closes the measurement windows after a pass.
+ */
+void scheduler::end_pass(){
+
+#ifdef SCHEDULER_PROFILE
+
+	/*
+	 * Close the load window
+	 */
+	uint32_t window = millis() - window_start;
+	if (window >= SCHEDULER_PROFILE_WINDOW_MS) {
+		load 			= (uint8_t)((busy_us / 10) / window);
+		busy_us 		= 0;
+		window_start 	+= window;
+	}
+#endif
+
+#ifdef SCHEDULER_LOAD_SHEDDING
+	shed_load();
+#endif
+}
+
+#ifdef SCHEDULER_LOAD_SHEDDING
+/**
+ * @brief Adjusts the shed level to the measured utilisation.
+ */
+void scheduler::shed_load(){
+
+	/*
+	 * Temp
+	 */
+	uint32_t 	window 	= millis() - shed_start;
+	uint8_t 	level 	= shed_level;
+
+	/*
+	 * Wait for a full window
+	 */
+	if (window < SCHEDULER_SHED_WINDOW_MS) {
+		return;
+	}
+
+	/*
+	 * Utilisation in percent
+	 */
+	uint32_t util 	= (shed_busy_us / 10) / window;
+	shed_busy_us 	= 0;
+	shed_start 		+= window;
+
+	/*
+	 * Step the level with hysteresis
+	 */
+	if ((util > SCHEDULER_SHED_HIGH) && (level < SCHEDULER_SHED_MAX_LEVEL)) {
+		level++;
+	}else if ((util < SCHEDULER_SHED_LOW) && (level > 0)) {
+		level--;
+	}
+
+	if (level == shed_level) {
+		return;
+	}
+	shed_level = level;
+
+	NOTIFY_INFO("Load " + String(util) + \
+			"%, shed level " + String(level));
+
+	/*
+	 * Stretch (or relax) the low priority tasks
+	 */
+	task_t* current = first;
+	while (current) {
+		if (current->_priority == TASK_PRIORITY_LOW) {
+			current->_shed = level;
+			reschedule(current);
+		}
+		current = current->next;
+	}
+}
+#endif
+
+/**
+ * @brief Gets the earliest deadline of the enabled tasks.
+ *
+ * @param 	deadline		Where to store the deadline (us)
+ * @return	bool			False if no task is pending
+ */
+bool scheduler::next_deadline(clock_us_t* deadline){
+
+#ifdef SCHEDULER_PREEMPTIVE
+
+	/*
+	 * The task threads keep their own deadlines
+	 */
+	return false;
+#elif defined(SCHEDULER_HEAP_MODE)
+
+	/*
+	 * The heap top is the earliest deadline
+	 */
+	if (!heap_count) {
+		return false;
+	}
+	*deadline = heap[0]->next_run();
+	return true;
+#else
+
+	/*
+	 * Temp
+	 */
+	task_t*	current = first;
+	bool	found 	= false;
+
+	/*
+	 * Look at every task that can still run
+	 */
+	while (current) {
+
+		if (current->_enabled && (current->_iterations != 0)) {
+
+			/*
+			 * Keep the earliest
+			 */
+			if (!found || clock_before(current->next_run(), *deadline)) {
+				*deadline = current->next_run();
+				found = true;
+			}
+		}
+		current = current->next;
+	}
+	return found;
+#endif
+}
+
+/**
+ * @brief Sleeps until the next task deadline.
+ *
+ * Returns early when wake() is called.
+ */
+void scheduler::idle(){
+
+	/*
+	 * Temp
+	 */
+	clock_us_t	deadline;
+	int64_t		remaining;
+
+	/*
+	 * Nothing pending, sleep for the longest allowed period
+	 */
+	if (!next_deadline(&deadline)) {
+		deadline = sys_clock::now() + CLOCK_MS(SCHEDULER_IDLE_MAX_MS);
+	}
+
+	/*
+	 * Sleep until the deadline. The sleep ends early on an interrupt,
+	 * or through the wake primitive, then the time is checked again.
+	 */
+	while (!wake_pending) {
+
+		remaining = (int64_t)(deadline - sys_clock::now()) / 1000;
+
+		/*
+		 * Too close to be worth a sleep
+		 */
+		if (remaining < SCHEDULER_IDLE_MIN_MS) {
+			break;
+		}
+		sleep_fxn((uint32_t)remaining);
+	}
+	wake_pending = false;
+}
+
+/**
+ * @brief Default sleep primitive (MCU low power sleep).
+ *
+ * @param 	ms				The time to sleep
+ */
+void scheduler::default_sleep(uint32_t ms){
+	sleep(ms);
+}
+
+#ifdef SCHEDULER_HEAP_MODE
+
+/**
+ * @brief Pushes a task on the deadline heap.
+ *
+ * @param 	task			The task to queue
+ * @return	status			The status to return
+ */
+status_code_t scheduler::heap_push(task_t* task){
+
+	/*
+	 * No more room
+	 */
+	if (heap_count >= SCHEDULER_MAX_TASKS) {
+		return ERR_NO_MEMORY;
+	}
+
+	/*
+	 * Add at the bottom and bubble up
+	 */
+	heap_set(heap_count, task);
+	sift_up(heap_count++);
+	return STATUS_OK;
+}
+
+/**
+ * @brief Removes a task from the deadline heap.
+ *
+ * @param 	task			The task to dequeue
+ */
+void scheduler::heap_remove(task_t* task){
+
+	/*
+	 * Not queued
+	 */
+	int16_t index = task->_heap_index;
+	if ((index < 0) || (index >= heap_count) || (heap[index] != task)) {
+		return;
+	}
+
+	/*
+	 * Move the last entry in the hole and reorder it
+	 */
+	task->_heap_index = -1;
+	if (index != --heap_count) {
+		heap_set(index, heap[heap_count]);
+		sift_up(index);
+		sift_down(heap[index]->_heap_index);
+	}
+}
+
+/**
+ * @brief Moves a heap entry up until the heap is ordered.
+ *
+ * @param 	index			The heap index to sift
+ */
+void scheduler::sift_up(uint16_t index){
+
+	task_t* task = heap[index];
+
+	while (index > 0) {
+
+		uint16_t parent = (index - 1) / 2;
+
+		/*
+		 * In order
+		 */
+		if (!earlier(task, heap[parent])) {
+			break;
+		}
+
+		heap_set(index, heap[parent]);
+		index = parent;
+	}
+	heap_set(index, task);
+}
+
+/**
+ * @brief Moves a heap entry down until the heap is ordered.
+ *
+ * @param 	index			The heap index to sift
+ */
+void scheduler::sift_down(uint16_t index){
+
+	task_t* task = heap[index];
+
+	while (true) {
+
+		uint16_t child = (2 * index) + 1;
+
+		/*
+		 * Leaf reached
+		 */
+		if (child >= heap_count) {
+			break;
+		}
+
+		/*
+		 * Pick the earliest child
+		 */
+		if (((child + 1) < heap_count) && earlier(heap[child + 1], heap[child])) {
+			child++;
+		}
+
+		/*
+		 * In order
+		 */
+		if (!earlier(heap[child], task)) {
+			break;
+		}
+
+		heap_set(index, heap[child]);
+		index = child;
+	}
+	heap_set(index, task);
+}
+#endif
+
+#ifdef SCHEDULER_ANALYSIS
+
+/**
+ * @brief Checks the schedulability of the enabled tasks.
+ *
+ * Reports the schedule and the margin of every task, and
+ * re-plans an infeasible set if allowed.
+ *
+ * @return	status			STATUS_ERR_DENIED if infeasible
+ */
+status_code_t scheduler::analyze(){
+
+	/*
+	 * Temp
+	 */
+	task_t*		set[SCHEDULER_MAX_TASKS];
+	task_t*		current = first;
+	uint8_t		count 	= 0;
+	bool		ok;
+
+	/*
+	 * The periodic tasks, in analysis order
+	 */
+	while (current) {
+
+		if (current->_enabled && current->_interval && (count < SCHEDULER_MAX_TASKS)) {
+
+			uint8_t i = count++;
+			while (i && outranks(current, set[i - 1])) {
+				set[i] = set[i - 1];
+				i--;
+			}
+			set[i] = current;
+		}else if (current->_enabled && !current->_interval) {
+			NOTIFY_INFO("Task " + String(current->_id) + " runs on every pass, not analysed.");
+		}
+		current = current->next;
+	}
+
+	ok = feasible(set, count, false);
+
+#ifdef SCHEDULER_ANALYSIS_REPLAN
+	/*
+	 * Stretch the least important periods until it fits
+	 */
+	for (uint8_t step = 0; !ok && (step < SCHEDULER_REPLAN_STEPS); step++) {
+
+		if (!replan(set, count)) {
+			break;
+		}
+
+		/*
+		 * Periods changed, restore the analysis order
+		 */
+		for (uint8_t i = 1; i < count; i++) {
+			for (uint8_t j = i; j && outranks(set[j], set[j - 1]); j--) {
+				task_t* swap 	= set[j];
+				set[j] 			= set[j - 1];
+				set[j - 1] 		= swap;
+			}
+		}
+		ok = feasible(set, count, false);
+	}
+#endif
+
+	/*
+	 * Report the final schedule
+	 */
+	feasible(set, count, true);
+	if (!ok) {
+		NOTIFY_ERROR("Task set not schedulable.");
+		return STATUS_ERR_DENIED;
+	}
+	return STATUS_OK;
+}
+
+/**
+ * @brief Response time analysis of a task set.
+ *
+ * R = C + B + sum over the faster tasks of (floor(w / T) + 1) * C,
+ * with B the longest slower task that cannot be preempted.
+ *
+ * Preemptive, the set goes by priority class, then rate:
+ * R = C + B + sum over the tasks ahead of ceil(R / T) * C, with B
+ * the longest slower task of the same class (one lock per class).
+ *
+ * @param 	set				The tasks, in analysis order (outranks())
+ * @param 	count			The number of tasks
+ * @param 	report			Print the schedule and the margins
+ * @return	bool			True if every task meets its period
+ */
+bool scheduler::feasible(task_t** set, uint8_t count, bool report){
+
+	/*
+	 * Temp
+	 */
+	uint32_t	util 	= 0;		// permille
+	bool		ok 		= true;
+
+	for (uint8_t i = 0; i < count; i++) {
+
+		uint32_t	period 		= set[i]->_interval;
+		uint32_t	wcet 		= set[i]->get_wcet();
+		uint64_t	blocking 	= 0;
+		uint64_t	busy;
+		uint64_t	next;
+
+		util += (uint32_t)(((uint64_t)wcet * 1000) / period);
+
+		/*
+		 * Blocking by a slower task already running
+		 */
+		for (uint8_t j = i + 1; j < count; j++) {
+#ifdef SCHEDULER_PREEMPTIVE
+			if (set[j]->_priority != set[i]->_priority) {
+				continue;
+			}
+#endif
+			if (set[j]->get_wcet() > blocking) {
+				blocking = set[j]->get_wcet();
+			}
+		}
+
+#ifdef SCHEDULER_PREEMPTIVE
+		/*
+		 * Preemption by the tasks ahead, to a fixed point
+		 */
+		busy = wcet + blocking;
+		while (true) {
+
+			next = wcet + blocking;
+			for (uint8_t j = 0; j < i; j++) {
+				uint32_t other = set[j]->_interval;
+				next += ((busy + other - 1) / other) * set[j]->get_wcet();
+			}
+
+			if ((next == busy) || (next > period)) {
+				busy = next;
+				break;
+			}
+			busy = next;
+		}
+
+		/*
+		 * Worst case response against the period
+		 */
+		uint64_t response = busy;
+#else
+		/*
+		 * Interference of the faster tasks, to a fixed point
+		 */
+		busy = blocking;
+		while (true) {
+
+			next = blocking;
+			for (uint8_t j = 0; j < i; j++) {
+				next += ((busy / set[j]->_interval) + 1) * set[j]->get_wcet();
+			}
+
+			if ((next == busy) || ((next + wcet) > period)) {
+				busy = next;
+				break;
+			}
+			busy = next;
+		}
+
+		/*
+		 * Worst case response against the period
+		 */
+		uint64_t response = busy + wcet;
+#endif
+		if (response > period) {
+			ok = false;
+		}
+
+		if (report) {
+			String line = "Task " + String(set[i]->_id) + \
+					": T=" + String(period / 1000) + "ms" + \
+					" C=" + String(wcet) + "us" + \
+					" R=" + String((uint32_t)response) + "us" + \
+					" margin=" + String((int32_t)period - (int32_t)response) + "us";
+			if (response > period) {
+				NOTIFY_ERROR(line);
+			}else{
+				NOTIFY_INFO(line);
+			}
+		}
+	}
+
+	/*
+	 * Utilisation over one is never feasible
+	 */
+	if (util > 1000) {
+		ok = false;
+	}
+
+	if (report) {
+		NOTIFY_INFO("Utilisation: " + String(util / 10) + "." + String(util % 10) + "%");
+	}
+	return ok;
+}
+
+/**
+ * @brief Doubles the periods of the lowest priority class left.
+ *
+ * @param 	set				The tasks
+ * @param 	count			The number of tasks
+ * @return	bool			False if nothing can be stretched
+ */
+bool scheduler::replan(task_t** set, uint8_t count){
+
+	/*
+	 * From the least important class up, never the critical one
+	 */
+	for (int8_t level = TASK_PRIORITY_LOW; level > TASK_PRIORITY_CRITICAL; level--) {
+
+		bool stretched = false;
+
+		for (uint8_t i = 0; i < count; i++) {
+
+			if ((set[i]->_priority != level) ||
+					((set[i]->_interval * 2) > CLOCK_MS(SCHEDULER_REPLAN_MAX_MS))) {
+				continue;
+			}
+
+			set[i]->set_interval_us(set[i]->_interval * 2);
+			stretched = true;
+			NOTIFY_INFO("Re-planned task " + String(set[i]->_id) + \
+					" to " + String(set[i]->_interval / 1000) + "ms.");
+		}
+
+		if (stretched) {
+			return true;
+		}
+	}
+	return false;
+}
+#endif
+
+#ifdef SCHEDULER_PREEMPTIVE
+
+/**
+ * @brief Creates the thread of a task.
+ *
+ * @param 	task			The task
+ * @return	status			The status to return
+ */
+status_code_t scheduler::spawn(task_t* task){
+
+	/*
+	 * Task priority to thread priority
+	 */
+	static const uint8_t priorities[TASK_PRIORITY_LOW + 1] = {
+			OS_PRIORITY_CRITICAL,
+			OS_PRIORITY_NORMAL,
+			OS_PRIORITY_LOW
+	};
+
+	if (os_sem_init(&task->_signal) != STATUS_OK) {
+		return ERR_NO_MEMORY;
+	}
+	return os_thread_create(thread_main, task, priorities[task->_priority], OS_STACK_SIZE);
+}
+
+/**
+ * @brief Task thread, runs one task on its deadlines.
+ *
+ * The thread sleeps on the task signal until the next deadline.
+ * Any deadline change (enable, trigger, control) signals it so it
+ * looks again. A deleted task parks its thread for good.
+ *
+ * @param 	arg				The task
+ */
+void scheduler::thread_main(void* arg){
+
+	/*
+	 * Temp
+	 */
+	task_t*		current = (task_t*)arg;
+	scheduler*	self 	= (scheduler*)current->scheduler;
+	uint32_t	latency;
+	uint32_t	wait;
+	int64_t		remaining;
+	bool		due;
+
+	while (true) {
+
+		/*
+		 * Due?
+		 */
+		os_mutex_lock(&self->lock);
+		due = self->prepare(current, &latency);
+		if (due) {
+			self->begin_run(current, latency);
+		}
+		os_mutex_unlock(&self->lock);
+
+		if (due) {
+
+			/*
+			 * Execute, only the tasks of the same priority wait
+			 */
+			os_mutex_lock(&self->class_lock[current->_priority]);
+			if (current->_context_callback) {
+				(*(current->_context_callback))(current->_context);
+			}else if (current->_callback) {
+				(*(current->_callback))();
+			}
+			os_mutex_unlock(&self->class_lock[current->_priority]);
+
+			os_mutex_lock(&self->lock);
+			self->end_run(current);
+			os_mutex_unlock(&self->lock);
+
+			/*
+			 * A task without interval runs on every pass, let the
+			 * lower priorities breathe
+			 */
+			if (!current->period()) {
+				os_sem_wait(&current->_signal, 1);
+			}
+			continue;
+		}
+
+		/*
+		 * Sleep until the deadline or a signal
+		 */
+		if (!current->_enabled || !current->scheduler ||
+				((current->_iterations == 0) && !current->_disable_on_last_iteration)) {
+			wait = OS_WAIT_FOREVER;
+		}else{
+			remaining 	= (int64_t)(current->next_run() - sys_clock::now());
+			wait 		= (remaining <= 0) ? 0 : (uint32_t)((remaining + 999) / 1000);
+		}
+
+		if (wait) {
+			os_sem_wait(&current->_signal, wait);
+		}
 	}
 }
+#endif
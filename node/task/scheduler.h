@@ -13,7 +13,62 @@
  */
 #include <task/task.h>
 #include <status_codes.h>
-#include <platform/others/queue.h>
+
+#if defined(SCHEDULER_LOAD_SHEDDING) && !defined(SCHEDULER_PROFILE)
+#error "SCHEDULER_LOAD_SHEDDING needs SCHEDULER_PROFILE"
+#endif
+
+#if defined(SCHEDULER_PREEMPTIVE) && defined(SCHEDULER_WATCHDOG)
+#error "SCHEDULER_WATCHDOG needs the cooperative scheduler"
+#endif
+
+#if defined(SCHEDULER_PREEMPTIVE) && defined(SCHEDULER_STATIC_TABLE)
+#error "SCHEDULER_STATIC_TABLE needs the cooperative scheduler"
+#endif
+
+/**
+ * @brief Sleep primitive used by the tickless idle
+ *
+ * Sleeps for at most the given time in ms. It may return early
+ * (i.e. on an interrupt), the scheduler re-checks the time.
+ */
+typedef void (*idle_sleep_t)(uint32_t ms);
+
+/**
+ * @brief Wake primitive paired with the sleep primitive
+ *
+ * Ends a sleep in progress (ISR safe). Not needed when any interrupt
+ * ends the sleep, as the MCU low power sleep does.
+ */
+typedef void (*idle_wake_t)();
+
+/*
+ * Compile time task table
+ */
+class task_table_base;
+
+/**
+ * @brief Task control commands
+ */
+typedef enum {
+
+	TASK_CTRL_SUSPEND,					//!< TASK_CTRL_SUSPEND
+	TASK_CTRL_RESUME,					//!< TASK_CTRL_RESUME
+	TASK_CTRL_RESTART,					//!< TASK_CTRL_RESTART
+	TASK_CTRL_SET_INTERVAL,				//!< TASK_CTRL_SET_INTERVAL
+	TASK_CTRL_SET_ITERATIONS,			//!< TASK_CTRL_SET_ITERATIONS
+	TASK_CTRL_SET_PHASE					//!< TASK_CTRL_SET_PHASE (ms)
+}task_ctrl_t;
+
+/**
+ * @brief Task control message
+ */
+typedef struct {
+
+	uint8_t					command;	// The task_ctrl_t command
+	thread_id_t				id;			// The target thread id
+	uint32_t				argument;	// Interval or iterations
+}task_ctrl_msg_t;
 
 /**
  * @brief The scheduler interface
@@ -40,16 +95,279 @@ class scheduler {
 		task_t* 	first;
 		task_t* 	last;
 
+#ifdef SCHEDULER_HEAP_MODE
+
+		/*
+		 * Deadline ordered min-heap of the enabled tasks
+		 */
+		task_t*		heap[SCHEDULER_MAX_TASKS];
+		uint16_t	heap_count;
+
+		/*
+		 * Pass number, a task runs at most once per pass
+		 */
+		uint32_t	pass;
+
+		/**
+		 * @brief Returns true if task a fires before task b.
+		 *
+		 * @param 	a				The first task
+		 * @param 	b				The second task
+		 * @return	bool			True if a is due first
+		 */
+		static inline bool earlier(task_t* a, task_t* b){
+			return clock_before(a->next_run(), b->next_run());
+		}
+
+		/**
+		 * @brief Pushes a task on the deadline heap.
+		 *
+		 * @param 	task			The task to queue
+		 * @return	status			The status to return
+		 */
+		status_code_t heap_push(task_t* task);
+
+		/**
+		 * @brief Removes a task from the deadline heap.
+		 *
+		 * @param 	task			The task to dequeue
+		 */
+		void heap_remove(task_t* task);
+
+		/**
+		 * @brief Moves a heap entry up until the heap is ordered.
+		 *
+		 * @param 	index			The heap index to sift
+		 */
+		void sift_up(uint16_t index);
+
+		/**
+		 * @brief Moves a heap entry down until the heap is ordered.
+		 *
+		 * @param 	index			The heap index to sift
+		 */
+		void sift_down(uint16_t index);
+
+		/**
+		 * @brief Places a task at a heap index and records it.
+		 *
+		 * @param 	index			The heap index
+		 * @param 	task			The task to place
+		 */
+		inline void heap_set(uint16_t index, task_t* task){
+			heap[index] = task;
+			task->_heap_index = index;
+		}
+#endif
+
+		/*
+		 * Tickless idle
+		 */
+		idle_sleep_t			sleep_fxn;
+		idle_wake_t				wake_fxn;
+		volatile bool			wake_pending;
+
+		/**
+		 * @brief Default sleep primitive (MCU low power sleep).
+		 *
+		 * @param 	ms				The time to sleep
+		 */
+		static void default_sleep(uint32_t ms);
+
+#ifdef SCHEDULER_PROFILE
+
+		/*
+		 * CPU load accounting
+		 */
+		uint32_t				busy_us;
+		uint32_t				window_start;
+		uint8_t					load;
+#endif
+
+#ifdef SCHEDULER_LOAD_SHEDDING
+
+		/*
+		 * Load shedding
+		 */
+		uint32_t				shed_busy_us;
+		uint32_t				shed_start;
+		uint8_t					shed_level;
+
+		/**
+		 * @brief Adjusts the shed level to the measured utilisation.
+		 */
+		void shed_load();
+#endif
+
+		/*
+		 * Task lookup by thread id
+		 */
+		task_t*					tasks_by_id[SCHEDULER_MAX_THREAD_ID];
+
+		/*
+		 * Control mailbox (multiple producers, scheduler consumer)
+		 */
+		task_ctrl_msg_t			mailbox[SCHEDULER_MAILBOX_SIZE];
+		volatile uint8_t		mailbox_head;
+		volatile uint8_t		mailbox_tail;
+		volatile uint16_t		mailbox_dropped;
+
+		/**
+		 * @brief Applies a control command to a task.
+		 *
+		 * @param 	task			The task to control
+		 * @param 	msg				The control message
+		 */
+		void apply(task_t* task, task_ctrl_msg_t* msg);
+
+#ifdef SCHEDULER_WATCHDOG
+
+		/*
+		 * Watchdog state, shared with the timer interrupt
+		 */
+		static scheduler*		watched;
+		task_t* volatile		running;
+		volatile uint32_t		run_start;
+		volatile bool			hung;
+		volatile uint32_t		last_feed;
+
+		/**
+		 * @brief Watchdog timer interrupt.
+		 */
+		static void watchdog_isr();
+
+		/**
+		 * @brief Applies the watchdog action to a task over budget.
+		 *
+		 * @param 	current			The task
+		 * @param 	elapsed			Its run time (ms)
+		 */
+		void watchdog_trip(task_t* current, uint32_t elapsed);
+#endif
+
+#ifdef SCHEDULER_STATIC_TABLE
+
+		/*
+		 * Compile time task table, NULL to run the task list
+		 */
+		task_table_base*		table;
+#endif
+
+#ifdef SCHEDULER_PREEMPTIVE
+
+		/*
+		 * Scheduler state lock, and one lock per priority so tasks
+		 * of the same priority never preempt each other
+		 */
+		os_mutex_t				lock;
+		os_mutex_t				class_lock[TASK_PRIORITY_LOW + 1];
+
+		/**
+		 * @brief Task thread, runs one task on its deadlines.
+		 *
+		 * @param 	arg				The task
+		 */
+		static void thread_main(void* arg);
+
+		/**
+		 * @brief Creates the thread of a task.
+		 *
+		 * @param 	task			The task
+		 * @return	status			The status to return
+		 */
+		status_code_t spawn(task_t* task);
+#endif
+
+		/**
+		 * @brief Executes the task callback and profiles it.
+		 *
+		 * @param 	current			The task to execute
+		 * @param 	latency			How late the run starts (us)
+		 */
+		void execute(task_t* current, uint32_t latency);
+
+		/**
+		 * @brief Book keeping before a task runs.
+		 *
+		 * @param 	current			The task about to run
+		 * @param 	latency			How late the run starts (us)
+		 */
+		void begin_run(task_t* current, uint32_t latency);
+
+		/**
+		 * @brief Book keeping after a task ran.
+		 *
+		 * @param 	current			The task that ran
+		 */
+		void end_run(task_t* current);
+
+		/**
+		 * @brief Checks if a task is due and advances its deadline.
+		 *
+		 * @param 	current			The task to check
+		 * @param 	latency			How late the run starts (us)
+		 * @return	bool			True if the task has to run now
+		 */
+		bool prepare(task_t* current, uint32_t* latency);
+
+		/**
+		 * @brief Runs a single task if it is due.
+		 *
+		 * @param 	current			The task to dispatch
+		 */
+		void dispatch(task_t* current);
+
+		/**
+		 * @brief Closes the measurement windows after a pass.
+		 */
+		void end_pass();
+
+#ifdef SCHEDULER_ANALYSIS
+
+		/**
+		 * @brief Returns true if task a comes before task b in the analysis.
+		 *
+		 * Rate monotonic, and by priority class first when the classes
+		 * preempt each other.
+		 *
+		 * @param 	a				The first task
+		 * @param 	b				The second task
+		 * @return	bool			True if a ranks higher
+		 */
+		static inline bool outranks(task_t* a, task_t* b){
+#ifdef SCHEDULER_PREEMPTIVE
+			if (a->_priority != b->_priority) {
+				return (a->_priority < b->_priority);
+			}
+#endif
+			return (a->_interval < b->_interval);
+		}
+
+		/**
+		 * @brief Response time analysis of a task set.
+		 *
+		 * @param 	set				The tasks, in analysis order (outranks())
+		 * @param 	count			The number of tasks
+		 * @param 	report			Print the schedule and the margins
+		 * @return	bool			True if every task meets its period
+		 */
+		bool feasible(task_t** set, uint8_t count, bool report);
+
+		/**
+		 * @brief Doubles the periods of the lowest priority class left.
+		 *
+		 * @param 	set				The tasks
+		 * @param 	count			The number of tasks
+		 * @return	bool			False if nothing can be stretched
+		 */
+		bool replan(task_t** set, uint8_t count);
+#endif
+
 	/*
 	 * Public access methods
 	 */
 	public:
 
-		/*
-		 * Suspending queue
-		 */
-		queue<thread_id_t>* suspend_queue;
-
 		/**
 		 * @brief The default object constructor.
 		 */
@@ -89,21 +407,187 @@ class scheduler {
 		void run();
 
 		/**
-		 * @brief Disable the tasks based on the thread id in the queues
+		 * @brief Posts a control command to the mailbox (ISR safe).
+		 *
+		 * The command is applied at the start of the next pass.
+		 *
+		 * @param 	command			The control command
+		 * @param 	id				The thread id, TASK_ID_ALL for every task
+		 * @param 	argument		The interval or iterations, if any
+		 * @return	status			ERR_BUFFER_OVERFLOW if the mailbox is full
 		 */
-		void disable_tasks();
+		status_code_t post(task_ctrl_t command, thread_id_t id, uint32_t argument);
 
 		/**
-		 * @brief The default deconstructor.
+		 * @brief Applies the pending control commands.
 		 */
-		~scheduler(){}
+		void process_control();
 
 		/**
-		 * @brief Gets the queue
+		 * @brief Gets a task by its thread id.
+		 *
+		 * @param 	id				The thread id
+		 * @return	task			The task, NULL if none is registered
 		 */
-		queue<thread_id_t>* get_queue(){
-			return this->suspend_queue;
+		task_t* get_task(thread_id_t id){
+			return ((id < SCHEDULER_MAX_THREAD_ID) ? tasks_by_id[id] : NULL);
 		}
+
+		/**
+		 * @brief Gets the number of commands dropped on a full mailbox.
+		 *
+		 * @return	dropped			The dropped command count
+		 */
+		uint16_t get_dropped(){
+			return mailbox_dropped;
+		}
+
+		/**
+		 * @brief Requeues a task after its deadline or state changed.
+		 *
+		 * In the list walk mode this does nothing, the next pass
+		 * picks the change up on its own.
+		 *
+		 * @param 	task			The task that changed
+		 */
+		void reschedule(task_t* task);
+
+		/**
+		 * @brief Gets the earliest deadline of the enabled tasks.
+		 *
+		 * @param 	deadline		Where to store the deadline (us)
+		 * @return	bool			False if no task is pending
+		 */
+		bool next_deadline(clock_us_t* deadline);
+
+		/**
+		 * @brief Sleeps until the next task deadline.
+		 *
+		 * Returns early when wake() is called.
+		 */
+		void idle();
+
+		/**
+		 * @brief Ends the current idle period (ISR safe).
+		 */
+		void wake(){
+			wake_pending = true;
+			if (wake_fxn) {
+				wake_fxn();
+			}
+		}
+
+		/**
+		 * @brief Sets the sleep primitive used when idle.
+		 *
+		 * @param 	fxn				The sleep primitive, NULL for the default
+		 * @param 	wake			Ends a sleep of fxn, NULL if interrupts do
+		 */
+		void set_sleep(idle_sleep_t fxn, idle_wake_t wake = NULL){
+			sleep_fxn 	= (fxn ? fxn : default_sleep);
+			wake_fxn 	= (fxn ? wake : NULL);
+		}
+
+		/**
+		 * @brief Gets the first registered task.
+		 *
+		 * @return	task			The head of the task list
+		 */
+		task_t* get_tasks(){
+			return first;
+		}
+
+		/**
+		 * @brief Gets the CPU load of the last profiling window.
+		 *
+		 * @return	load			The load in percent
+		 */
+		uint8_t get_load(){
+#ifdef SCHEDULER_PROFILE
+			return load;
+#else
+			return 0;
+#endif
+		}
+
+		/**
+		 * @brief Runs a task of a compile time table if it is due.
+		 *
+		 * The task type is known, so its run() method is called
+		 * directly and can be inlined.
+		 *
+		 * @param 	current			The task to dispatch
+		 */
+		template <class T>
+		void dispatch_static(T* current){
+
+			uint32_t latency;
+
+			if (prepare(current, &latency)) {
+				begin_run(current, latency);
+				current->run();
+				end_run(current);
+
+#ifdef SCHEDULER_HEAP_MODE
+				/*
+				 * Keep the heap ordered for the idle deadline
+				 */
+				reschedule(current);
+#endif
+			}
+		}
+
+#ifdef SCHEDULER_STATIC_TABLE
+		/**
+		 * @brief Sets the compile time task table.
+		 *
+		 * The table tasks are booted with BIOS_boot() from the
+		 * list task_table::collect() makes, for the controls and
+		 * the watchdog.
+		 *
+		 * @param 	tasks			The table, NULL to run the task list
+		 */
+		void set_table(task_table_base* tasks){
+			table = tasks;
+		}
+#endif
+
+		/**
+		 * @brief Starts the watchdog timer and the MCU watchdog.
+		 *
+		 * @return	status			The status to return
+		 */
+		status_code_t watchdog_start();
+
+#ifdef SCHEDULER_ANALYSIS
+		/**
+		 * @brief Checks the schedulability of the enabled tasks.
+		 *
+		 * Reports the schedule and the margin of every task, and
+		 * re-plans an infeasible set if allowed.
+		 *
+		 * @return	status			STATUS_ERR_DENIED if infeasible
+		 */
+		status_code_t analyze();
+#endif
+
+		/**
+		 * @brief Gets the current load shedding level.
+		 *
+		 * @return	level			Low priority intervals are stretched 2^level
+		 */
+		uint8_t get_shed_level(){
+#ifdef SCHEDULER_LOAD_SHEDDING
+			return shed_level;
+#else
+			return 0;
+#endif
+		}
+
+		/**
+		 * @brief The default deconstructor.
+		 */
+		~scheduler(){}
 };
 
 /**< @brief Typedef for the scheduler */
@@ -6,6 +6,12 @@
  */
 
 #include <task/task.h>
+#include <task/scheduler.h>
+
+/*
+ * The task whose callback is running
+ */
+task* task::active = NULL;
 
 /**
  * @brief Default constructor for the task class.
@@ -33,6 +39,34 @@ task::task(uint32_t interval, uint32_t iterations, callback_t callback, thread_i
 	_id = id;
 }
 
+/**
+ * @brief Constructor for a task bound to a context.
+ *
+ * @param interval		- the interval
+ * @param iterations	- the iterations
+ * @param callback		- the callback function, called with the context
+ * @param context		- the context passed to the callback
+ * @param id			- the thread id
+ */
+task::task(uint32_t interval, uint32_t iterations, context_callback_t callback, void* context, thread_id_t id){
+
+	/*
+	 * Reset the device
+	 */
+	reset();
+
+	/*
+	 * Explicit set
+	 */
+	set(interval, iterations, NULL);
+	set_callback(callback, context);
+
+	/*
+	 * Set the thread id
+	 */
+	_id = id;
+}
+
 /*
  * Control
  */
@@ -46,7 +80,14 @@ void task::enable(){
 	 * Enable the task
 	 */
 	_enabled = true;
-	_previous_millis = millis() - _interval;
+	_previous = sys_clock::now() - period();
+
+	/*
+	 * Requeue on the new deadline
+	 */
+	if(scheduler){
+		((scheduler_t*)scheduler)->reschedule(this);
+	}
 }
 
 /**
@@ -62,10 +103,18 @@ void task::task_delay(uint32_t delay){
 	/*
 	 * Set a delay
 	 */
-	if(! delay){
-		delay = _interval;
+	clock_us_t wait = CLOCK_MS(delay);
+	if(! wait){
+		wait = period();
+	}
+	_previous = sys_clock::now() - period() + wait;
+
+	/*
+	 * Requeue on the new deadline
+	 */
+	if(scheduler){
+		((scheduler_t*)scheduler)->reschedule(this);
 	}
-	_previous_millis = millis() - _interval  + delay;
 }
 
 /**
@@ -82,17 +131,48 @@ void task::enable_delayed(uint32_t delay){
 	task_delay(delay);
 }
 
+/**
+ * @brief Moves the task on a phase of its period
+ *
+ * The next run is at now + (phase modulo the period), the
+ * following ones keep the period.
+ *
+ * @param phase			- the phase in ms
+ */
+void task::set_phase(uint32_t phase){
+
+	/*
+	 * Nothing to spread
+	 */
+	if(! _interval){
+		return;
+	}
+
+	_previous = sys_clock::now() - period() + (CLOCK_MS(phase) % period());
+
+	/*
+	 * Requeue on the new deadline
+	 */
+	if(scheduler){
+		((scheduler_t*)scheduler)->reschedule(this);
+	}
+}
+
 /**
  * @brief Restarts task
  *
- * Task will run number of iterations again
+ * Task will run number of iterations again, from the
+ * start of its body
  */
 void task::restart(){
 
 	/*
-	 * Reset the iteration count
+	 * Reset the iteration count, and the body state
 	 */
 	_iterations = _set_iterations;
+	if(_restart_callback){
+		_restart_callback();
+	}
 	enable();
 }
 
@@ -109,6 +189,9 @@ void task::restart_delayed(uint32_t delay){
 	 * Delay the restart
 	 */
 	_iterations = _set_iterations;
+	if(_restart_callback){
+		_restart_callback();
+	}
 	enable_delayed(delay);
 }
 
@@ -123,6 +206,65 @@ void task::disable(){
 	 * Disable the task
 	 */
 	_enabled = false;
+
+	/*
+	 * Take it out of the deadline queue
+	 */
+	if(scheduler){
+		((scheduler_t*)scheduler)->reschedule(this);
+	}
+}
+
+/**
+ * @brief Resumes the task earlier than its interval
+ *
+ * @param ms				- the time before the next run
+ */
+void task::resume_in(uint32_t ms){
+
+	/*
+	 * Already due sooner
+	 */
+	clock_us_t wake = sys_clock::now() + CLOCK_MS(ms);
+	if(!clock_before(wake, next_run())){
+		return;
+	}
+
+	/*
+	 * Pull the deadline in
+	 */
+	_previous = wake - period();
+
+	/*
+	 * Requeue on the new deadline
+	 */
+	if(scheduler){
+		((scheduler_t*)scheduler)->reschedule(this);
+	}
+}
+
+/**
+ * @brief Schedules the task as a pipeline stage
+ *
+ * Runs the task as soon as the min gap since its last
+ * start allows.
+ */
+void task::trigger(){
+
+	/*
+	 * Not running
+	 */
+	if(!_enabled){
+		return;
+	}
+
+	/*
+	 * Rate limit, shed along with the interval
+	 */
+	clock_us_t gap 		= CLOCK_MS(_min_gap) << _shed;
+	clock_us_t since 	= sys_clock::now() - _last_run;
+
+	resume_in((since >= gap) ? 0 : (uint32_t)((gap - since + 999) / 1000));
 }
 
 /**
@@ -137,7 +279,7 @@ void task::get(uint32_t* interval, uint32_t* iterations, callback_t* callback){
 	/*
 	 * Return the data
 	 */
-	*interval 	= _interval;
+	*interval 	= _interval / 1000;
 	*iterations = _iterations;
 	*callback 	= _callback;
 }
@@ -158,9 +300,10 @@ void task::set(uint32_t interval, uint32_t iterations, callback_t callback){
 	/*
 	 * Set internals
 	 */
-	_interval 	= interval;
-	_iterations = iterations;
-	_callback 	= callback;
+	_interval 			= interval * 1000;
+	_iterations 		= iterations;
+	_set_iterations 	= iterations;
+	_callback 			= callback;
 }
 
 /**
@@ -173,11 +316,33 @@ void task::set(uint32_t interval, uint32_t iterations, callback_t callback){
  */
 void task::set_interval(uint32_t interval){
 
+	/*
+	 * Set the interval
+	 */
+	set_interval_us(interval * 1000);
+}
+
+/**
+ * @brief Sets the execution interval in us.
+ *
+ * For sub millisecond rates, see set_interval().
+ *
+ * @param interval 			- new execution interval in us
+ */
+void task::set_interval_us(uint32_t interval){
+
 	/*
 	 * Set the interval
 	 */
 	_interval = interval;
-	delay(DEFAULT_DELAY);
+	_previous = sys_clock::now();
+
+	/*
+	 * Requeue on the new deadline
+	 */
+	if(scheduler){
+		((scheduler_t*)scheduler)->reschedule(this);
+	}
 }
 
 
@@ -193,10 +358,46 @@ void task::reset(){
 	 * Reset the object
 	 */
 	_enabled 						= false;
-	_previous_millis 				= 0;
+	_previous 						= 0;
+	_iterations 					= 0;
+	_set_iterations 				= 0;
 	prev 							= NULL;
 	next 							= NULL;
 	scheduler 						= NULL;
 	_disable_on_last_iteration 		= false;
 	_overrun 						= 0;
+	_overrun_policy 				= TASK_OVERRUN_CATCH_UP;
+	_priority 						= TASK_PRIORITY_NORMAL;
+	_shed 							= 0;
+	_downstream 					= NULL;
+	_min_gap 						= 0;
+	_last_run 						= 0;
+	_budget 						= 0;
+	_wdt_action 					= TASK_WDT_DISABLE;
+	_checked_in 					= false;
+	_wdt_trips 						= 0;
+	_heap_index 					= -1;
+	_pass 							= 0;
+	_context_callback 				= NULL;
+	_restart_callback 				= NULL;
+	_context 						= NULL;
+	_run_start_us 					= 0;
+	_wcet 							= 0;
+
+	/*
+	 * Clear the profile
+	 */
+	reset_profile();
+}
+
+/**
+ * @brief Clears the execution profile
+ */
+void task::reset_profile(){
+
+	/*
+	 * Reset the counters
+	 */
+	memset(&_profile, 0, sizeof(task_profile_t));
+	_profile.min_us 				= 0xFFFFFFFF;
 }
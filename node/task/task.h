@@ -9,17 +9,74 @@
 #define TASK_TASK_H_
 
 #include <configs.h>
+#include <platform/clock/clock.h>
+#include <platform/os/os.h>
 
 /**
  * @brief callback definition
  */
 typedef void (*callback_t)();
 
+/**
+ * @brief Callback bound to a context (an object or sensor instance)
+ */
+typedef void (*context_callback_t)(void* context);
+
 /**
  * @brief Thread id
  */
 typedef uint8_t thread_id_t;
 
+/**
+ * @brief What a task does when it falls behind
+ */
+typedef enum {
+
+	TASK_OVERRUN_CATCH_UP,				//!< Run back to back until on time again
+	TASK_OVERRUN_SKIP,					//!< Drop the missed runs, restart from now
+	TASK_OVERRUN_COALESCE				//!< Drop the missed runs, keep the phase
+}task_overrun_t;
+
+/**
+ * @brief Task priority classes
+ */
+typedef enum {
+
+	TASK_PRIORITY_CRITICAL,				//!< TASK_PRIORITY_CRITICAL
+	TASK_PRIORITY_NORMAL,				//!< TASK_PRIORITY_NORMAL
+	TASK_PRIORITY_LOW					//!< TASK_PRIORITY_LOW, subject to load shedding
+}task_priority_t;
+
+/**
+ * @brief What the watchdog does with a task over budget
+ */
+typedef enum {
+
+	TASK_WDT_DISABLE,					//!< TASK_WDT_DISABLE
+	TASK_WDT_RESTART					//!< TASK_WDT_RESTART
+}task_wdt_action_t;
+
+/**
+ * @brief Number of start latency histogram bins
+ *
+ * Bin 0 holds 0 ms, bin n holds [2^(n-1), 2^n) ms and the last
+ * bin holds everything above.
+ */
+#define TASK_PROFILE_BINS		(8)
+
+/**
+ * @brief Task execution profile
+ */
+typedef struct {
+
+	uint32_t				runs;							// Number of executions
+	uint32_t				missed;							// Started after the next deadline
+	uint32_t				min_us;							// Shortest run time
+	uint32_t				max_us;							// Longest run time
+	uint64_t				total_us;						// Accumulated run time
+	uint16_t				latency[TASK_PROFILE_BINS];		// Start latency histogram
+}task_profile_t;
+
 /**
  * @brief This is the task interface
  *
@@ -51,11 +108,34 @@ class task {
 		volatile bool 			_enabled;
 		volatile bool 			_disable_on_last_iteration;
 
-		volatile uint32_t 		_interval;
+		volatile uint32_t 		_interval;			// us
 		volatile uint32_t 		_iterations;
 
-		volatile uint32_t 		_previous_millis;
-		volatile uint32_t 		_overrun;
+		volatile clock_us_t 	_previous;			// us
+		volatile int32_t 		_overrun;			// us
+
+		/*
+		 * Overrun policy, priority and load shedding level
+		 */
+		task_overrun_t			_overrun_policy;
+		task_priority_t			_priority;
+		uint8_t					_shed;
+
+		/*
+		 * Pipeline: next stage, trigger rate limit and last start
+		 */
+		task*					_downstream;
+		uint32_t				_min_gap;			// ms
+		clock_us_t				_last_run;			// us
+
+		/*
+		 * Watchdog: execution budget (ms, 0 is unwatched), action,
+		 * check in flag and number of trips
+		 */
+		uint32_t				_budget;
+		task_wdt_action_t		_wdt_action;
+		volatile bool			_checked_in;
+		uint16_t				_wdt_trips;
 
 		uint32_t 				_set_iterations;
 
@@ -64,11 +144,68 @@ class task {
 		 */
 		callback_t 				_callback;
 
+		/*
+		 * The context bound callback, used instead of _callback when set
+		 */
+		context_callback_t		_context_callback;
+
+		/*
+		 * Resets the resumable state of the body on a restart, NULL for none
+		 */
+		callback_t				_restart_callback;
+		void*					_context;
+
 		/*
 		 * Thread id to identify the thread
 		 */
 		thread_id_t				_id;
 
+		/*
+		 * Position in the scheduler deadline heap (-1 when not queued)
+		 */
+		int16_t					_heap_index;
+
+		/*
+		 * Last scheduler pass the task ran in
+		 */
+		uint32_t				_pass;
+
+		/*
+		 * Execution profile
+		 */
+		task_profile_t			_profile;
+		uint32_t				_run_start_us;
+
+		/*
+		 * Declared worst case execution time (us, 0 when unknown)
+		 */
+		uint32_t				_wcet;
+
+#ifdef SCHEDULER_PREEMPTIVE
+		/*
+		 * Wakes the task thread (deadline change, trigger, control)
+		 */
+		os_sem_t				_signal;
+#endif
+
+		/*
+		 * The task whose callback is running (NULL outside a callback)
+		 */
+		static task*			active;
+
+		/**
+		 * @brief Gets the task running in the caller context.
+		 *
+		 * @return task*		- the task, NULL outside a callback
+		 */
+		static task* running(){
+#ifdef SCHEDULER_PREEMPTIVE
+			return (task*)os_thread_context();
+#else
+			return active;
+#endif
+		}
+
 	/*
 	 * Public access methods
 	 */
@@ -88,6 +225,17 @@ class task {
 		 */
 		task(uint32_t interval, uint32_t iterations, callback_t callback, thread_id_t id);
 
+		/**
+		 * @brief Constructor for a task bound to a context.
+		 *
+		 * @param interval		- the interval
+		 * @param iterations	- the iterations
+		 * @param callback		- the callback function, called with the context
+		 * @param context		- the context passed to the callback
+		 * @param id			- the thread id
+		 */
+		task(uint32_t interval, uint32_t iterations, context_callback_t callback, void* context, thread_id_t id);
+
 		/**
 		 * @brief The default deconstructor for the class object.
 		 */
@@ -119,10 +267,21 @@ class task {
 		 */
 		void enable_delayed(uint32_t delay);
 
+		/**
+		 * @brief Moves the task on a phase of its period
+		 *
+		 * The next run is at now + (phase modulo the period), the
+		 * following ones keep the period.
+		 *
+		 * @param phase			- the phase in ms
+		 */
+		void set_phase(uint32_t phase);
+
 		/**
 		 * @brief Restarts task
 		 *
-		 * Task will run number of iterations again
+		 * Task will run number of iterations again, from the
+		 * start of its body
 		 */
 		void restart();
 
@@ -185,10 +344,10 @@ class task {
 		/**
 		 * @brief Gets the interval
 		 *
-		 * @return interval			- the interval
+		 * @return interval			- the interval in ms
 		 */
 		uint32_t get_interval(){
-			return _interval;
+			return (_interval / 1000);
 		}
 
 		/**
@@ -200,6 +359,68 @@ class task {
 			return _iterations;
 		}
 
+		/**
+		 * @brief Gets the next time the task is due
+		 *
+		 * @return us				- the next fire time in us
+		 */
+		clock_us_t next_run(){
+			return _previous + period();
+		}
+
+		/**
+		 * @brief Gets the effective interval
+		 *
+		 * The interval stretched by the load shedding level.
+		 *
+		 * @return period			- the effective interval in us
+		 */
+		clock_us_t period(){
+			return ((clock_us_t)_interval << _shed);
+		}
+
+		/**
+		 * @brief Resumes the task earlier than its interval
+		 *
+		 * Used by coroutines to come back after a yield or a sleep.
+		 * Never pushes the next run later. Every resume counts as
+		 * an iteration.
+		 *
+		 * @param ms				- the time before the next run
+		 */
+		void resume_in(uint32_t ms);
+
+		/**
+		 * @brief Schedules the task as a pipeline stage
+		 *
+		 * Runs the task as soon as the min gap since its last
+		 * start allows.
+		 */
+		void trigger();
+
+		/**
+		 * @brief Gets the execution profile
+		 *
+		 * @return profile			- the task profile
+		 */
+		task_profile_t* get_profile(){
+			return &_profile;
+		}
+
+		/**
+		 * @brief Gets the average run time
+		 *
+		 * @return us				- the average run time in us
+		 */
+		uint32_t get_avg_runtime(){
+			return (_profile.runs ? (uint32_t)(_profile.total_us / _profile.runs) : 0);
+		}
+
+		/**
+		 * @brief Clears the execution profile
+		 */
+		void reset_profile();
+
 		/**
 		 * @brief Explicitly get Task execution parameters
 		 *
@@ -232,13 +453,91 @@ class task {
 		 */
 		void set_interval(uint32_t interval);
 
+		/**
+		 * @brief Sets the execution interval in us.
+		 *
+		 * For sub millisecond rates, see set_interval().
+		 *
+		 * @param interval 			- new execution interval in us
+		 */
+		void set_interval_us(uint32_t interval);
+
 		/**
 		 * @brief Sets the iterations
 		 *
 		 * @param iterations		- number of iterations to run
 		 */
 		void set_iterations(uint32_t iterations){
-			_iterations = iterations;
+			_iterations 	= iterations;
+			_set_iterations = iterations;
+		}
+
+		/**
+		 * @brief Sets the overrun policy
+		 *
+		 * @param policy			- what to do when the task falls behind
+		 */
+		void set_overrun_policy(task_overrun_t policy){
+			_overrun_policy = policy;
+		}
+
+		/**
+		 * @brief Sets the priority class
+		 *
+		 * @param priority			- the priority class
+		 */
+		void set_priority(task_priority_t priority){
+			_priority = priority;
+		}
+
+		/**
+		 * @brief Chains a pipeline stage after this task
+		 *
+		 * The next stage is triggered each time this task returns.
+		 *
+		 * @param next				- the next stage, NULL to unchain
+		 * @param min_gap			- the min time between two triggered runs of next
+		 */
+		void set_downstream(task* next, uint32_t min_gap){
+			_downstream = next;
+			if(next){
+				next->_min_gap = min_gap;
+			}
+		}
+
+		/**
+		 * @brief Sets the watchdog execution budget
+		 *
+		 * @param budget			- the max run time in ms, 0 to unwatch
+		 * @param action			- what to do when the budget is exceeded
+		 */
+		void set_budget(uint32_t budget, task_wdt_action_t action){
+			_budget 	= budget;
+			_wdt_action = action;
+		}
+
+		/**
+		 * @brief Declares the worst case execution time
+		 *
+		 * Used by the schedulability analysis, see scheduler::analyze().
+		 *
+		 * @param wcet				- the worst case run time in us, 0 if unknown
+		 */
+		void set_wcet(uint32_t wcet){
+			_wcet = wcet;
+		}
+
+		/**
+		 * @brief Gets the worst case execution time for the analysis
+		 *
+		 * The larger of the declared and the measured one, the
+		 * watchdog budget when both are unknown.
+		 *
+		 * @return uint32_t			- the worst case run time in us
+		 */
+		uint32_t get_wcet(){
+			uint32_t wcet = (_profile.max_us > _wcet) ? _profile.max_us : _wcet;
+			return wcet ? wcet : (_budget * 1000);
 		}
 
 		/**
@@ -247,7 +546,40 @@ class task {
 		 * @param					- the new callback function
 		 */
 		void set_callback(callback_t fp){
-			_callback = fp;
+			_callback 			= fp;
+			_context_callback 	= NULL;
+		}
+
+		/**
+		 * @brief Sets a callback bound to a context
+		 *
+		 * @param fp				- the new callback function
+		 * @param context			- the context passed to the callback
+		 */
+		void set_callback(context_callback_t fp, void* context){
+			_context_callback 	= fp;
+			_context 			= context;
+		}
+
+		/**
+		 * @brief Sets the restart callback
+		 *
+		 * Called by restart(), a coroutine task resets its state there
+		 * so the body runs from its start again.
+		 *
+		 * @param fp				- the restart callback, NULL for none
+		 */
+		void set_restart_callback(callback_t fp){
+			_restart_callback 	= fp;
+		}
+
+		/**
+		 * @brief Gets the context of the callback
+		 *
+		 * @return void*			- the context, NULL when none
+		 */
+		void* get_context(){
+			return _context;
 		}
 
 	/*
@@ -267,4 +599,16 @@ class task {
 /**< @brief Typedef for the task */
 typedef task task_t;
 
+/**
+ * @brief Adapts a member function to a context callback.
+ *
+ * Usage: set_callback(&task_method<sensor_task, &sensor_task::sample>, this)
+ *
+ * @param context		- the object to call the method on
+ */
+template <class T, void (T::*method)()>
+void task_method(void* context){
+	(static_cast<T*>(context)->*method)();
+}
+
 #endif /* TASK_TASK_H_ */
@@ -0,0 +1,137 @@
+/*
+ * task_table.h
+ */
+
+#ifndef TASK_TASK_TABLE_H_
+#define TASK_TASK_TABLE_H_
+
+/*
+ * Necessary
+ */
+#include <configs.h>
+#include "scheduler.h"
+
+/**
+ * @brief Compile time task table interface.
+ *
+ * The scheduler only holds this interface, so a whole table
+ * costs a single virtual call per pass, not one per task. Inside
+ * the table every task type is known and its run() method is
+ * called directly. The table also lists its tasks for BIOS_boot(),
+ * so they are declared once.
+ */
+class task_table_base {
+
+	public:
+
+		/**
+		 * @brief Lists the tasks of the table, in table order.
+		 *
+		 * @param tasks			- where to store the task pointers
+		 * @param max			- the room in tasks
+		 * @return uint8_t		- the number of tasks in the table
+		 */
+		virtual uint8_t collect(task_t* tasks[], uint8_t max) = 0;
+
+		/**
+		 * @brief Runs every due task of the table, in table order.
+		 *
+		 * @param s				- the scheduler
+		 */
+		virtual void dispatch(scheduler_t* s) = 0;
+
+		/**
+		 * @brief Virtual deconstructor
+		 */
+		virtual ~task_table_base(){}
+};
+
+/**
+ * @brief End of a task list.
+ */
+struct task_list_end {
+
+	inline uint8_t collect_all(task_t*[], uint8_t, uint8_t index){
+		return index;
+	}
+	inline void dispatch_all(scheduler_t*){}
+};
+
+/**
+ * @brief Compile time list of task instances.
+ *
+ * Each task class has to expose a public run() method.
+ * Usage: task_list<daq_t, task_list<update_t> >
+ */
+template <class T, class Next = task_list_end>
+struct task_list {
+
+	/*
+	 * The task of this node and the rest of the list
+	 */
+	T 		head;
+	Next 	tail;
+
+	/**
+	 * @brief Lists the tasks, unrolled at compile time.
+	 *
+	 * @param tasks			- where to store the task pointers
+	 * @param max			- the room in tasks
+	 * @param index			- the position of this task
+	 * @return uint8_t		- the number of tasks up to the end
+	 */
+	inline uint8_t collect_all(task_t* tasks[], uint8_t max, uint8_t index){
+		if(index < max){
+			tasks[index] = &head;
+		}
+		return tail.collect_all(tasks, max, index + 1);
+	}
+
+	/**
+	 * @brief Dispatches the tasks, unrolled at compile time.
+	 *
+	 * @param s				- the scheduler
+	 */
+	inline void dispatch_all(scheduler_t* s){
+		s->dispatch_static(&head);
+		tail.dispatch_all(s);
+	}
+};
+
+/**
+ * @brief Compile time task table.
+ *
+ * Usage: task_table< task_list<daq_t, task_list<idle_t> > > table;
+ */
+template <class List>
+class task_table : public task_table_base {
+
+	public:
+
+		/*
+		 * The task instances
+		 */
+		List list;
+
+		/**
+		 * @brief Lists the tasks of the table, in table order.
+		 *
+		 * @param tasks			- where to store the task pointers
+		 * @param max			- the room in tasks
+		 * @return uint8_t		- the number of tasks in the table
+		 */
+		uint8_t collect(task_t* tasks[], uint8_t max){
+			return list.collect_all(tasks, max, 0);
+		}
+
+		/**
+		 * @brief Runs every due task of the table, in table order.
+		 *
+		 * @param s				- the scheduler
+		 */
+		void dispatch(scheduler_t* s){
+			list.dispatch_all(s);
+		}
+};
+
+#endif /* TASK_TASK_TABLE_H_ */
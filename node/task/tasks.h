@@ -13,6 +13,8 @@
  * Include the task and scheduler
  */
 #include "scheduler.h"
+#include "coroutine.h"
+#include "task_table.h"
 
 #include "tasks/daq.h"
 #include "tasks/idle.h"
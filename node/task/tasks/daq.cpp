@@ -12,9 +12,32 @@
  *
  * This is the daq task constructor. It sets all
  * internal parameters to the task itself and enables it.
+ * A daq task can be bound to a single sensor so each
+ * sensor gets its own rate, budget and thread id.
+ *
+ * @param sensor			- the sensor to sample, NULL for all the BIOS sensors
+ * @param id				- the thread id
+ * @param rate				- the sampling interval in ms
  */
-daq::daq() : \
-	task_t(interval, iterations, daq_task_cb, DAQ_THREAD_ID){
+daq::daq(sensor_t* sensor, thread_id_t id, uint32_t rate) : \
+	task_t(rate, iterations, &task_method<daq, &daq::sample>, this, id){
+
+	/*
+	 * Bind the sensor
+	 */
+	_sensor = sensor;
+
+	/*
+	 * Keep the sampling grid when late
+	 */
+	set_overrun_policy(TASK_OVERRUN_COALESCE);
+
+	/*
+	 * The sampling has to keep going for the MCU watchdog to be fed
+	 */
+	set_priority(TASK_PRIORITY_CRITICAL);
+	set_budget(DAQ_TASK_BUDGET, TASK_WDT_RESTART);
+	set_wcet(DAQ_TASK_WCET);
 
 	/*
 	 * We enable the task right away
@@ -28,13 +51,25 @@ daq::daq() : \
  * This is the daq task callback method that will
  * get hooked into the squeduler framework.
  */
-void daq::daq_task_cb(){
+void daq::sample(){
 
 	/*
 	 * Containers
 	 */
 	uint8_t	  	index	= 0;
-	sensor_t* 	sensor 	= NULL;
+	sensor_t* 	sensor 	= _sensor;
+
+	/*
+	 * Bound to a single sensor
+	 */
+	if(sensor){
+		sensor->irq_service();
+		if(! read(sensor)){
+			system_base::BIOS_alert(BIOS_ALERT_TASK_FAIL);
+			system_base::BIOS_reboot(BIOS_REBOOT_OS);
+		}
+		return;
+	}
 
 	/*
 	 * In this task, we read the data from each sensor
@@ -44,9 +79,14 @@ void daq::daq_task_cb(){
 	 * with the most pertinent data.
 	 */
 	do{
-		sensor = (sensor_t*)&system_base::sensors_base[index];
+		sensor = system_base::sensors_base[index];
 		if(sensor){ // Valid check of the sensor
-			if(sensor->run()){
+
+			/*
+			 * Late interrupt bottom half, same bus, same context
+			 */
+			sensor->irq_service();
+			if(read(sensor)){
 				index ++;
 			}else{
 				system_base::BIOS_alert(BIOS_ALERT_TASK_FAIL);
@@ -55,3 +95,29 @@ void daq::daq_task_cb(){
 		}
 	}while(sensor);
 }
+
+/**
+ * @brief Reads one sensor
+ *
+ * A sampled sensor gets its ring drained in blocks, teed to the
+ * sampler sinks, the others are read now.
+ *
+ * @param sensor			- the sensor to read
+ * @return bool				- true if the cache was updated
+ */
+bool daq::read(sensor_t* sensor){
+
+#ifdef SENSOR_SAMPLER
+	if(sampler_t::owns(sensor)){
+		uint16_t count;
+		sampler_t::poll();
+		while((count = sampler_t::drain(_block, DAQ_BATCH_SIZE)) > 0){
+			if(!sensor->commit(_block, count)){
+				return false;
+			}
+		}
+		return true;
+	}
+#endif
+	return sensor->run();
+}
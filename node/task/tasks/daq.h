@@ -27,6 +27,9 @@
 #define DAQ_TASK_INTERVAL			(100)	// EXECUTE EVERY 100 ms
 #define DAQ_TASK_ITERATIONS			(-1)	// NO LIMIT
 #define DAQ_THREAD_ID				(1)		// DEFAULT ID
+#define DAQ_TASK_BUDGET				(50)	// WATCHDOG BUDGET 50 ms
+#define DAQ_TASK_WCET				(5000)	// WORST CASE 5 ms (both sensors)
+#define DAQ_BATCH_SIZE				(32)	// SAMPLES PER COMMITTED BLOCK
 
 using namespace system_base;
 
@@ -54,14 +57,27 @@ class daq : public task_t {
 		 *
 		 * This is the daq task constructor. It sets all
 		 * internal parameters to the task itself and enables it.
+		 * A daq task can be bound to a single sensor so each
+		 * sensor gets its own rate, budget and thread id.
+		 *
+		 * @param sensor			- the sensor to sample, NULL for all the BIOS sensors
+		 * @param id				- the thread id
+		 * @param rate				- the sampling interval in ms
 		 */
-		daq();
+		daq(sensor_t* sensor = NULL, thread_id_t id = DAQ_THREAD_ID, uint32_t rate = DAQ_TASK_INTERVAL);
 
 		/**
 		 * @brief The default deconstructor
 		 */
 		~daq(){};
 
+		/**
+		 * @brief Runs the task body (compile time task tables)
+		 */
+		inline void run(){
+			sample();
+		}
+
 	/*
 	 * Private access methods
 	 */
@@ -73,13 +89,36 @@ class daq : public task_t {
 		static const uint32_t 	interval		= DAQ_TASK_INTERVAL;
 		static const uint32_t 	iterations		= DAQ_TASK_ITERATIONS;
 
+		/*
+		 * The bound sensor, NULL for all
+		 */
+		sensor_t*				_sensor;
+
+#ifdef SENSOR_SAMPLER
+		/*
+		 * Block drained from the sampler ring
+		 */
+		sensor_sample_t			_block[DAQ_BATCH_SIZE];
+#endif
+
 		/**
 		 * @brief Daq task callback
 		 *
 		 * This is the daq task callback method that will
 		 * get hooked into the squeduler framework.
 		 */
-		static void daq_task_cb();
+		void sample();
+
+		/**
+		 * @brief Reads one sensor
+		 *
+		 * A sampled sensor gets its ring drained in blocks, teed to the
+		 * sampler sinks, the others are read now.
+		 *
+		 * @param sensor			- the sensor to read
+		 * @return bool				- true if the cache was updated
+		 */
+		bool read(sensor_t* sensor);
 };
 
 /**< Typedef */
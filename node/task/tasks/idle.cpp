@@ -21,20 +21,48 @@ idle::idle() : \
 	 */
 	pinMode(HEARTBEAT_LED, OUTPUT);
 
+	/*
+	 * No backlog of heartbeats, first to go under load
+	 */
+	set_overrun_policy(TASK_OVERRUN_SKIP);
+	set_priority(TASK_PRIORITY_LOW);
+	set_wcet(IDLE_TASK_WCET);
+	set_restart_callback(idle_restart);
+
 	/*
 	 * We enable the task right away
 	 */
 	enable();
 }
 
+/*
+ * Coroutine state
+ */
+coroutine_t idle::co;
+
+/**
+ * @brief Restart callback, the body starts over
+ */
+void idle::idle_restart(){
+	COROUTINE_RESET(&co);
+}
+
 /**
  * @brief Idle task callback
  *
  * This is the idle task callback method that will
- * get hooked into the squeduler framework.
+ * get hooked into the squeduler framework. It also
+ * services the coms link.
  */
 void idle::idle_task_cb(){
 
+	/*
+	 * Keep the links up, never blocks
+	 */
+	system_base::system_coms->service();
+
+	COROUTINE_BEGIN(&co);
+
 	/*
 	 * Set the new state of the system
 	 */
@@ -61,6 +89,9 @@ void idle::idle_task_cb(){
 		system_base::BIOS_reboot(BIOS_REBOOT_COMS);
 	}
 
+	// Keep the led visible without holding the cpu
+	COROUTINE_SLEEP_FOR(&co, IDLE_LED_ON_TIME);
+
 	// Shutdown the led
 	digitalWrite(HEARTBEAT_LED, LOW);
 
@@ -68,4 +99,6 @@ void idle::idle_task_cb(){
 	 * Set the new state of the system
 	 */
 	system_base::BIOS_state(SYS_STATE_ACTIVE);
+
+	COROUTINE_END(&co);
 }
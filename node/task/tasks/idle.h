@@ -13,6 +13,7 @@
  */
 #include <configs.h>
 #include <task/task.h>
+#include <task/coroutine.h>
 
 /*
  * Peripherals
@@ -25,6 +26,9 @@
 #define IDLE_TASK_INTERVAL			(500)	// EXECUTE EVERY 500 ms
 #define IDLE_TASK_ITERATIONS		(-1)	// NO LIMIT
 #define IDLE_THREAD_ID				(0)		// DEFAULT ID
+#define IDLE_TASK_WCET				(20000)	// WORST CASE 20 ms (link service)
+
+#define IDLE_LED_ON_TIME			(50)	// Heartbeat blink (ms)
 
 using namespace system_base;
 
@@ -55,6 +59,13 @@ class idle : public task_t {
 		 */
 		~idle(){};
 
+		/**
+		 * @brief Runs the task body (compile time task tables)
+		 */
+		inline void run(){
+			idle_task_cb();
+		}
+
 	/*
 	 * Private access methods
 	 */
@@ -66,13 +77,24 @@ class idle : public task_t {
 		static const uint32_t 	interval		= IDLE_TASK_INTERVAL;
 		static const uint32_t 	iterations		= IDLE_TASK_ITERATIONS;
 
+		/*
+		 * Coroutine state
+		 */
+		static coroutine_t		co;
+
 		/**
 		 * @brief Idle task callback
 		 *
 		 * This is the idle task callback method that will
-		 * get hooked into the squeduler framework.
+		 * get hooked into the squeduler framework. It also
+		 * services the coms link.
 		 */
 		static void idle_task_cb();
+
+		/**
+		 * @brief Restart callback, the body starts over
+		 */
+		static void idle_restart();
 };
 
 /**< Typedef */
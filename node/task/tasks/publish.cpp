@@ -16,17 +16,39 @@
 publish::publish() : \
 	task_t(interval, iterations, publish_task_cb, PUB_THREAD_ID){
 
+	/*
+	 * No backlog of publishes, first to go under load
+	 */
+	set_overrun_policy(TASK_OVERRUN_SKIP);
+	set_priority(TASK_PRIORITY_LOW);
+	set_budget(PUB_TASK_BUDGET, TASK_WDT_RESTART);
+	set_wcet(PUB_TASK_WCET);
+	set_restart_callback(publish_restart);
+
 	/*
 	 * Enable the task
 	 */
 	enable();
 }
 
+/*
+ * Coroutine state
+ */
+coroutine_t publish::co;
+
+/**
+ * @brief Restart callback, the body starts over
+ */
+void publish::publish_restart(){
+	COROUTINE_RESET(&co);
+}
+
 /**
  * @brief Publish task callback
  *
  * This is the publish task callback method that will
- * get hooked into the squeduler framework.
+ * get hooked into the squeduler framework. It publishes
+ * one cache per resume and sleeps in between.
  */
 void publish::publish_task_cb(){
 
@@ -40,14 +62,18 @@ void publish::publish_task_cb(){
 	 *
 	 * - Status
 	 * - Data
+	 *
+	 * The cursor lives across the sleeps.
 	 */
-	cache_list_t* cache = system_base::list;
+	static cache_list_t* cache;
+
+	COROUTINE_BEGIN(&co);
 
 	/*
 	 * We iterate through the message types to send and we
 	 * format the appropriate cache to a string to then send it off.
 	 */
-	do{
+	for(cache = system_base::list; cache; cache = cache->next){
 
 		/*
 		 * Only publish the data and the status
@@ -64,12 +90,13 @@ void publish::publish_task_cb(){
 			 * Send the string the the mqtt component
 			 */
 			system_base::system_coms->send(cache->msg, json);
-			delay(PUB_SLEEP); // sleep for a bit
+
+			/*
+			 * Let the other tasks run for a bit
+			 */
+			COROUTINE_SLEEP_FOR(&co, PUB_SLEEP);
 		}
+	}
 
-		/*
-		 * Update to the next cache
-		 */
-		cache = cache->next;
-	}while(cache);
+	COROUTINE_END(&co);
 }
@@ -13,6 +13,7 @@
  */
 #include <configs.h>
 #include <task/task.h>
+#include <task/coroutine.h>
 
 /*
  * Peripherals
@@ -27,8 +28,10 @@
 #define PUB_TASK_INTERVAL			(500)	// EXECUTE EVERY 500 ms
 #define PUB_TASK_ITERATIONS			(-1)	// NO LIMIT
 #define PUB_THREAD_ID				(3)		// DEFAULT ID
+#define PUB_TASK_BUDGET				(500)	// WATCHDOG BUDGET 500 ms
+#define PUB_TASK_WCET				(30000)	// WORST CASE 30 ms (one publish)
 
-#define PUB_SLEEP					(1000)	// Sleep for 1sec
+#define PUB_SLEEP					(1000)	// Sleep for 1sec between caches
 
 using namespace system_base;
 
@@ -60,6 +63,13 @@ class publish : public task_t {
 		 */
 		~publish(){};
 
+		/**
+		 * @brief Runs the task body (compile time task tables)
+		 */
+		inline void run(){
+			publish_task_cb();
+		}
+
 	/*
 	 * Private access methods
 	 */
@@ -71,13 +81,24 @@ class publish : public task_t {
 		static const uint32_t 	interval		= PUB_TASK_INTERVAL;
 		static const uint32_t 	iterations		= PUB_TASK_ITERATIONS;
 
+		/*
+		 * Coroutine state
+		 */
+		static coroutine_t		co;
+
 		/**
 		 * @brief Publish task callback
 		 *
 		 * This is the publish task callback method that will
-		 * get hooked into the squeduler framework.
+		 * get hooked into the squeduler framework. It publishes
+		 * one cache per resume and sleeps in between.
 		 */
 		static void publish_task_cb();
+
+		/**
+		 * @brief Restart callback, the body starts over
+		 */
+		static void publish_restart();
 };
 
 /**< Typedef */
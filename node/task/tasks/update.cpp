@@ -16,6 +16,13 @@
 update::update(): \
 	task_t(interval, iterations, update_task_cb, UPDATE_THREAD_ID){
 
+	/*
+	 * One update covers all the missed ones
+	 */
+	set_overrun_policy(TASK_OVERRUN_COALESCE);
+	set_budget(UPDATE_TASK_BUDGET, TASK_WDT_RESTART);
+	set_wcet(UPDATE_TASK_WCET);
+
 	/*
 	 * Enable the task from the get go
 	 */
@@ -25,6 +25,8 @@
 #define UPDATE_TASK_INTERVAL			(500)	// EXECUTE EVERY 500 ms
 #define UPDATE_TASK_ITERATIONS			(-1)	// NO LIMIT
 #define UPDATE_THREAD_ID				(2)		// DEFAULT ID
+#define UPDATE_TASK_BUDGET				(100)	// WATCHDOG BUDGET 100 ms
+#define UPDATE_TASK_WCET				(2000)	// WORST CASE 2 ms
 
 using namespace system_base;
 
@@ -55,6 +57,13 @@ class update : public task_t {
 		 */
 		~update(){};
 
+		/**
+		 * @brief Runs the task body (compile time task tables)
+		 */
+		inline void run(){
+			update_task_cb();
+		}
+
 	/*
 	 * Private access methods
 	 */
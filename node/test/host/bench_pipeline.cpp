@@ -0,0 +1,157 @@
+/*
+ * bench_pipeline.cpp
+ *
+ * Age of the published sample, DAQ -> UPDATE -> PUBLISH chained as
+ * a pipeline against the same tasks on their own timers. The timer
+ * runs are repeated over the stage phases, the age depends on them.
+ */
+
+#include "host.h"
+
+#include <task/task.h>
+#include <task/scheduler.h>
+
+/*
+ * The task intervals (ms), as in tasks/
+ */
+#define BENCH_DAQ_MS		(100)
+#define BENCH_UPDATE_MS		(500)
+#define BENCH_PUBLISH_MS	(500)
+
+/*
+ * Simulated run times (ms)
+ */
+#define BENCH_DAQ_COST		(5)
+#define BENCH_UPDATE_COST	(2)
+#define BENCH_PUBLISH_COST	(20)
+
+/*
+ * Simulated span per run, phase step of the timer runs
+ */
+#define BENCH_SPAN_MS		(20000)
+#define BENCH_PHASE_MS		(50)
+
+/**
+ * @brief Sample age at publish, in us
+ */
+typedef struct {
+
+	uint32_t				publishes;
+	uint64_t				total;
+	uint32_t				max;
+}age_t;
+
+/*
+ * The sample in flight through the stages
+ */
+static clock_us_t			sampled 	= 0;
+static clock_us_t			updated 	= 0;
+static bool					fresh 		= false;
+static age_t*				age;
+
+static void daq_cb(){
+	delay(BENCH_DAQ_COST);
+	sampled = sys_clock::now();
+}
+
+static void update_cb(){
+	delay(BENCH_UPDATE_COST);
+	updated = sampled;
+	fresh 	= true;
+}
+
+static void publish_cb(){
+
+	delay(BENCH_PUBLISH_COST);
+	if(!fresh){
+		return;
+	}
+
+	uint32_t at = (uint32_t)(sys_clock::now() - updated);
+	age->publishes++;
+	age->total += at;
+	if(at > age->max){
+		age->max = at;
+	}
+}
+
+/**
+ * @brief Runs the three stages for the span.
+ *
+ * @param 	pipeline		Chain the stages
+ * @param 	update_phase	UPDATE start after DAQ (ms)
+ * @param 	publish_phase	PUBLISH start after DAQ (ms)
+ * @param 	result			Where to add the ages
+ */
+static void run(bool pipeline, uint32_t update_phase, uint32_t publish_phase, age_t* result){
+
+	scheduler_t	sched;
+	task_t		daq(BENCH_DAQ_MS, -1, daq_cb, 0);
+	task_t		update(BENCH_UPDATE_MS, -1, update_cb, 1);
+	task_t		publish(BENCH_PUBLISH_MS, -1, publish_cb, 2);
+
+	age 	= result;
+	fresh 	= false;
+
+	sched.add_task(&daq);
+	sched.add_task(&update);
+	sched.add_task(&publish);
+
+	if(pipeline){
+		daq.set_downstream(&update, PIPELINE_UPDATE_MIN_GAP);
+		update.set_downstream(&publish, PIPELINE_PUBLISH_MIN_GAP);
+	}
+
+	daq.enable();
+	update.enable_delayed(update_phase);
+	publish.enable_delayed(publish_phase);
+
+	clock_us_t end = sys_clock::now() + CLOCK_MS(BENCH_SPAN_MS);
+	while(clock_before(sys_clock::now(), end)){
+		sched.run();
+		sched.idle();
+	}
+}
+
+/**
+ * @brief Prints the ages of a mode.
+ */
+static void report(const char* mode, age_t* result){
+
+	printf("%-8s: %5u publishes, age mean %6llu us, max %6u us\n", mode, result->publishes,
+			(unsigned long long)(result->publishes ? (result->total / result->publishes) : 0),
+			result->max);
+}
+
+int main(){
+
+	age_t timer 	= {0, 0, 0};
+	age_t chained 	= {0, 0, 0};
+
+	host_reset(0);
+	host_spin(1);
+	sys_clock::start();
+
+	/*
+	 * Over the stage phases, the timer runs get every alignment
+	 */
+	for(uint32_t u = BENCH_PHASE_MS; u < BENCH_UPDATE_MS; u += BENCH_PHASE_MS){
+		for(uint32_t p = BENCH_PHASE_MS; p < BENCH_PUBLISH_MS; p += BENCH_PHASE_MS){
+			run(false, u, p, &timer);
+			run(true, u, p, &chained);
+		}
+	}
+
+	report("timer", &timer);
+	report("pipeline", &chained);
+
+	/*
+	 * The pipeline publishes a sample at most a DAQ interval old, plus
+	 * the stage run times and the loop passes (1 ms)
+	 */
+	CHECK(chained.publishes > 0);
+	CHECK((chained.total / chained.publishes) < (timer.total / timer.publishes));
+	CHECK(chained.max <= CLOCK_MS(BENCH_DAQ_MS + BENCH_UPDATE_COST + BENCH_PUBLISH_COST + 1));
+
+	return host_report("bench_pipeline");
+}
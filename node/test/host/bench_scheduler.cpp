@@ -0,0 +1,104 @@
+/*
+ * bench_scheduler.cpp
+ *
+ * Cost of a scheduler pass, list walk against deadline heap, for
+ * 4, 32 and 255 tasks. Built once per mode (HOST_LIST_WALK).
+ */
+
+#include "host.h"
+
+#include <task/task.h>
+#include <task/scheduler.h>
+#include <time.h>
+
+/*
+ * Simulated span, one pass per ms
+ */
+#define BENCH_SPAN_MS		(10000)
+
+/*
+ * Task sets, the largest is every free 8 bit thread id
+ */
+static const uint16_t		sizes[] = {4, 32, 255};
+
+/*
+ * Callback runs
+ */
+static uint32_t				runs = 0;
+
+static void count(){
+	runs++;
+}
+
+/**
+ * @brief Host time in ns.
+ */
+static uint64_t wall_ns(){
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec);
+}
+
+/**
+ * @brief Runs a task set for the span and prints the cost per pass.
+ *
+ * @param 	size			The number of tasks
+ */
+static void bench(uint16_t size){
+
+	scheduler_t*	sched 		= new scheduler_t();
+	task_t**		tasks 		= new task_t*[size];
+	uint32_t		expected 	= 0;
+	uint64_t		busy 		= 0;
+
+	host_reset(0);
+	runs = 0;
+
+	/*
+	 * Periods of 10 to 80 ms, a handful due on each pass
+	 */
+	for(uint16_t i = 0; i < size; i++){
+		uint32_t interval = 10 * (1 + (i % 8));
+		tasks[i] = new task_t(interval, -1, count, (thread_id_t)i);
+		sched->add_task(tasks[i]);
+		tasks[i]->enable();
+		expected += (BENCH_SPAN_MS + interval - 1) / interval;
+	}
+
+	for(uint32_t pass = 0; pass < BENCH_SPAN_MS; pass++){
+
+		uint64_t start = wall_ns();
+		sched->run();
+		busy += wall_ns() - start;
+
+		host_advance(1000);
+	}
+
+	/*
+	 * Both modes run every task on its deadlines
+	 */
+	CHECK(runs == expected);
+
+#ifdef SCHEDULER_HEAP_MODE
+	const char* mode = "heap";
+#else
+	const char* mode = "list";
+#endif
+	printf("%s, %3u tasks: %6llu ns/pass, %u runs\n", mode, size,
+			(unsigned long long)(busy / BENCH_SPAN_MS), runs);
+
+	for(uint16_t i = 0; i < size; i++){
+		delete tasks[i];
+	}
+	delete[] tasks;
+	delete sched;
+}
+
+int main(){
+
+	for(uint8_t i = 0; i < (sizeof(sizes) / sizeof(sizes[0])); i++){
+		bench(sizes[i]);
+	}
+	return host_report("bench_scheduler");
+}
@@ -0,0 +1,747 @@
+/*
+ * host.cpp
+ */
+
+#include "host.h"
+
+#include <Energia.h>
+#include <Wire.h>
+#include <inc/hw_memmap.h>
+#include <driverlib/interrupt.h>
+#include <driverlib/prcm.h>
+#include <driverlib/timer.h>
+#include <driverlib/i2c.h>
+#include <driverlib/wdt.h>
+
+#include <pthread.h>
+#include <time.h>
+
+/*
+ * Simulated ticks per us
+ */
+#define HOST_TICKS_PER_US		(F_CPU / 1000000)
+
+/*
+ * Timers, one per general purpose timer base
+ */
+#define HOST_TIMERS				(4)
+
+/*
+ * Pending one shot interrupt sources
+ */
+#define HOST_EVENTS				(64)
+
+/*
+ * Pins
+ */
+#define HOST_PINS				(64)
+
+/**
+ * @brief A general purpose timer, full width periodic
+ */
+typedef struct {
+
+	bool					enabled;
+	bool					int_enabled;
+	bool					status;		// Timeout pending
+	uint32_t				load;
+	uint64_t				reload;		// Tick of the last reload
+	host_isr_t				isr;
+}host_timer_t;
+
+/**
+ * @brief A one shot interrupt source
+ */
+typedef struct {
+
+	bool					armed;
+	bool					pending;
+	uint64_t				at;			// Tick
+	host_isr_t				isr;
+}host_event_t;
+
+/**
+ * @brief A slave holding an open drain line low.
+ */
+typedef struct {
+
+	uint8_t					pin;
+	uint8_t					clock;
+	uint8_t					pulses;
+	bool					on;
+	uint32_t				pushed;
+	uint32_t				stops;
+}host_hold_t;
+
+/*
+ * Simulated time
+ */
+static uint64_t				ticks 		= 0;
+static uint32_t				spin 		= 0;
+static bool					realtime 	= false;
+static struct timespec		epoch;
+
+/*
+ * Interrupts
+ */
+static host_timer_t			timers[HOST_TIMERS];
+static host_event_t			events[HOST_EVENTS];
+static uint32_t				taken 		= 0;
+static bool					in_isr 		= false;
+static pthread_mutex_t		mask_lock 	= PTHREAD_MUTEX_INITIALIZER;
+static __thread bool		masked 		= false;
+
+/*
+ * Peripherals
+ */
+static uint8_t				pins[HOST_PINS];
+static uint8_t				latch[HOST_PINS];
+static bool					outputs[HOST_PINS];
+static host_hold_t			hold;
+static host_wire_device_t	wire_device = NULL;
+static bool					verbose 	= false;
+static unsigned long		seed 		= 1;
+
+uint32_t					host_failures = 0;
+
+HardwareSerial 				Serial;
+TwoWire 					Wire;
+
+/**
+ * @brief Gets the timer of a base, NULL if none.
+ */
+static host_timer_t* timer_of(unsigned long base){
+
+	if((base < TIMERA0_BASE) || (base > TIMERA3_BASE) || (base & 0xFFF)){
+		return NULL;
+	}
+	return &timers[(base - TIMERA0_BASE) >> 12];
+}
+
+/**
+ * @brief Takes the pending interrupts, unless masked or nested.
+ */
+static void deliver(){
+
+	if(masked || in_isr){
+		return;
+	}
+
+	in_isr = true;
+	for(bool again = true; again;){
+
+		again = false;
+		for(uint8_t i = 0; i < HOST_TIMERS; i++){
+			host_timer_t* timer = &timers[i];
+			if(timer->status && timer->int_enabled && timer->isr){
+
+				/*
+				 * Taken once per timeout, even if the handler does not clear it
+				 */
+				taken++;
+				timer->isr();
+				timer->status 	= false;
+				again 			= true;
+			}
+		}
+		for(uint8_t i = 0; i < HOST_EVENTS; i++){
+			if(events[i].pending){
+				events[i].pending = false;
+				taken++;
+				events[i].isr();
+				again = true;
+			}
+		}
+	}
+	in_isr = false;
+}
+
+/**
+ * @brief Moves the simulated time to a tick, raising what fires.
+ *
+ * @param 	target			The tick to reach
+ * @param 	stop			Return after the first interrupt taken
+ */
+static void run_to(uint64_t target, bool stop){
+
+	uint32_t seen = taken;
+
+	for(;;){
+
+		/*
+		 * The earliest timeout or event up to the target
+		 */
+		uint64_t		next 	= target;
+		host_timer_t*	timer 	= NULL;
+		host_event_t*	event 	= NULL;
+
+		for(uint8_t i = 0; i < HOST_TIMERS; i++){
+			if(timers[i].enabled){
+				uint64_t at = timers[i].reload + (uint64_t)timers[i].load + 1;
+				if(at <= next){
+					next 	= at;
+					timer 	= &timers[i];
+					event 	= NULL;
+				}
+			}
+		}
+		for(uint8_t i = 0; i < HOST_EVENTS; i++){
+			if(events[i].armed && (events[i].at <= next)){
+				next 	= events[i].at;
+				event 	= &events[i];
+				timer 	= NULL;
+			}
+		}
+
+		if(next > ticks){
+			ticks = next;
+		}
+
+		if(timer){
+			timer->reload 	= next;
+			timer->status 	= true;
+		}else if(event){
+			event->armed 	= false;
+			event->pending 	= true;
+		}else{
+			return;
+		}
+
+		deliver();
+		if(stop && (taken != seen)){
+			return;
+		}
+	}
+}
+
+/**
+ * @brief Gets the current tick, a clock read.
+ */
+static uint64_t now_ticks(){
+
+	if(realtime){
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		uint64_t ns = (uint64_t)(now.tv_sec - epoch.tv_sec) * 1000000000ULL +
+				(uint64_t)(now.tv_nsec - epoch.tv_nsec);
+		return ((ns * HOST_TICKS_PER_US) / 1000);
+	}
+
+	if(spin && !in_isr){
+		run_to(ticks + (uint64_t)spin * HOST_TICKS_PER_US, false);
+	}
+	return ticks;
+}
+
+/*
+ * Simulation
+ */
+
+void host_reset(uint64_t us){
+
+	memset(timers, 0, sizeof(timers));
+	memset(events, 0, sizeof(events));
+	memset(pins, HIGH, sizeof(pins));
+	memset(latch, LOW, sizeof(latch));
+	memset(outputs, 0, sizeof(outputs));
+	memset(&hold, 0, sizeof(hold));
+	ticks 		= us * HOST_TICKS_PER_US;
+	spin 		= 0;
+	taken 		= 0;
+	wire_device = NULL;
+}
+
+uint64_t host_time(){
+	return (now_ticks() / HOST_TICKS_PER_US);
+}
+
+void host_advance(uint64_t us){
+	run_to(ticks + us * HOST_TICKS_PER_US, false);
+}
+
+void host_spin(uint32_t us){
+	spin = us;
+}
+
+bool host_event(uint64_t us, host_isr_t isr){
+
+	for(uint8_t i = 0; i < HOST_EVENTS; i++){
+		if(!events[i].armed && !events[i].pending){
+			events[i].at 	= us * HOST_TICKS_PER_US;
+			events[i].isr 	= isr;
+			events[i].armed = true;
+			return true;
+		}
+	}
+	return false;
+}
+
+uint32_t host_interrupts(){
+	return taken;
+}
+
+void host_realtime(bool on){
+
+	realtime = on;
+	clock_gettime(CLOCK_MONOTONIC, &epoch);
+}
+
+void host_wire_attach(host_wire_device_t device){
+	wire_device = device;
+}
+
+void host_verbose(bool on){
+	verbose = on;
+}
+
+int host_report(const char* name){
+
+	printf("%s: %s (%u failed)\n", name, host_failures ? "FAIL" : "PASS", host_failures);
+	return (host_failures ? 1 : 0);
+}
+
+/*
+ * Energia
+ */
+
+uint32_t millis(){
+	return (uint32_t)(now_ticks() / (HOST_TICKS_PER_US * 1000));
+}
+
+uint32_t micros(){
+	return (uint32_t)(now_ticks() / HOST_TICKS_PER_US);
+}
+
+void delay(uint32_t ms){
+	delayMicroseconds(ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us){
+
+	if(realtime){
+		struct timespec wait = {(time_t)(us / 1000000), (long)(us % 1000000) * 1000};
+		nanosleep(&wait, NULL);
+		return;
+	}
+	run_to(ticks + (uint64_t)us * HOST_TICKS_PER_US, false);
+}
+
+void sleep(uint32_t ms){
+
+	/*
+	 * Wakes on the first interrupt, as the MCU does
+	 */
+	if(realtime){
+		delay(ms);
+		return;
+	}
+	run_to(ticks + (uint64_t)ms * 1000 * HOST_TICKS_PER_US, true);
+}
+
+/**
+ * @brief Gets the level of a pin: its latch as an output, its pull
+ * as an input, and a held line reads low.
+ */
+static uint8_t level(uint8_t pin){
+
+	if(hold.on && (pin == hold.pin) && hold.pulses){
+		return LOW;
+	}
+	return (outputs[pin] ? latch[pin] : pins[pin]);
+}
+
+/**
+ * @brief Follows the held lines through a pin change.
+ */
+static void held_change(uint8_t pin, uint8_t before){
+
+	if(!hold.on || ((pin != hold.pin) && (pin != hold.clock))){
+		return;
+	}
+
+	/*
+	 * An open drain line is never driven high
+	 */
+	if(outputs[pin] && (HIGH == latch[pin])){
+		hold.pushed++;
+	}
+
+	/*
+	 * The slave lets go of its line one clock at a time, a rise of
+	 * the line while the clock is high is a STOP
+	 */
+	if((pin == hold.clock) && (LOW == before) && (HIGH == level(pin)) && hold.pulses){
+		hold.pulses--;
+	}
+	if((pin == hold.pin) && (LOW == before) && (HIGH == level(pin)) && (HIGH == level(hold.clock))){
+		hold.stops++;
+	}
+}
+
+void pinMode(uint8_t pin, uint8_t mode){
+
+	if(pin < HOST_PINS){
+		uint8_t before 	= level(pin);
+		outputs[pin] 	= (mode == OUTPUT);
+		if(mode != OUTPUT){
+			pins[pin] = (mode == INPUT_PULLDOWN) ? LOW : HIGH;
+		}
+		held_change(pin, before);
+	}
+}
+
+void digitalWrite(uint8_t pin, uint8_t value){
+
+	if(pin < HOST_PINS){
+		uint8_t before 	= level(pin);
+		latch[pin] 		= value;
+		held_change(pin, before);
+	}
+}
+
+uint8_t digitalRead(uint8_t pin){
+	return ((pin < HOST_PINS) ? level(pin) : LOW);
+}
+
+void host_pin_hold(uint8_t pin, uint8_t clock, uint8_t pulses){
+
+	hold.pin 	= pin;
+	hold.clock 	= clock;
+	hold.pulses = pulses;
+	hold.on 	= true;
+}
+
+uint32_t host_pin_pushed(){
+	return hold.pushed;
+}
+
+uint32_t host_pin_stops(){
+	return hold.stops;
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode){
+}
+
+long random(long max){
+	return (max > 0) ? random(0, max) : 0;
+}
+
+long random(long min, long max){
+
+	if(max <= min){
+		return min;
+	}
+	seed = seed * 1103515245UL + 12345UL;
+	return min + (long)((seed >> 16) % (unsigned long)(max - min));
+}
+
+void randomSeed(unsigned long value){
+	seed = value ? value : 1;
+}
+
+String::String(double value, int decimals){
+
+	char text[64];
+	snprintf(text, sizeof(text), "%.*f", decimals, value);
+	str = text;
+}
+
+std::string String::format(long long value, int base){
+
+	if(value < 0){
+		return "-" + format((unsigned long long)-value, base);
+	}
+	return format((unsigned long long)value, base);
+}
+
+std::string String::format(unsigned long long value, int base){
+
+	char text[64];
+	snprintf(text, sizeof(text), (base == HEX) ? "%llX" : "%llu", value);
+	return text;
+}
+
+void HardwareSerial::print(const String& s){
+
+	if(verbose){
+		fputs(s.c_str(), stdout);
+	}
+}
+
+void HardwareSerial::println(const String& s){
+
+	if(verbose){
+		puts(s.c_str());
+	}
+}
+
+/*
+ * Wire
+ */
+
+void TwoWire::begin(){
+
+	tx_size 	= 0;
+	rx_size 	= 0;
+	rx_pos 		= 0;
+	index 		= 0;
+}
+
+void TwoWire::beginTransmission(uint8_t addr){
+
+	address 	= addr;
+	tx_size 	= 0;
+}
+
+size_t TwoWire::write(uint8_t data){
+
+	if(tx_size >= sizeof(tx)){
+		return 0;
+	}
+	tx[tx_size++] = data;
+	return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t size){
+
+	size_t written = 0;
+	while((written < size) && write(data[written])){
+		written++;
+	}
+	return written;
+}
+
+uint8_t TwoWire::endTransmission(bool stop){
+
+	/*
+	 * The register index, then the bytes
+	 */
+	if(tx_size){
+		index = tx[0];
+	}
+
+	bool ack = wire_device && wire_device(address, index,
+			(tx_size > 1) ? &tx[1] : NULL, (tx_size > 1) ? (tx_size - 1) : 0, false);
+	tx_size = 0;
+
+	return (ack ? 0 : 2);
+}
+
+uint8_t TwoWire::requestFrom(uint8_t addr, uint8_t size){
+
+	if(size > BUFFER_LENGTH){
+		size = BUFFER_LENGTH;
+	}
+
+	rx_pos 	= 0;
+	rx_size = (wire_device && wire_device(addr, index, rx, size, true)) ? size : 0;
+	return rx_size;
+}
+
+size_t TwoWire::readBytes(char* data, size_t size){
+
+	size_t count = 0;
+	while((count < size) && (rx_pos < rx_size)){
+		data[count++] = (char)rx[rx_pos++];
+	}
+	return count;
+}
+
+int TwoWire::available(){
+	return (rx_size - rx_pos);
+}
+
+int TwoWire::read(){
+	return (rx_pos < rx_size) ? rx[rx_pos++] : -1;
+}
+
+int TwoWire::peek(){
+	return (rx_pos < rx_size) ? rx[rx_pos] : -1;
+}
+
+void TwoWire::flush(){
+}
+
+/*
+ * Interrupt controller
+ */
+
+bool IntMasterDisable(){
+
+	if(masked){
+		return true;
+	}
+	pthread_mutex_lock(&mask_lock);
+	masked = true;
+	return false;
+}
+
+bool IntMasterEnable(){
+
+	if(!masked){
+		return false;
+	}
+	masked = false;
+	pthread_mutex_unlock(&mask_lock);
+
+	if(!realtime){
+		deliver();
+	}
+	return true;
+}
+
+void IntPrioritySet(unsigned long interrupt, unsigned char priority){
+}
+
+void IntRegister(unsigned long interrupt, void (*handler)(void)){
+}
+
+void IntUnregister(unsigned long interrupt){
+}
+
+void IntEnable(unsigned long interrupt){
+}
+
+void IntDisable(unsigned long interrupt){
+}
+
+/*
+ * Clocks
+ */
+
+void PRCMPeripheralClkEnable(unsigned long peripheral, unsigned long flags){
+}
+
+void PRCMPeripheralReset(unsigned long peripheral){
+}
+
+unsigned long PRCMPeripheralClockGet(unsigned long peripheral){
+	return F_CPU;
+}
+
+/*
+ * Timers
+ */
+
+void TimerConfigure(unsigned long base, unsigned long config){
+
+	host_timer_t* timer = timer_of(base);
+	if(timer){
+		timer->enabled 	= false;
+		timer->status 	= false;
+		timer->load 	= 0xFFFFFFFF;
+	}
+}
+
+void TimerLoadSet(unsigned long base, unsigned long which, unsigned long value){
+
+	host_timer_t* timer = timer_of(base);
+	if(timer){
+		timer->load = (uint32_t)value;
+	}
+}
+
+unsigned long TimerValueGet(unsigned long base, unsigned long which){
+
+	host_timer_t* timer = timer_of(base);
+	if(!timer){
+		return 0;
+	}
+
+	/*
+	 * Down counter, reloads on the timeout
+	 */
+	uint64_t now = now_ticks();
+	if(!timer->enabled){
+		return timer->load;
+	}
+	return (timer->load - (uint32_t)((now - timer->reload) % ((uint64_t)timer->load + 1)));
+}
+
+void TimerEnable(unsigned long base, unsigned long which){
+
+	host_timer_t* timer = timer_of(base);
+	if(timer){
+		timer->enabled 	= true;
+		timer->reload 	= ticks;
+	}
+}
+
+void TimerDisable(unsigned long base, unsigned long which){
+
+	host_timer_t* timer = timer_of(base);
+	if(timer){
+		timer->enabled = false;
+	}
+}
+
+void TimerIntRegister(unsigned long base, unsigned long which, void (*handler)(void)){
+
+	host_timer_t* timer = timer_of(base);
+	if(timer){
+		timer->isr = handler;
+	}
+}
+
+void TimerIntUnregister(unsigned long base, unsigned long which){
+
+	host_timer_t* timer = timer_of(base);
+	if(timer){
+		timer->isr = NULL;
+	}
+}
+
+void TimerIntEnable(unsigned long base, unsigned long flags){
+
+	host_timer_t* timer = timer_of(base);
+	if(timer){
+		timer->int_enabled = true;
+	}
+}
+
+void TimerIntDisable(unsigned long base, unsigned long flags){
+
+	host_timer_t* timer = timer_of(base);
+	if(timer){
+		timer->int_enabled = false;
+	}
+}
+
+unsigned long TimerIntStatus(unsigned long base, bool masked_only){
+
+	host_timer_t* timer = timer_of(base);
+	return (timer && timer->status) ? TIMER_TIMA_TIMEOUT : 0;
+}
+
+void TimerIntClear(unsigned long base, unsigned long flags){
+
+	host_timer_t* timer = timer_of(base);
+	if(timer){
+		timer->status = false;
+	}
+}
+
+/*
+ * I2C master and watchdog, Wire does the transfers
+ */
+
+void I2CMasterInitExpClk(unsigned long base, unsigned long clock, bool fast){
+}
+
+void WatchdogUnlock(unsigned long base){
+}
+
+void WatchdogLock(unsigned long base){
+}
+
+void WatchdogReloadSet(unsigned long base, unsigned long value){
+}
+
+void WatchdogStallEnable(unsigned long base){
+}
+
+void WatchdogEnable(unsigned long base){
+}
+
+void WatchdogIntClear(unsigned long base){
+}
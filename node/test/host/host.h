@@ -0,0 +1,147 @@
+/*
+ * host.h
+ */
+
+#ifndef TEST_HOST_HOST_H_
+#define TEST_HOST_HOST_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Host simulation of the CC3200 for the tests.
+ *
+ * 	- The time is simulated at the core clock (F_CPU). It only moves
+ * 	  with host_advance(), delay() and sleep(), or on each clock read
+ * 	  with host_spin(), so a test sees exact times.
+ * 	- The general purpose timers count and interrupt on that time,
+ * 	  the interrupt sources are one shot events at a simulated time.
+ * 	- IntMasterDisable() masks the interrupts, pending ones are taken
+ * 	  on IntMasterEnable().
+ * 	- host_realtime() switches to the monotonic host clock for the
+ * 	  threaded tests, the master mask is then a global lock.
+ */
+
+/**
+ * @brief A simulated interrupt handler
+ */
+typedef void (*host_isr_t)();
+
+/**
+ * @brief A simulated I2C device behind Wire.
+ *
+ * A write brings the register index then the bytes, a read fills
+ * the bytes from the index set by the write before. A size of 0
+ * only addresses the device.
+ *
+ * @return	bool			False if the device does not acknowledge
+ */
+typedef bool (*host_wire_device_t)(uint8_t addr, uint8_t index, uint8_t* data, uint8_t size, bool read);
+
+/**
+ * @brief Resets the simulation, the time back to the given us.
+ *
+ * Stops the timers, drops the events and detaches the devices.
+ *
+ * @param 	us				The simulated time
+ */
+void host_reset(uint64_t us);
+
+/**
+ * @brief Gets the simulated (or host) time in us.
+ */
+uint64_t host_time();
+
+/**
+ * @brief Moves the simulated time, the interrupts due run on the way.
+ *
+ * @param 	us				The time to advance
+ */
+void host_advance(uint64_t us);
+
+/**
+ * @brief Advances the time on each clock read, so polling loops end.
+ *
+ * @param 	us				The time per read, 0 to stop
+ */
+void host_spin(uint32_t us);
+
+/**
+ * @brief Raises an interrupt at a simulated time.
+ *
+ * @param 	us				When, absolute
+ * @param 	isr				The handler
+ * @return	bool			False if there is no room
+ */
+bool host_event(uint64_t us, host_isr_t isr);
+
+/**
+ * @brief Gets the number of interrupts taken so far.
+ */
+uint32_t host_interrupts();
+
+/**
+ * @brief Runs on the monotonic host clock instead of the simulated one.
+ *
+ * @param 	on				True for the host clock
+ */
+void host_realtime(bool on);
+
+/**
+ * @brief Attaches the devices behind Wire.
+ *
+ * @param 	device			The handler, NULL for an empty bus
+ */
+void host_wire_attach(host_wire_device_t device);
+
+/**
+ * @brief A slave holds an open drain line low.
+ *
+ * The line reads low until the clock pin rose the given times.
+ * Both pins are watched from then on, see host_pin_pushed() and
+ * host_pin_stops().
+ *
+ * @param 	pin				The held line
+ * @param 	clock			Its clock
+ * @param 	pulses			The clock rises to let go, 0 to release
+ */
+void host_pin_hold(uint8_t pin, uint8_t clock, uint8_t pulses);
+
+/**
+ * @brief Gets the number of times a watched line was driven high.
+ */
+uint32_t host_pin_pushed();
+
+/**
+ * @brief Gets the number of STOPs seen on the watched lines.
+ */
+uint32_t host_pin_stops();
+
+/**
+ * @brief Prints the NOTIFY output.
+ *
+ * @param 	on				True to print, quiet by default
+ */
+void host_verbose(bool on);
+
+/*
+ * Checks, counted and reported by host_report()
+ */
+extern uint32_t host_failures;
+
+#define CHECK(cond)		do{ \
+		if(!(cond)){ \
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			host_failures++; \
+		} \
+	}while(0)
+
+/**
+ * @brief Prints the test result.
+ *
+ * @param 	name			The test name
+ * @return	int				The exit code, 0 when every check passed
+ */
+int host_report(const char* name);
+
+#endif /* TEST_HOST_HOST_H_ */
@@ -0,0 +1,54 @@
+/*
+ * host_configs.h
+ *
+ * Option changes of the host test builds, applied at the end of
+ * configs.h. Each test picks its variant with the HOST_ flags the
+ * Makefile passes.
+ */
+
+#ifndef TEST_HOST_HOST_CONFIGS_H_
+#define TEST_HOST_HOST_CONFIGS_H_
+
+/*
+ * The simulated I2C master (i2c_sim.cpp) in place of the CC3200 one
+ */
+#define I2C_BACKEND_SIM
+
+/*
+ * HOST_LIST_WALK: the linear task walk instead of the deadline heap
+ */
+#ifdef HOST_LIST_WALK
+#undef SCHEDULER_HEAP_MODE
+#endif
+
+/*
+ * HOST_MAX_TASKS: room for the largest benchmark set. The thread ids
+ * are 8 bit and TASK_ID_ALL is taken, 255 tasks at most.
+ */
+#ifdef HOST_MAX_TASKS
+#undef SCHEDULER_MAX_TASKS
+#undef SCHEDULER_MAX_THREAD_ID
+#define SCHEDULER_MAX_TASKS		(256)
+#define SCHEDULER_MAX_THREAD_ID	(255)
+#endif
+
+/*
+ * HOST_PREEMPTIVE: one pthread per task
+ */
+#ifdef HOST_PREEMPTIVE
+#undef SCHEDULER_WATCHDOG
+#undef SCHEDULER_STATIC_TABLE
+#define SCHEDULER_PREEMPTIVE
+#define OS_BACKEND_POSIX
+#endif
+
+/*
+ * HOST_SAMPLER_TIMER: the sampler paced by its hardware timer
+ */
+#ifdef HOST_SAMPLER_TIMER
+#define SENSOR_SAMPLER
+#undef SAMPLER_DATA_READY
+#undef SAMPLER_FIFO
+#endif
+
+#endif /* TEST_HOST_HOST_CONFIGS_H_ */
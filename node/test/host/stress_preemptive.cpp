@@ -0,0 +1,192 @@
+/*
+ * stress_preemptive.cpp
+ *
+ * The preemptive scheduler on pthreads (os_posix.cpp), on the host
+ * clock: tasks of every priority run in their threads while other
+ * threads flood the control mailbox. The same priority tasks never
+ * overlap, no command is lost without being counted and every task
+ * runs again once resumed.
+ */
+
+#include "host.h"
+
+#include <pthread.h>
+#include <task/task.h>
+#include <task/scheduler.h>
+
+/*
+ * Tasks and control threads
+ */
+#define TEST_TASKS			(6)
+#define TEST_POSTERS		(3)
+#define TEST_POSTS			(20000)
+
+/*
+ * Host time of the flood and of the final check
+ */
+#define TEST_SPAN_MS		(2000)
+#define TEST_CHECK_MS		(300)
+
+/*
+ * Busy time of a run
+ */
+#define TEST_RUN_US			(20)
+
+/**
+ * @brief A stressed task
+ */
+typedef struct {
+
+	task_t*					task;
+	uint32_t				interval;	// ms
+	task_priority_t			priority;
+	volatile uint32_t		runs;
+}stressed_t;
+
+static scheduler_t*			sched;
+static stressed_t			stressed[TEST_TASKS];
+
+/*
+ * Runs inside each priority class, and overlaps seen
+ */
+static volatile uint32_t	inside[TASK_PRIORITY_LOW + 1];
+static volatile uint32_t	overlaps 	= 0;
+
+/*
+ * Mailbox accounting
+ */
+static volatile uint32_t	accepted 	= 0;
+static volatile uint32_t	rejected 	= 0;
+static volatile bool		flooding 	= true;
+
+/**
+ * @brief Task callback, checks its class runs alone.
+ *
+ * @param 	context			The stressed task
+ */
+static void stress_run(void* context){
+
+	stressed_t* s = (stressed_t*)context;
+
+	if(__sync_add_and_fetch(&inside[s->priority], 1) != 1){
+		__sync_add_and_fetch(&overlaps, 1);
+	}
+	delayMicroseconds(TEST_RUN_US);
+	__sync_sub_and_fetch(&inside[s->priority], 1);
+
+	s->runs++;
+}
+
+/**
+ * @brief Control thread, suspends and resumes the tasks at random.
+ *
+ * @param 	arg				The seed
+ */
+static void* poster(void* arg){
+
+	unsigned int seed = (unsigned int)(uintptr_t)arg;
+
+	for(uint32_t i = 0; (i < TEST_POSTS) && flooding; i++){
+
+		thread_id_t 	id 		= (thread_id_t)(rand_r(&seed) % TEST_TASKS);
+		task_ctrl_t 	command = (i & 1) ? TASK_CTRL_RESUME : TASK_CTRL_SUSPEND;
+
+		if(sched->post(command, id, 0) == STATUS_OK){
+			__sync_add_and_fetch(&accepted, 1);
+		}else{
+			__sync_add_and_fetch(&rejected, 1);
+		}
+
+		if(!(i % 8)){
+			delayMicroseconds(100);
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Runs the scheduler loop for a while.
+ *
+ * @param 	ms				The host time
+ */
+static void loop(uint32_t ms){
+
+	uint64_t end = host_time() + CLOCK_MS(ms);
+	while(host_time() < end){
+		sched->run();
+		delayMicroseconds(250);
+	}
+}
+
+int main(){
+
+	static const uint32_t 			intervals[TEST_TASKS] 	= {2, 3, 5, 7, 11, 13};
+	static const task_priority_t 	priorities[TEST_TASKS] 	= {
+			TASK_PRIORITY_CRITICAL, TASK_PRIORITY_CRITICAL,
+			TASK_PRIORITY_NORMAL, TASK_PRIORITY_NORMAL,
+			TASK_PRIORITY_LOW, TASK_PRIORITY_LOW
+	};
+
+	/*
+	 * Host clock, the task threads sleep for real
+	 */
+	host_reset(0);
+	host_realtime(true);
+
+	sched = new scheduler_t();
+	for(uint8_t i = 0; i < TEST_TASKS; i++){
+		stressed_t* s 	= &stressed[i];
+		s->interval 	= intervals[i];
+		s->priority 	= priorities[i];
+		s->task 		= new task_t(s->interval, -1, stress_run, s, i);
+		s->task->set_priority(s->priority);
+		CHECK(sched->add_task(s->task) == STATUS_OK);
+		s->task->enable();
+	}
+
+	/*
+	 * Flood the mailbox from several threads while the tasks run
+	 */
+	pthread_t threads[TEST_POSTERS];
+	for(uintptr_t i = 0; i < TEST_POSTERS; i++){
+		CHECK(pthread_create(&threads[i], NULL, poster, (void*)(i + 1)) == 0);
+	}
+
+	loop(TEST_SPAN_MS);
+	flooding = false;
+	for(uint8_t i = 0; i < TEST_POSTERS; i++){
+		pthread_join(threads[i], NULL);
+	}
+	sched->run();
+
+	uint32_t flooded = 0;
+	for(uint8_t i = 0; i < TEST_TASKS; i++){
+		flooded += stressed[i].runs;
+	}
+	printf("%u commands accepted, %u rejected (%u dropped), %u runs, %u overlaps\n",
+			accepted, rejected, sched->get_dropped(), flooded, overlaps);
+	CHECK((accepted + rejected) <= (TEST_POSTERS * TEST_POSTS));
+	CHECK(sched->get_dropped() == rejected);
+	CHECK(overlaps == 0);
+	CHECK(flooded > 0);
+
+	/*
+	 * Everything resumed, every task runs again
+	 */
+	uint32_t before[TEST_TASKS];
+	for(uint8_t i = 0; i < TEST_TASKS; i++){
+		before[i] = stressed[i].runs;
+	}
+
+	CHECK(sched->post(TASK_CTRL_RESUME, TASK_ID_ALL, 0) == STATUS_OK);
+	loop(TEST_CHECK_MS);
+
+	for(uint8_t i = 0; i < TEST_TASKS; i++){
+		uint32_t runs = stressed[i].runs - before[i];
+		printf("task %u: %u ms, %u runs after the resume\n", i, stressed[i].interval, runs);
+		CHECK(runs >= (TEST_CHECK_MS / stressed[i].interval) / 2);
+	}
+	CHECK(overlaps == 0);
+
+	return host_report("stress_preemptive");
+}
@@ -0,0 +1,133 @@
+/*
+ * Energia.h
+ *
+ * Host stand in for the Energia core, the parts the tested modules
+ * use. The time and the pins come from the simulation (host.h).
+ */
+
+#ifndef TEST_HOST_STUBS_ENERGIA_H_
+#define TEST_HOST_STUBS_ENERGIA_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#define F_CPU				(80000000UL)
+
+#define HIGH				(1)
+#define LOW					(0)
+#define INPUT				(0)
+#define OUTPUT				(1)
+#define INPUT_PULLUP		(2)
+#define INPUT_PULLDOWN		(3)
+#define RISING				(3)
+#define FALLING				(2)
+#define CHANGE				(1)
+#define DEC					(10)
+#define HEX					(16)
+
+#define RED_LED				(29)
+#define GREEN_LED			(10)
+#define YELLOW_LED			(9)
+
+/*
+ * Time
+ */
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void sleep(uint32_t ms);
+
+/*
+ * Pins
+ */
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+uint8_t digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+
+/*
+ * Random
+ */
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+/**
+ * @brief Energia String, on top of std::string
+ */
+class String {
+
+	public:
+
+		String(const char* s = "") : str(s ? s : "") {}
+		String(const std::string& s) : str(s) {}
+		String(char c) : str(1, c) {}
+		String(int value, int base = DEC) : str(format((long long)value, base)) {}
+		String(unsigned int value, int base = DEC) : str(format((unsigned long long)value, base)) {}
+		String(long value, int base = DEC) : str(format((long long)value, base)) {}
+		String(unsigned long value, int base = DEC) : str(format((unsigned long long)value, base)) {}
+		String(long long value, int base = DEC) : str(format(value, base)) {}
+		String(unsigned long long value, int base = DEC) : str(format(value, base)) {}
+		String(double value, int decimals = 2);
+
+		String operator+(const String& other) const {
+			return String(str + other.str);
+		}
+
+		String& operator+=(const String& other){
+			str += other.str;
+			return *this;
+		}
+
+		bool operator==(const String& other) const {
+			return (str == other.str);
+		}
+
+		const char* c_str() const {
+			return str.c_str();
+		}
+
+		unsigned int length() const {
+			return (unsigned int)str.length();
+		}
+
+	private:
+
+		std::string str;
+
+		static std::string format(long long value, int base);
+		static std::string format(unsigned long long value, int base);
+};
+
+static inline String operator+(const char* a, const String& b){
+	return String(a) + b;
+}
+
+/**
+ * @brief Serial console, quiet unless host_verbose()
+ */
+class HardwareSerial {
+
+	public:
+
+		void begin(unsigned long baud){}
+		void print(const String& s);
+		void println(const String& s);
+		void println(){
+			println(String());
+		}
+		template <class T> void print(T value, int base){
+			print(String(value, base));
+		}
+		template <class T> void println(T value, int base){
+			println(String(value, base));
+		}
+};
+
+extern HardwareSerial Serial;
+
+#endif /* TEST_HOST_STUBS_ENERGIA_H_ */
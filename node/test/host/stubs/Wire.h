@@ -0,0 +1,47 @@
+/*
+ * Wire.h
+ *
+ * Host stand in for the Energia Wire library. The transfers go to
+ * the device attached with host_wire_attach(), nothing is allocated.
+ */
+
+#ifndef TEST_HOST_STUBS_WIRE_H_
+#define TEST_HOST_STUBS_WIRE_H_
+
+#include <Energia.h>
+
+#define BUFFER_LENGTH		(32)
+
+/**
+ * @brief The I2C master
+ */
+class TwoWire {
+
+	public:
+
+		void begin();
+		void beginTransmission(uint8_t address);
+		size_t write(uint8_t data);
+		size_t write(const uint8_t* data, size_t size);
+		uint8_t endTransmission(bool stop = true);
+		uint8_t requestFrom(uint8_t address, uint8_t size);
+		size_t readBytes(char* data, size_t size);
+		int available();
+		int read();
+		int peek();
+		void flush();
+
+	private:
+
+		uint8_t		address;
+		uint8_t		tx[BUFFER_LENGTH + 1];
+		uint8_t		tx_size;
+		uint8_t		index;
+		uint8_t		rx[BUFFER_LENGTH];
+		uint8_t		rx_size;
+		uint8_t		rx_pos;
+};
+
+extern TwoWire Wire;
+
+#endif /* TEST_HOST_STUBS_WIRE_H_ */
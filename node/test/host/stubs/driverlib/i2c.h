@@ -0,0 +1,12 @@
+/*
+ * i2c.h
+ *
+ * Host stand in, the transfers go through Wire (Wire.h).
+ */
+
+#ifndef TEST_HOST_STUBS_I2C_H_
+#define TEST_HOST_STUBS_I2C_H_
+
+void I2CMasterInitExpClk(unsigned long base, unsigned long clock, bool fast);
+
+#endif /* TEST_HOST_STUBS_I2C_H_ */
@@ -0,0 +1,37 @@
+/*
+ * interrupt.h
+ *
+ * Host stand in, the master mask of the simulation (host.h).
+ */
+
+#ifndef TEST_HOST_STUBS_INTERRUPT_H_
+#define TEST_HOST_STUBS_INTERRUPT_H_
+
+#include <inc/hw_ints.h>
+
+#define INT_PRIORITY_LVL_0		(0x00)
+#define INT_PRIORITY_LVL_1		(0x20)
+#define INT_PRIORITY_LVL_2		(0x40)
+#define INT_PRIORITY_LVL_7		(0xE0)
+
+/**
+ * @brief Masks the interrupts.
+ *
+ * @return	bool			True if they were masked already
+ */
+bool IntMasterDisable();
+
+/**
+ * @brief Unmasks the interrupts, the pending ones are taken.
+ *
+ * @return	bool			True if they were masked
+ */
+bool IntMasterEnable();
+
+void IntPrioritySet(unsigned long interrupt, unsigned char priority);
+void IntRegister(unsigned long interrupt, void (*handler)(void));
+void IntUnregister(unsigned long interrupt);
+void IntEnable(unsigned long interrupt);
+void IntDisable(unsigned long interrupt);
+
+#endif /* TEST_HOST_STUBS_INTERRUPT_H_ */
@@ -0,0 +1,23 @@
+/*
+ * prcm.h
+ *
+ * Host stand in, the peripheral clocks are always on.
+ */
+
+#ifndef TEST_HOST_STUBS_PRCM_H_
+#define TEST_HOST_STUBS_PRCM_H_
+
+#define PRCM_RUN_MODE_CLK		(0x00000001)
+
+#define PRCM_TIMERA0			(0x00000007)
+#define PRCM_TIMERA1			(0x00000008)
+#define PRCM_TIMERA2			(0x00000009)
+#define PRCM_TIMERA3			(0x0000000A)
+#define PRCM_I2CA0				(0x00000015)
+#define PRCM_WDT				(0x00000017)
+
+void PRCMPeripheralClkEnable(unsigned long peripheral, unsigned long flags);
+void PRCMPeripheralReset(unsigned long peripheral);
+unsigned long PRCMPeripheralClockGet(unsigned long peripheral);
+
+#endif /* TEST_HOST_STUBS_PRCM_H_ */
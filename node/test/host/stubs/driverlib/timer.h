@@ -0,0 +1,27 @@
+/*
+ * timer.h
+ *
+ * Host stand in, the general purpose timers count on the simulated
+ * time (host.h). Full width periodic mode only.
+ */
+
+#ifndef TEST_HOST_STUBS_TIMER_H_
+#define TEST_HOST_STUBS_TIMER_H_
+
+#define TIMER_A					(0x000000FF)
+#define TIMER_CFG_PERIODIC		(0x00000022)
+#define TIMER_TIMA_TIMEOUT		(0x00000001)
+
+void TimerConfigure(unsigned long base, unsigned long config);
+void TimerLoadSet(unsigned long base, unsigned long timer, unsigned long value);
+unsigned long TimerValueGet(unsigned long base, unsigned long timer);
+void TimerEnable(unsigned long base, unsigned long timer);
+void TimerDisable(unsigned long base, unsigned long timer);
+void TimerIntRegister(unsigned long base, unsigned long timer, void (*handler)(void));
+void TimerIntUnregister(unsigned long base, unsigned long timer);
+void TimerIntEnable(unsigned long base, unsigned long flags);
+void TimerIntDisable(unsigned long base, unsigned long flags);
+unsigned long TimerIntStatus(unsigned long base, bool masked);
+void TimerIntClear(unsigned long base, unsigned long flags);
+
+#endif /* TEST_HOST_STUBS_TIMER_H_ */
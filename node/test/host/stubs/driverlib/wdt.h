@@ -0,0 +1,17 @@
+/*
+ * wdt.h
+ *
+ * Host stand in, the MCU watchdog never resets the host.
+ */
+
+#ifndef TEST_HOST_STUBS_WDT_H_
+#define TEST_HOST_STUBS_WDT_H_
+
+void WatchdogUnlock(unsigned long base);
+void WatchdogLock(unsigned long base);
+void WatchdogReloadSet(unsigned long base, unsigned long value);
+void WatchdogStallEnable(unsigned long base);
+void WatchdogEnable(unsigned long base);
+void WatchdogIntClear(unsigned long base);
+
+#endif /* TEST_HOST_STUBS_WDT_H_ */
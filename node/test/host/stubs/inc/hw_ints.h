@@ -0,0 +1,16 @@
+/*
+ * hw_ints.h
+ *
+ * Host stand in, the interrupt numbers the tested modules use.
+ */
+
+#ifndef TEST_HOST_STUBS_HW_INTS_H_
+#define TEST_HOST_STUBS_HW_INTS_H_
+
+#define INT_TIMERA0A			(35)
+#define INT_TIMERA1A			(37)
+#define INT_TIMERA2A			(39)
+#define INT_TIMERA3A			(51)
+#define INT_I2CA0				(24)
+
+#endif /* TEST_HOST_STUBS_HW_INTS_H_ */
@@ -0,0 +1,17 @@
+/*
+ * hw_memmap.h
+ *
+ * Host stand in, the peripheral bases the tested modules use.
+ */
+
+#ifndef TEST_HOST_STUBS_HW_MEMMAP_H_
+#define TEST_HOST_STUBS_HW_MEMMAP_H_
+
+#define WDT_BASE				(0x40000000)
+#define I2CA0_BASE				(0x40020000)
+#define TIMERA0_BASE			(0x40030000)
+#define TIMERA1_BASE			(0x40031000)
+#define TIMERA2_BASE			(0x40032000)
+#define TIMERA3_BASE			(0x40033000)
+
+#endif /* TEST_HOST_STUBS_HW_MEMMAP_H_ */
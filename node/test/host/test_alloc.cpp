@@ -0,0 +1,183 @@
+/*
+ * test_alloc.cpp
+ *
+ * The I2C transfers read and write through the caller buffers: no
+ * heap allocation on any bus_i2c path, the failed ones included.
+ * malloc() and friends are counted around the calls.
+ */
+
+#include "host.h"
+
+#include <configs.h>
+#include <platform/bus/i2c/bus_i2c.h>
+
+/*
+ * The simulated devices, one absent
+ */
+#define TEST_ADDR			(0x18)
+#define TEST_ABSENT_ADDR	(0x50)
+
+/*
+ * Calls per path
+ */
+#define TEST_CALLS			(1000)
+
+/*
+ * Allocation count, while armed
+ */
+static volatile bool		counting 	= false;
+static volatile uint32_t	allocations = 0;
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size){
+	if(counting){
+		allocations++;
+	}
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size){
+	if(counting){
+		allocations++;
+	}
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size){
+	if(counting){
+		allocations++;
+	}
+	return __libc_realloc(ptr, size);
+}
+}
+
+/*
+ * The register file of the device
+ */
+static uint8_t				regs[256];
+
+/**
+ * @brief A register file at TEST_ADDR, nobody else acknowledges.
+ */
+static bool device(uint8_t addr, uint8_t index, uint8_t* data, uint8_t size, bool read){
+
+	if(TEST_ADDR != addr){
+		return false;
+	}
+	for(uint8_t i = 0; i < size; i++){
+		if(read){
+			data[i] = regs[(uint8_t)(index + i)];
+		}else{
+			regs[(uint8_t)(index + i)] = data[i];
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Counts the allocations of a path.
+ *
+ * @param 	name			The path
+ * @param 	count			The allocations seen
+ * @return	bool			True if none
+ */
+static bool none(const char* name, uint32_t count){
+
+	printf("%-16s: %u allocations in %u calls\n", name, count, TEST_CALLS);
+	return (0 == count);
+}
+
+#define ARM()				do { allocations = 0; counting = true; } while(0)
+#define DISARM()			(counting = false, allocations)
+
+int main(){
+
+	uint8_t 			data[I2C_BURST_MAX];
+	uint8_t 			back[I2C_BURST_MAX];
+	i2c_bus_packet_t	packet;
+	uint32_t			errors 	= 0;
+
+	host_reset(0);
+	host_wire_attach(device);
+	bus_i2c* bus = new bus_i2c();
+
+	for(uint8_t i = 0; i < sizeof(data); i++){
+		data[i] = 0xA0 + i;
+	}
+
+	/*
+	 * Block transfers
+	 */
+	ARM();
+	for(uint32_t n = 0; n < TEST_CALLS; n++){
+		errors += (sizeof(data) == bus->write_bytes(TEST_ADDR, sizeof(data), 0x10, data)) ? 0 : 1;
+		errors += (sizeof(back) == bus->read_bytes(TEST_ADDR, sizeof(back), 0x10, back)) ? 0 : 1;
+	}
+	CHECK(none("write/read_bytes", DISARM()));
+
+	ARM();
+	for(uint32_t n = 0; n < TEST_CALLS; n++){
+		errors += (sizeof(back) == bus->read_block(TEST_ADDR, 0x10, back, sizeof(back))) ? 0 : 1;
+	}
+	CHECK(none("read_block", DISARM()));
+	CHECK(!memcmp(data, back, sizeof(data)));
+
+	ARM();
+	for(uint32_t n = 0; n < TEST_CALLS; n++){
+		bus->packetize(4, 0x40, data, &packet);
+		errors += (4 == bus->write(TEST_ADDR, &packet)) ? 0 : 1;
+		bus->packetize(4, 0x40, back, &packet);
+		errors += (4 == bus->read(TEST_ADDR, &packet)) ? 0 : 1;
+	}
+	CHECK(none("write/read", DISARM()));
+
+	ARM();
+	for(uint32_t n = 0; n < TEST_CALLS; n++){
+		errors += (sizeof(back) == bus->read_burst(TEST_ADDR, 0x10, back, sizeof(back))) ? 0 : 1;
+	}
+	CHECK(none("read_burst", DISARM()));
+
+	/*
+	 * Single registers
+	 */
+	ARM();
+	for(uint32_t n = 0; n < TEST_CALLS; n++){
+		bus->put(TEST_ADDR, 0x01, (uint8_t)n);
+		errors += (bus->get(TEST_ADDR, 0x01) == (uint8_t)n) ? 0 : 1;
+		bus->reg_fieldset(TEST_ADDR, 0x30, 0x02, 0x02);
+		errors += (bus->reg_fieldget(TEST_ADDR, 0x02, 0x30) == 0x02) ? 0 : 1;
+	}
+	CHECK(none("get/put/fields", DISARM()));
+	CHECK(errors == 0);
+
+	/*
+	 * Not acknowledged: retries and bus clears, still nothing allocated
+	 */
+	i2c_bus_stats_t stats;
+	ARM();
+	for(uint32_t n = 0; n < TEST_CALLS; n++){
+		errors += bus->read_block(TEST_ABSENT_ADDR, 0x10, back, sizeof(back)) ? 1 : 0;
+		errors += bus->write_bytes(TEST_ABSENT_ADDR, sizeof(data), 0x10, data) ? 1 : 0;
+	}
+	CHECK(none("failed transfers", DISARM()));
+	CHECK(errors == 0);
+
+	bus->get_stats(&stats);
+	CHECK(stats.failures == (2 * TEST_CALLS));
+	CHECK(stats.retries == (2 * TEST_CALLS * I2C_RETRIES));
+
+	/*
+	 * The counter works
+	 */
+	ARM();
+	void* volatile block = malloc(16);
+	CHECK(DISARM() == 1);
+	free(block);
+
+	return host_report("test_alloc");
+}
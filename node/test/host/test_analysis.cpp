@@ -0,0 +1,89 @@
+/*
+ * test_analysis.cpp
+ *
+ * The schedulability analysis of the preemptive scheduler: the set
+ * goes by priority class, a slow critical task preempts a fast low
+ * one, which misses its period and is re-planned, and a set that
+ * just fits is left alone.
+ */
+
+#include "host.h"
+
+#include <task/task.h>
+#include <task/scheduler.h>
+
+static void idle_run(){
+}
+
+/**
+ * @brief Adds an enabled task with a known worst case.
+ *
+ * @param 	sched			The scheduler
+ * @param 	id				The thread id
+ * @param 	ms				The period
+ * @param 	wcet_us			The worst case
+ * @param 	priority		The class
+ * @return	task			The task
+ */
+static task_t* periodic(scheduler_t* sched, thread_id_t id, uint32_t ms, uint32_t wcet_us,
+		task_priority_t priority){
+
+	task_t* task = new task_t(ms, -1, idle_run, id);
+	task->set_wcet(wcet_us);
+	task->set_priority(priority);
+	CHECK(sched->add_task(task) == STATUS_OK);
+	task->enable();
+	return task;
+}
+
+int main(){
+
+	/*
+	 * Host clock, the task threads sleep for real
+	 */
+	host_reset(0);
+	host_realtime(true);
+	scheduler_t* sched = new scheduler_t();
+
+	/*
+	 * The fast low task is preempted for 8 ms by the critical one:
+	 * R = 3 + ceil(11 / 100) * 8 = 11 ms over its 10 ms period. The
+	 * re-plan doubles it, then R = 11 ms fits 20 ms.
+	 */
+	task_t* slow 	= periodic(sched, 0, 100, 8000, TASK_PRIORITY_CRITICAL);
+	task_t* fast 	= periodic(sched, 1, 10, 3000, TASK_PRIORITY_LOW);
+
+	CHECK(sched->analyze() == STATUS_OK);
+	printf("preempted low task re-planned to %u ms\n", fast->get_interval());
+	CHECK(fast->get_interval() == 20);
+	CHECK(slow->get_interval() == 100);
+
+	slow->disable();
+	fast->disable();
+
+	/*
+	 * Just fits: the fast normal task is blocked 2 ms by its slower
+	 * class mate and preempted 2 ms by the critical one,
+	 * R = 1 + 2 + ceil(5 / 10) * 2 = 5 ms on its 5 ms period. The
+	 * slowest, R = 2 + ceil(5 / 10) * 2 + ceil(5 / 5) * 1 = 5 ms.
+	 */
+	task_t* critical 	= periodic(sched, 2, 10, 2000, TASK_PRIORITY_CRITICAL);
+	task_t* normal 		= periodic(sched, 3, 5, 1000, TASK_PRIORITY_NORMAL);
+	task_t* mate 		= periodic(sched, 4, 20, 2000, TASK_PRIORITY_NORMAL);
+
+	CHECK(sched->analyze() == STATUS_OK);
+	CHECK(critical->get_interval() == 10);
+	CHECK(normal->get_interval() == 5);
+	CHECK(mate->get_interval() == 20);
+
+	/*
+	 * One more microsecond of blocking and the normal task misses,
+	 * re-planned as well
+	 */
+	mate->set_wcet(2001);
+	CHECK(sched->analyze() == STATUS_OK);
+	printf("blocked normal task re-planned to %u ms\n", normal->get_interval());
+	CHECK(normal->get_interval() == 10);
+
+	return host_report("test_analysis");
+}
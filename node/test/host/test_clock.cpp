@@ -0,0 +1,142 @@
+/*
+ * test_clock.cpp
+ *
+ * The 64 bit clock over years of simulated uptime: it follows the
+ * time across every 32 bit timer overflow and micros() wrap, also
+ * read with the overflow interrupt pending, and a task keeps its
+ * period across a micros() wrap.
+ */
+
+#include "host.h"
+
+#include <task/task.h>
+#include <task/scheduler.h>
+#include <platform/clock/clock.h>
+#include <inc/hw_memmap.h>
+#include <driverlib/interrupt.h>
+#include <driverlib/timer.h>
+
+/*
+ * Simulated uptime
+ */
+#define TEST_YEARS			(3)
+#define TEST_YEAR_US		(365ULL * 24 * 3600 * 1000000)
+
+/*
+ * Longest step between two reads
+ */
+#define TEST_STEP_US		(60000000)
+
+/*
+ * The task run across a micros() wrap
+ */
+#define TEST_TASK_MS		(1000)
+#define TEST_LATE_US		(50)
+
+static uint32_t				runs 		= 0;
+static uint32_t				off_grid 	= 0;
+static clock_us_t			first 		= 0;
+
+static void tick(){
+
+	clock_us_t deadline = first + CLOCK_MS(TEST_TASK_MS) * runs;
+	clock_us_t now 		= sys_clock::now();
+
+	if(clock_before(now, deadline) || ((now - deadline) > TEST_LATE_US)){
+		off_grid++;
+	}
+	runs++;
+}
+
+/**
+ * @brief Checks the clock against the simulated time.
+ *
+ * @param 	previous		The last read, updated
+ * @return	bool			False on a mismatch
+ */
+static bool follows(clock_us_t* previous){
+
+	clock_us_t now = sys_clock::now();
+	bool ok = (now == host_time()) && !clock_before(now, *previous);
+	*previous = now;
+	return ok;
+}
+
+int main(){
+
+	/*
+	 * Boot 5 s before the micros() wrap, the clock continues from it
+	 */
+	host_reset(0xFFFFFFFFULL - 5000000);
+	CHECK(sys_clock::now() == micros());
+	sys_clock::start();
+
+	clock_us_t	previous 	= sys_clock::now();
+	uint32_t	mismatches 	= 0;
+	uint32_t	reads 		= 0;
+	uint64_t	end 		= host_time() + TEST_YEARS * TEST_YEAR_US;
+
+	randomSeed(9);
+	while(host_time() < end){
+
+		host_advance(random(1, TEST_STEP_US));
+		mismatches += follows(&previous) ? 0 : 1;
+		reads++;
+
+		/*
+		 * Now and then, read across an overflow with the interrupts masked
+		 */
+		if(!(reads % 1024)){
+			uint64_t to_overflow = TimerValueGet(CLOCK_TIMER_BASE, TIMER_A) / CLOCK_TICKS_PER_US;
+			bool masked = IntMasterDisable();
+			host_advance(to_overflow + random(1, 1000));
+			mismatches += follows(&previous) ? 0 : 1;
+			if(!masked){
+				IntMasterEnable();
+			}
+			mismatches += follows(&previous) ? 0 : 1;
+		}
+	}
+
+	printf("%u reads over %u years, %u mismatches, micros() wrapped %llu times\n",
+			reads, TEST_YEARS, mismatches, (unsigned long long)(host_time() >> 32));
+	CHECK(mismatches == 0);
+	CHECK(sys_clock::now() > (1ULL << 32) * 1000);
+
+	/*
+	 * Deadlines compare across the 32 bit boundary of the old clock
+	 */
+	CHECK(clock_before(0xFFFFFFF0ULL, 0x100000010ULL));
+	CHECK(clock_reached(0xFFFFFFF0ULL, 0x100000010ULL));
+	CHECK(!clock_reached(0x100000010ULL, 0xFFFFFFF0ULL));
+
+	/*
+	 * A 1 s task for two hours, over the next micros() wrap
+	 */
+	scheduler_t	sched;
+	task_t		task(TEST_TASK_MS, -1, tick, 0);
+
+	host_spin(1);
+	sched.add_task(&task);
+	task.enable();
+	first = task.next_run();
+
+	uint32_t	wraps 	= 0;
+	uint32_t	last 	= micros();
+	clock_us_t	stop 	= sys_clock::now() + CLOCK_MS(2 * 3600 * 1000);
+	while(clock_before(sys_clock::now(), stop)){
+		sched.run();
+		sched.idle();
+		if(micros() < last){
+			wraps++;
+		}
+		last = micros();
+	}
+
+	printf("%u task runs, %u off the grid, %u micros() wraps\n", runs, off_grid, wraps);
+	CHECK(wraps >= 1);
+	CHECK(runs >= (2 * 3600));
+	CHECK(off_grid == 0);
+
+	return host_report("test_clock");
+}
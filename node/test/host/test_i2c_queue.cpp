@@ -0,0 +1,287 @@
+/*
+ * test_i2c_queue.cpp
+ *
+ * The I2C transaction queue on the simulated bus (i2c_sim.cpp): the
+ * transactions run in order with their callbacks, a glitch is issued
+ * again, a full queue rejects while a task holds the bus and a stalled
+ * bus is failed after I2C_TIMEOUT_MS.
+ */
+
+#include "host.h"
+
+#include <configs.h>
+#include <platform/bus/i2c/bus_i2c.h>
+#include <platform/bus/i2c/i2c_queue.h>
+#include <platform/clock/clock.h>
+
+/*
+ * The simulated devices
+ */
+#define TEST_ADDR			(0x18)
+#define TEST_FLAKY_ADDR		(0x30)
+#define TEST_SLOW_ADDR		(0x40)
+
+/*
+ * Transfer time of the slow device
+ */
+#define TEST_HOLD_US		(2000)
+
+/*
+ * Allowed overshoot of the stall timeout, the polling passes
+ */
+#define TEST_LATE_US		(100)
+
+/*
+ * The register file, shared by the queue and Wire
+ */
+static uint8_t				regs[256];
+
+/*
+ * Glitches left on the flaky device
+ */
+static uint8_t				glitches 	= 0;
+
+/*
+ * Completion order
+ */
+static uint8_t				order[I2C_QUEUE_SIZE + 4];
+static uint8_t				ends 		= 0;
+
+/*
+ * Transactions submitted from the slow device, as an interrupt would
+ */
+static i2c_transaction_t	flood[I2C_QUEUE_SIZE + 4];
+static uint8_t				flood_data[I2C_QUEUE_SIZE + 4];
+static uint8_t				accepted 	= 0;
+static uint8_t				rejected 	= 0;
+
+/**
+ * @brief Moves the span of a register file transaction.
+ */
+static void move(uint8_t index, uint8_t* data, uint8_t size, bool read){
+
+	for(uint8_t i = 0; i < size; i++){
+		if(read){
+			data[i] = regs[(uint8_t)(index + i)];
+		}else{
+			regs[(uint8_t)(index + i)] = data[i];
+		}
+	}
+}
+
+/**
+ * @brief The queue side of the bus.
+ */
+static bool sim_device(i2c_transaction_t* txn){
+
+	if(TEST_FLAKY_ADDR == txn->addr){
+		if(glitches){
+			glitches--;
+			return false;
+		}
+		return true;
+	}
+	if(TEST_ADDR != txn->addr){
+		return false;
+	}
+	move(txn->index, txn->data, txn->size, I2C_TXN_READ == txn->dir);
+	return true;
+}
+
+static void done(i2c_transaction_t* txn){
+	order[ends++] = (uint8_t)(uintptr_t)txn->context;
+}
+
+/**
+ * @brief Fills the queue while the task transaction holds the bus.
+ */
+static void submit_flood(){
+
+	for(uint8_t i = 0; i < (I2C_QUEUE_SIZE + 4); i++){
+		i2c_transaction_t* txn 	= &flood[i];
+		flood_data[i] 			= 0x80 + i;
+		txn->addr 				= TEST_ADDR;
+		txn->index 				= 0x40 + i;
+		txn->data 				= &flood_data[i];
+		txn->size 				= 1;
+		txn->dir 				= I2C_TXN_WRITE;
+		txn->done 				= done;
+		txn->context 			= (void*)(uintptr_t)i;
+		if(i2c_queue::submit(txn) == STATUS_OK){
+			accepted++;
+		}else{
+			rejected++;
+		}
+	}
+}
+
+/**
+ * @brief The Wire side of the bus, the slow device floods the queue.
+ */
+static bool wire_device(uint8_t addr, uint8_t index, uint8_t* data, uint8_t size, bool read){
+
+	if(TEST_SLOW_ADDR == addr){
+		if(read){
+			submit_flood();
+			host_advance(TEST_HOLD_US);
+			memset(data, 0, size);
+		}
+		return true;
+	}
+	if(TEST_ADDR != addr){
+		return false;
+	}
+	move(index, data, size, read);
+	return true;
+}
+
+/**
+ * @brief Fills a transaction.
+ */
+static void make(i2c_transaction_t* txn, uint8_t addr, uint8_t index, uint8_t* data, uint8_t size,
+		i2c_txn_dir_t dir, uint8_t tag){
+
+	txn->addr 		= addr;
+	txn->index 		= index;
+	txn->data 		= data;
+	txn->size 		= size;
+	txn->dir 		= dir;
+	txn->done 		= done;
+	txn->context 	= (void*)(uintptr_t)tag;
+	txn->state 		= I2C_TXN_IDLE;
+}
+
+/**
+ * @brief Ends a stall from the completion of the aborted transaction.
+ */
+static void unstall(i2c_transaction_t* txn){
+	i2c_sim_stall(false);
+	done(txn);
+}
+
+int main(){
+
+	i2c_transaction_t 	txns[8];
+	uint8_t				data[8][4];
+	uint8_t				back[4];
+	i2c_queue_stats_t	stats;
+	i2c_bus_stats_t		bus_stats;
+
+	host_reset(0);
+	host_spin(1);
+	host_wire_attach(wire_device);
+	i2c_sim_attach(sim_device);
+	bus_i2c* bus = new bus_i2c();
+
+	/*
+	 * In order, each with its callback
+	 */
+	for(uint8_t i = 0; i < 8; i++){
+		for(uint8_t j = 0; j < 4; j++){
+			data[i][j] = (uint8_t)(i * 16 + j);
+		}
+		make(&txns[i], TEST_ADDR, i * 4, data[i], 4, I2C_TXN_WRITE, i);
+		CHECK(i2c_queue::submit(&txns[i]) == STATUS_OK);
+	}
+	for(uint8_t i = 0; i < 8; i++){
+		CHECK(i2c_queue::ended(&txns[i]));
+		CHECK(txns[i].state == I2C_TXN_DONE);
+		CHECK(order[i] == i);
+		CHECK(!memcmp(&regs[i * 4], data[i], 4));
+	}
+	CHECK(ends == 8);
+	CHECK(!bus_i2c_t::is_busy());
+
+	make(&txns[0], TEST_ADDR, 8, back, 4, I2C_TXN_READ, 0);
+	CHECK(i2c_queue::submit(&txns[0]) == STATUS_OK);
+	CHECK(i2c_queue::wait(&txns[0]));
+	CHECK(!memcmp(back, data[2], 4));
+
+	/*
+	 * A glitch is issued again, too many fail it
+	 */
+	ends 		= 0;
+	glitches 	= I2C_RETRIES;
+	make(&txns[0], TEST_FLAKY_ADDR, 0, NULL, 0, I2C_TXN_WRITE, 0);
+	CHECK(i2c_queue::submit(&txns[0]) == STATUS_OK);
+	CHECK(txns[0].state == I2C_TXN_DONE);
+
+	glitches 	= I2C_RETRIES + 1;
+	make(&txns[1], TEST_FLAKY_ADDR, 0, NULL, 0, I2C_TXN_WRITE, 1);
+	CHECK(i2c_queue::submit(&txns[1]) == STATUS_OK);
+	CHECK(txns[1].state == I2C_TXN_FAILED);
+	CHECK(ends == 2);
+
+	i2c_queue::get_stats(&stats);
+	printf("%u completed, %u failed, %u retried\n", stats.completed, stats.failed, stats.retried);
+	CHECK(stats.failed == 1);
+	CHECK(stats.retried == (2 * I2C_RETRIES));
+	CHECK(!bus_i2c_t::is_busy());
+
+	/*
+	 * A task holds the bus, the queue fills and rejects, then runs
+	 * everything in order on the release
+	 */
+	ends = 0;
+	CHECK(bus->read_block(TEST_SLOW_ADDR, 0, back, 2) == 2);
+
+	i2c_queue::get_stats(&stats);
+	printf("%u accepted, %u rejected while held, %u run after the release\n",
+			accepted, rejected, ends);
+	CHECK(accepted == I2C_QUEUE_SIZE);
+	CHECK(rejected == 4);
+	CHECK(stats.rejected == 4);
+	CHECK(stats.high_water == I2C_QUEUE_SIZE);
+	CHECK(ends == I2C_QUEUE_SIZE);
+	for(uint8_t i = 0; i < I2C_QUEUE_SIZE; i++){
+		CHECK(order[i] == i);
+		CHECK(flood[i].state == I2C_TXN_DONE);
+		CHECK(regs[0x40 + i] == (0x80 + i));
+	}
+	CHECK(!bus_i2c_t::is_busy());
+
+	/*
+	 * A stalled transaction fails after I2C_TIMEOUT_MS, the task call
+	 * then clears the bus and goes on, and the queue with it
+	 */
+	ends = 0;
+	i2c_sim_stall(true);
+	make(&txns[0], TEST_ADDR, 0, data[0], 4, I2C_TXN_WRITE, 0);
+	make(&txns[1], TEST_ADDR, 4, data[1], 4, I2C_TXN_WRITE, 1);
+	txns[0].done = unstall;
+	CHECK(i2c_queue::submit(&txns[0]) == STATUS_OK);
+	CHECK(i2c_queue::submit(&txns[1]) == STATUS_OK);
+	CHECK(txns[0].state == I2C_TXN_ACTIVE);
+	CHECK(txns[1].state == I2C_TXN_QUEUED);
+
+	uint64_t start = host_time();
+	CHECK(bus->read_block(TEST_ADDR, 8, back, 4) == 4);
+	uint64_t waited = host_time() - start;
+
+	bus->get_stats(&bus_stats);
+	printf("stalled bus failed after %llu us, %u timeouts\n", (unsigned long long)waited,
+			bus_stats.timeouts);
+	CHECK(waited >= CLOCK_MS(I2C_TIMEOUT_MS));
+	CHECK(waited <= CLOCK_MS(I2C_TIMEOUT_MS) + TEST_LATE_US);
+	CHECK(bus_stats.timeouts == 1);
+	CHECK(txns[0].state == I2C_TXN_FAILED);
+	CHECK(txns[1].state == I2C_TXN_DONE);
+	CHECK(ends == 2);
+	CHECK(!bus_i2c_t::is_busy());
+
+	/*
+	 * A wait on a stalled transaction ends the same way
+	 */
+	i2c_sim_stall(true);
+	make(&txns[2], TEST_ADDR, 0, back, 4, I2C_TXN_READ, 2);
+	CHECK(i2c_queue::submit(&txns[2]) == STATUS_OK);
+	CHECK(!i2c_queue::wait(&txns[2]));
+	CHECK(txns[2].state == I2C_TXN_FAILED);
+	i2c_sim_stall(false);
+
+	bus->get_stats(&bus_stats);
+	CHECK(bus_stats.timeouts == 2);
+	CHECK(!bus_i2c_t::is_busy());
+
+	return host_report("test_i2c_queue");
+}
@@ -0,0 +1,73 @@
+/*
+ * test_i2c_recover.cpp
+ *
+ * The bus clear on the simulated pins: a slave holding SDA low is
+ * clocked out, the lines are only ever pulled low or let go, and the
+ * STOP is sent once SDA is free, never over a slave still holding it.
+ */
+
+#include "host.h"
+
+#include <configs.h>
+#include <platform/bus/i2c/bus_i2c.h>
+
+/*
+ * Nobody acknowledges at this address, each transfer clears the bus
+ */
+#define TEST_ABSENT_ADDR	(0x50)
+
+/*
+ * Clock pulses a slave needs to let go
+ */
+#define TEST_PULSES			(3)
+
+/*
+ * A slave that never lets go
+ */
+#define TEST_STUCK			(255)
+
+static bool device(uint8_t addr, uint8_t index, uint8_t* data, uint8_t size, bool read){
+	return false;
+}
+
+int main(){
+
+	uint8_t 			back[4];
+	i2c_bus_stats_t		stats;
+
+	host_reset(0);
+	host_spin(1);
+	host_wire_attach(device);
+	bus_i2c* bus = new bus_i2c();
+
+	/*
+	 * Let go after a few pulses, then a STOP on every clear
+	 */
+	host_pin_hold(I2C_SDA_PIN, I2C_SCL_PIN, TEST_PULSES);
+	CHECK(bus->read_block(TEST_ABSENT_ADDR, 0, back, sizeof(back)) == 0);
+
+	bus->get_stats(&stats);
+	printf("released: %u clears, %u stops, %u stuck, driven high %u times\n",
+			stats.recoveries, host_pin_stops(), stats.stuck, host_pin_pushed());
+	CHECK(stats.recoveries == I2C_RETRIES);
+	CHECK(host_pin_stops() == I2C_RETRIES);
+	CHECK(stats.stuck == 0);
+	CHECK(host_pin_pushed() == 0);
+
+	/*
+	 * Never lets go, no STOP
+	 */
+	host_pin_hold(I2C_SDA_PIN, I2C_SCL_PIN, TEST_STUCK);
+	uint32_t stops = host_pin_stops();
+	CHECK(bus->read_block(TEST_ABSENT_ADDR, 0, back, sizeof(back)) == 0);
+
+	bus->get_stats(&stats);
+	printf("stuck: %u clears, %u stops, %u stuck, driven high %u times\n",
+			stats.recoveries, host_pin_stops() - stops, stats.stuck, host_pin_pushed());
+	CHECK(stats.recoveries == 2 * I2C_RETRIES);
+	CHECK(host_pin_stops() == stops);
+	CHECK(stats.stuck == I2C_RETRIES);
+	CHECK(host_pin_pushed() == 0);
+
+	return host_report("test_i2c_recover");
+}
@@ -0,0 +1,121 @@
+/*
+ * test_irq.cpp
+ *
+ * The sensor interrupt split on the simulated clock: the top half
+ * stamps the first pending capture and counts, the bottom half gets
+ * the stamp and the count, a capture during the bottom half is
+ * stamped at its release and one after the release keeps its own.
+ */
+
+#include "host.h"
+
+#include <platform/sensor/sensor/sensor.h>
+
+/*
+ * Bottom half duration, and a capture inside it
+ */
+#define TEST_WORK_US		(1000)
+#define TEST_DURING_US		(300)
+
+/**
+ * @brief A sensor recording its bottom half runs.
+ */
+class irq_sensor: public sensor {
+
+	public:
+
+		irq_sensor() : sensor(){
+			work_us 	= 0;
+			runs 		= 0;
+			stamp 		= 0;
+			count 		= 0;
+		}
+
+		uint32_t				work_us;
+		uint32_t				runs;
+		clock_us_t				stamp;
+		uint16_t				count;
+
+	protected:
+
+		void irq_work(clock_us_t timestamp, uint16_t pending){
+			runs++;
+			stamp 	= timestamp;
+			count 	= pending;
+			host_advance(work_us);
+		}
+};
+
+static irq_sensor*			acc;
+
+static void capture(){
+	acc->irq_capture();
+}
+
+int main(){
+
+	host_reset(0);
+	sys_clock::start();
+	acc = new irq_sensor();
+
+	/*
+	 * Nothing pending
+	 */
+	CHECK(!acc->irq_service());
+
+	/*
+	 * One capture, served later with its own stamp
+	 */
+	clock_us_t at = sys_clock::now() + 100;
+	CHECK(host_event(at, capture));
+	host_advance(500);
+	CHECK(acc->irq_service());
+	CHECK(acc->runs == 1);
+	CHECK(acc->stamp == at);
+	CHECK(acc->count == 1);
+
+	/*
+	 * Two captures, coalesced on the stamp of the first
+	 */
+	at = sys_clock::now() + 100;
+	CHECK(host_event(at, capture));
+	CHECK(host_event(at + 200, capture));
+	host_advance(500);
+	CHECK(acc->irq_service());
+	CHECK(acc->stamp == at);
+	CHECK(acc->count == 2);
+	CHECK(acc->get_irq_coalesced() == 1);
+
+	/*
+	 * A capture during the work is stamped at the release
+	 */
+	acc->work_us = TEST_WORK_US;
+	clock_us_t start = sys_clock::now();
+	CHECK(host_event(start + TEST_DURING_US - 100, capture));
+	CHECK(host_event(start + TEST_DURING_US, capture));
+	host_advance(TEST_DURING_US - 50);
+	CHECK(acc->irq_service());
+	clock_us_t released = sys_clock::now();
+	acc->work_us = 0;
+
+	host_advance(500);
+	CHECK(acc->irq_service());
+	printf("capture during the work at %llu us, stamped %llu us (release %llu us)\n",
+			(unsigned long long)(start + TEST_DURING_US), (unsigned long long)acc->stamp,
+			(unsigned long long)released);
+	CHECK(acc->stamp == released);
+	CHECK(acc->count == 1);
+
+	/*
+	 * One after the release keeps its own
+	 */
+	at = sys_clock::now() + 100;
+	CHECK(host_event(at, capture));
+	host_advance(500);
+	CHECK(acc->irq_service());
+	CHECK(acc->stamp == at);
+	CHECK(acc->count == 1);
+	CHECK(!acc->irq_service());
+
+	return host_report("test_irq");
+}
@@ -0,0 +1,127 @@
+/*
+ * test_mailbox.cpp
+ *
+ * The task control mailbox on the simulated clock: each command
+ * applies on the next pass, a restart brings a finished task back
+ * with its full count and a full mailbox drops and counts.
+ */
+
+#include "host.h"
+
+#include <task/task.h>
+#include <task/scheduler.h>
+
+/*
+ * Task interval and iterations
+ */
+#define TEST_INTERVAL_MS	(10)
+#define TEST_ITERATIONS		(5)
+
+static scheduler_t*			sched;
+static uint32_t				runs[2];
+
+static void run_a(){
+	runs[0]++;
+}
+
+static void run_b(){
+	runs[1]++;
+}
+
+/**
+ * @brief Runs the loop for a while.
+ *
+ * @param 	ms				The simulated time
+ */
+static void loop(uint32_t ms){
+
+	clock_us_t end = sys_clock::now() + CLOCK_MS(ms);
+	while(clock_before(sys_clock::now(), end)){
+		sched->run();
+		sched->idle();
+	}
+}
+
+int main(){
+
+	host_reset(0);
+	host_spin(1);
+	sys_clock::start();
+
+	sched = new scheduler_t();
+	task_t* a = new task_t(TEST_INTERVAL_MS, TEST_ITERATIONS, run_a, 0);
+	task_t* b = new task_t(TEST_INTERVAL_MS, -1, run_b, 1);
+	sched->add_task(a);
+	sched->add_task(b);
+	a->enable();
+	b->enable();
+
+	/*
+	 * The finite task runs out
+	 */
+	loop(200);
+	CHECK(runs[0] == TEST_ITERATIONS);
+	CHECK(runs[1] >= 19);
+
+	/*
+	 * A restart brings it back with its full count, twice
+	 */
+	for(uint8_t i = 1; i <= 2; i++){
+		CHECK(sched->post(TASK_CTRL_RESTART, 0, 0) == STATUS_OK);
+		loop(200);
+		printf("restart %u: %u runs\n", i, runs[0]);
+		CHECK(runs[0] == (1 + i) * TEST_ITERATIONS);
+		CHECK(a->is_enabled());
+	}
+
+	/*
+	 * New count, then a restart keeps it
+	 */
+	CHECK(sched->post(TASK_CTRL_SET_ITERATIONS, 0, 2) == STATUS_OK);
+	loop(200);
+	CHECK(runs[0] == 3 * TEST_ITERATIONS + 2);
+	CHECK(sched->post(TASK_CTRL_RESTART, 0, 0) == STATUS_OK);
+	loop(200);
+	CHECK(runs[0] == 3 * TEST_ITERATIONS + 4);
+
+	/*
+	 * Suspend, resume, on every task
+	 */
+	CHECK(sched->post(TASK_CTRL_SUSPEND, TASK_ID_ALL, 0) == STATUS_OK);
+	sched->run();
+	uint32_t held = runs[1];
+	loop(100);
+	CHECK(runs[1] == held);
+	CHECK(!b->is_enabled());
+
+	CHECK(sched->post(TASK_CTRL_RESUME, 1, 0) == STATUS_OK);
+	loop(100);
+	CHECK(runs[1] >= held + 9);
+
+	/*
+	 * New interval
+	 */
+	CHECK(sched->post(TASK_CTRL_SET_INTERVAL, 1, 50) == STATUS_OK);
+	held = runs[1];
+	loop(500);
+	printf("50 ms interval: %u runs in 500 ms\n", runs[1] - held);
+	CHECK((runs[1] - held) >= 9);
+	CHECK((runs[1] - held) <= 11);
+
+	/*
+	 * A full mailbox drops the newest and counts them
+	 */
+	uint8_t rejected = 0;
+	for(uint8_t i = 0; i < (SCHEDULER_MAILBOX_SIZE + 3); i++){
+		if(sched->post(TASK_CTRL_RESTART, 0, 0) != STATUS_OK){
+			rejected++;
+		}
+	}
+	printf("%u rejected, %u dropped\n", rejected, sched->get_dropped());
+	CHECK(rejected == 3);
+	CHECK(sched->get_dropped() == 3);
+	sched->run();
+	CHECK(sched->post(TASK_CTRL_RESTART, 0, 0) == STATUS_OK);
+
+	return host_report("test_mailbox");
+}
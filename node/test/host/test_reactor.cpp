@@ -0,0 +1,189 @@
+/*
+ * test_reactor.cpp
+ *
+ * The event reactor on simulated interrupt sources: an event raised
+ * during the idle sleep is handled at once, a socket poller is seen
+ * within REACTOR_POLL_MS and a full queue drops events, in order.
+ */
+
+#include "host.h"
+
+#include <task/task.h>
+#include <task/scheduler.h>
+#include <task/reactor.h>
+
+/*
+ * Simulated interrupt sources
+ */
+#define TEST_EVENTS			(40)
+#define TEST_SPAN_MS		(4000)
+
+/*
+ * Allowed latency, the loop passes between the interrupt and the handler
+ */
+#define TEST_LATE_US		(50)
+
+/*
+ * Simulated time of a clock read
+ */
+#define TEST_READ_US		(1)
+
+static scheduler_t*			sched;
+
+/*
+ * Interrupt events
+ */
+static clock_us_t			raised[TEST_EVENTS];
+static uint8_t				fired 		= 0;
+static uint8_t				handled 	= 0;
+static uint8_t				out_of_order = 0;
+static uint32_t				late_max 	= 0;
+
+/*
+ * Socket poller
+ */
+static clock_us_t			readable_at = 0;
+static clock_us_t			read_at 	= 0;
+
+/*
+ * Queue overflow
+ */
+static uint8_t				sources[REACTOR_QUEUE_SIZE + 4];
+static uint8_t				received 	= 0;
+
+/**
+ * @brief Simulated sensor interrupt.
+ */
+static void sensor_isr(){
+	reactor_t::post(REACTOR_EVENT_SENSOR, fired++, 0);
+}
+
+/**
+ * @brief Sensor event handler, checks the latency.
+ */
+static void on_sensor(reactor_event_t* event, void* context){
+
+	uint32_t late = (uint32_t)(sys_clock::now() - raised[event->source]);
+
+	if(event->source != handled){
+		out_of_order++;
+	}
+	if(late > late_max){
+		late_max = late;
+	}
+	handled++;
+}
+
+/**
+ * @brief Socket poller, data arrives at readable_at.
+ */
+static void poll_socket(void* context){
+
+	if(readable_at && clock_reached(readable_at, sys_clock::now())){
+		readable_at = 0;
+		reactor_t::post(REACTOR_EVENT_NET_READABLE, 0, 0);
+	}
+}
+
+static void on_readable(reactor_event_t* event, void* context){
+	read_at = sys_clock::now();
+}
+
+static void on_user(reactor_event_t* event, void* context){
+	sources[received++] = event->source;
+}
+
+/**
+ * @brief A pass of the BIOS loop, as in BIOS_run().
+ */
+static void bios_pass(){
+
+	reactor_t::poll();
+	reactor_t::dispatch();
+	sched->run();
+	reactor_t::dispatch();
+	sched->idle();
+}
+
+static void noop(){
+}
+
+int main(){
+
+	host_reset(0);
+	host_spin(TEST_READ_US);
+	sys_clock::start();
+
+	/*
+	 * A slow task, the loop idles between its runs
+	 */
+	sched = new scheduler_t();
+	task_t* slow = new task_t(1000, -1, noop, 0);
+	sched->add_task(slow);
+	slow->enable();
+
+	reactor_t::start(sched);
+	CHECK(reactor_t::attach(REACTOR_EVENT_SENSOR, on_sensor, NULL) == STATUS_OK);
+	CHECK(reactor_t::attach(REACTOR_EVENT_SENSOR, on_sensor, NULL) == STATUS_ERR_DENIED);
+	CHECK(reactor_t::attach(REACTOR_EVENT_NET_READABLE, on_readable, NULL) == STATUS_OK);
+	CHECK(reactor_t::attach(REACTOR_EVENT_USER, on_user, NULL) == STATUS_OK);
+	CHECK(reactor_t::add_poller(poll_socket, NULL) == STATUS_OK);
+
+	/*
+	 * Interrupts at random times, handled as they come
+	 */
+	randomSeed(11);
+	clock_us_t start 	= sys_clock::now();
+	clock_us_t at 		= start;
+	for(uint8_t i = 0; i < TEST_EVENTS; i++){
+		at 			+= random(1000, (CLOCK_MS(TEST_SPAN_MS) / TEST_EVENTS) * 2 - 1000);
+		raised[i] 	= at;
+		CHECK(host_event(at, sensor_isr));
+	}
+
+	while(handled < TEST_EVENTS && clock_before(sys_clock::now(), at + CLOCK_MS(1000))){
+		bios_pass();
+	}
+
+	printf("%u of %u events handled, late max %u us\n", handled, TEST_EVENTS, late_max);
+	CHECK(handled == TEST_EVENTS);
+	CHECK(out_of_order == 0);
+	CHECK(late_max <= TEST_LATE_US);
+
+	/*
+	 * Socket data seen by the poller within REACTOR_POLL_MS
+	 */
+	clock_us_t ready = sys_clock::now() + CLOCK_MS(123) + 457;
+	readable_at = ready;
+	while(!read_at && clock_before(sys_clock::now(), ready + CLOCK_MS(1000))){
+		bios_pass();
+	}
+
+	printf("socket data read %llu us after arrival\n", (unsigned long long)(read_at - ready));
+	CHECK(read_at != 0);
+	CHECK((read_at - ready) <= CLOCK_MS(REACTOR_POLL_MS) + TEST_LATE_US);
+
+	/*
+	 * A full queue drops the newest events, the others are kept in order
+	 */
+	uint8_t rejected = 0;
+	for(uint8_t i = 0; i < sizeof(sources); i++){
+		if(reactor_t::post(REACTOR_EVENT_USER, i, 0) == ERR_BUFFER_OVERFLOW){
+			rejected++;
+		}
+	}
+	CHECK(reactor_t::pending());
+	CHECK(reactor_t::dispatch() == REACTOR_QUEUE_SIZE);
+	CHECK(!reactor_t::pending());
+
+	printf("%u posted, %u dispatched, %u dropped\n", (unsigned)sizeof(sources), received,
+			reactor_t::get_dropped());
+	CHECK(rejected == (sizeof(sources) - REACTOR_QUEUE_SIZE));
+	CHECK(reactor_t::get_dropped() == rejected);
+	CHECK(received == REACTOR_QUEUE_SIZE);
+	for(uint8_t i = 0; i < received; i++){
+		CHECK(sources[i] == i);
+	}
+
+	return host_report("test_reactor");
+}
@@ -0,0 +1,307 @@
+/*
+ * test_sampler.cpp
+ *
+ * The timer paced sampler on the simulated clock: the ticks read
+ * the sensor at the exact rate, a tick that finds a task transaction
+ * on the bus is deferred, the release only notifies and service()
+ * reads it, in task context. The drained blocks are teed to the
+ * sinks, every sample in order.
+ */
+
+#include "host.h"
+
+#include <platform/sampler/sampler.h>
+#include <platform/bus/i2c/bus_i2c.h>
+
+/*
+ * The simulated devices
+ */
+#define TEST_ACC_ADDR		(0x18)
+#define TEST_SLOW_ADDR		(0x40)
+
+/*
+ * Sampling rate and span
+ */
+#define TEST_RATE_HZ		(250)
+#define TEST_PERIOD_US		(1000000 / TEST_RATE_HZ)
+#define TEST_SPAN_MS		(2000)
+
+/*
+ * Allowed lateness of a deferred read past the transaction end
+ */
+#define TEST_LATE_US		(50)
+
+/*
+ * Transfer time of the slow device, moves the axis values
+ */
+static uint32_t				hold_us 	= 0;
+static int16_t				axis 		= 0;
+
+/*
+ * Release notifications
+ */
+static uint32_t				notified 	= 0;
+static uint16_t				pending_at_notify = 0;
+
+/**
+ * @brief What a sink saw.
+ */
+typedef struct {
+
+	uint32_t				samples;
+	uint32_t				blocks;
+	uint32_t				gaps;
+	int16_t					next;
+}seen_t;
+
+static seen_t				seen[SAMPLER_SINKS_MAX];
+
+/**
+ * @brief The simulated bus: an accelerometer, and a slow device.
+ */
+static bool device(uint8_t addr, uint8_t index, uint8_t* data, uint8_t size, bool read){
+
+	if(TEST_ACC_ADDR == addr){
+		if(read){
+			for(uint8_t i = 0; i < size; i += 2){
+				data[i] 		= (uint8_t)(axis & 0xFF);
+				data[i + 1] 	= (uint8_t)(axis >> 8);
+			}
+			axis++;
+		}
+		return true;
+	}
+
+	if(TEST_SLOW_ADDR == addr){
+		if(read){
+			host_advance(hold_us);
+			memset(data, 0, size);
+		}
+		return true;
+	}
+	return false;
+}
+
+/**
+ * @brief A sensor the sampler can pace, read over the bus.
+ */
+class fake_sensor: public sensor {
+
+	public:
+
+		fake_sensor(bus_i2c* i2c) : sensor(){
+			this->i2c 		= i2c;
+			hal.sample_rate = 0;
+		}
+
+		uint16_t sample(sensor_sample_t* samples, uint16_t max){
+
+			uint8_t raw[6];
+			if(sizeof(raw) != i2c->read_burst(TEST_ACC_ADDR, 0x02, raw, sizeof(raw))){
+				return 0;
+			}
+			for(uint8_t i = 0; i < 3; i++){
+				samples[0].value[i] = (int16_t)(raw[2 * i] | (raw[2 * i + 1] << 8));
+			}
+			return 1;
+		}
+
+		bool sampling(uint32_t rate, sensor_trigger_t trigger, uint8_t batch){
+
+			if(SENSOR_TRIGGER_TIMER != trigger){
+				return false;
+			}
+			hal.sample_rate = rate;
+			return true;
+		}
+
+	private:
+
+		bus_i2c*	i2c;
+};
+
+/**
+ * @brief Deferred trigger notification, as the BIOS loop gets it.
+ */
+static void on_pending(){
+	notified++;
+	pending_at_notify = sampler_t::pending();
+}
+
+/**
+ * @brief Counts a teed block, each sample follows the previous one.
+ */
+static void sink(void* context, const sensor_sample_t* samples, uint16_t count){
+
+	seen_t* s = (seen_t*)context;
+	for(uint16_t i = 0; i < count; i++){
+		if(s->samples && (samples[i].value[0] != s->next)){
+			s->gaps++;
+		}
+		s->next = samples[i].value[0] + 1;
+		s->samples++;
+	}
+	s->blocks++;
+}
+
+/**
+ * @brief Takes the samples out of the ring.
+ *
+ * @param 	samples			Where to copy them
+ * @param 	max				The room
+ * @return	count			The samples read
+ */
+static uint16_t drain(sensor_sample_t* samples, uint16_t max){
+	return sampler_t::drain(samples, max);
+}
+
+/**
+ * @brief A task transaction on the slow device.
+ *
+ * @param 	bus				The bus
+ * @param 	after			Start, us after the last tick
+ * @param 	hold			The transfer time (us)
+ * @param 	last			The last tick
+ */
+static void transaction(bus_i2c* bus, uint32_t after, uint32_t hold, clock_us_t last){
+
+	uint8_t data[2];
+
+	host_advance((last + after) - sys_clock::now());
+	hold_us = hold;
+	CHECK(bus->read_block(TEST_SLOW_ADDR, 0, data, sizeof(data)) == sizeof(data));
+	hold_us = 0;
+}
+
+int main(){
+
+	static sensor_sample_t 	samples[SAMPLER_BUFFER_SIZE];
+	sampler_stats_t 		stats;
+
+	host_reset(0);
+	sys_clock::start();
+	host_wire_attach(device);
+
+	bus_i2c* 	bus = new bus_i2c();
+	fake_sensor	acc(bus);
+
+	sampler_t::pending_notify = on_pending;
+
+	/*
+	 * Ticks at the exact rate, read at once
+	 */
+	clock_us_t start = sys_clock::now();
+	CHECK(sampler_t::start(&acc, TEST_RATE_HZ) == STATUS_OK);
+	CHECK(sampler_t::owns(&acc));
+	CHECK(sampler_t::start(&acc, TEST_RATE_HZ) == ERR_TIMER_ALREADY_RUNNING);
+
+	uint32_t	count 	= 0;
+	uint32_t	off 	= 0;
+	clock_us_t	last 	= start;
+	for(uint32_t ms = 0; ms < TEST_SPAN_MS; ms += 10){
+		host_advance(CLOCK_MS(10));
+		uint16_t read = drain(samples, SAMPLER_BUFFER_SIZE);
+		for(uint16_t i = 0; i < read; i++){
+			if(((samples[i].timestamp - last) != TEST_PERIOD_US) || samples[i].late){
+				off++;
+			}
+			if(samples[i].value[0] != (int16_t)count){
+				off++;
+			}
+			last = samples[i].timestamp;
+			count++;
+		}
+	}
+
+	sampler_t::get_stats(&stats);
+	printf("%u samples in %u ms, %u off the period, spacing max %u us, late max %u us\n",
+			count, TEST_SPAN_MS, off, stats.spacing_max, stats.late_max);
+	CHECK(count == (TEST_SPAN_MS * TEST_RATE_HZ) / 1000);
+	CHECK(off == 0);
+	CHECK(stats.spacing_max == 0);
+	CHECK(stats.late_max == 0);
+	CHECK(stats.deferred == 0);
+	CHECK(stats.unclaimed == count);
+
+	/*
+	 * Every block teed to the sinks from now on
+	 */
+	for(uint8_t i = 0; i < SAMPLER_SINKS_MAX; i++){
+		CHECK(sampler_t::add_sink(sink, &seen[i]) == STATUS_OK);
+	}
+	CHECK(sampler_t::add_sink(sink, NULL) == ERR_NO_MEMORY);
+	uint32_t teed = 0;
+
+	/*
+	 * A tick during a task transaction waits for the release, which
+	 * only notifies, and service() reads it
+	 */
+	sampler_t::clear_stats();
+	transaction(bus, 1000, 5000, last);
+
+	sampler_t::get_stats(&stats);
+	CHECK(stats.deferred == 1);
+	CHECK(stats.missed == 0);
+	CHECK(notified == 1);
+	CHECK(pending_at_notify == 0);
+	CHECK(sampler_t::pending() == 0);
+
+	clock_us_t served = sys_clock::now();
+	sampler_t::service();
+	CHECK(drain(samples, 1) == 1);
+	printf("deferred tick read %u us late, at the release + %llu us\n", samples[0].late,
+			(unsigned long long)(samples[0].timestamp - served));
+	CHECK(samples[0].late >= (5000 + 1000 - TEST_PERIOD_US));
+	CHECK(samples[0].late <= (5000 + 1000 - TEST_PERIOD_US) + TEST_LATE_US);
+	CHECK(samples[0].value[0] == (int16_t)count);
+	count++;
+	teed++;
+
+	/*
+	 * Nothing waits, service() does nothing
+	 */
+	sampler_t::service();
+	CHECK(sampler_t::pending() == 0);
+
+	/*
+	 * Two ticks in one transaction, after a normal one, the second
+	 * is lost and counted
+	 */
+	last += 2 * TEST_PERIOD_US;
+	transaction(bus, 1000, 10000, last);
+
+	sampler_t::get_stats(&stats);
+	CHECK(stats.deferred == 2);
+	CHECK(stats.missed == 1);
+	CHECK(notified == 2);
+	sampler_t::service();
+	CHECK(drain(samples, SAMPLER_BUFFER_SIZE) == 2);
+	teed += 2;
+
+	/*
+	 * Back on the timer, then stopped
+	 */
+	host_advance(CLOCK_MS(100));
+	CHECK(drain(samples, SAMPLER_BUFFER_SIZE) == (100 / (TEST_PERIOD_US / 1000)));
+	teed += (100 / (TEST_PERIOD_US / 1000));
+
+	/*
+	 * The sinks saw all of it, in order, nothing unclaimed
+	 */
+	sampler_t::get_stats(&stats);
+	for(uint8_t i = 0; i < SAMPLER_SINKS_MAX; i++){
+		printf("sink %u: %u samples in %u blocks, %u gaps\n", i, seen[i].samples, seen[i].blocks,
+				seen[i].gaps);
+		CHECK(seen[i].samples == teed);
+		CHECK(seen[i].blocks == 3);
+		CHECK(seen[i].gaps == 0);
+	}
+	CHECK(stats.unclaimed == 0);
+
+	sampler_t::stop();
+	CHECK(!sampler_t::owns(&acc));
+	host_advance(CLOCK_MS(100));
+	CHECK(drain(samples, SAMPLER_BUFFER_SIZE) == 0);
+
+	return host_report("test_sampler");
+}
@@ -0,0 +1,188 @@
+/*
+ * test_tickless.cpp
+ *
+ * Tickless idle on the simulated clock: the tasks run on their
+ * deadlines, never early nor late, the loop sleeps in between in
+ * one sleep per deadline and a wake request ends the sleep at once,
+ * through the wake hook.
+ */
+
+#include "host.h"
+
+#include <task/task.h>
+#include <task/scheduler.h>
+
+/*
+ * Simulated span
+ */
+#define TEST_SPAN_MS		(5000)
+
+/*
+ * Allowed lateness, the loop passes between the sleep and the deadline
+ */
+#define TEST_LATE_US		(50)
+
+/*
+ * Simulated time of a clock read
+ */
+#define TEST_READ_US		(1)
+
+/**
+ * @brief A watched task
+ */
+typedef struct {
+
+	task_t*					task;
+	uint32_t				interval;	// ms
+	clock_us_t				first;		// First deadline
+	uint32_t				runs;
+	uint32_t				early;
+	uint32_t				late;
+	uint32_t				late_max;	// us
+}watched_t;
+
+static scheduler_t*			sched;
+static watched_t			watched[2];
+
+/*
+ * Sleep accounting
+ */
+static uint64_t				slept_us 	= 0;
+static uint32_t				sleeps 		= 0;
+
+/*
+ * Wake request
+ */
+static clock_us_t			woken_at 	= 0;
+static uint32_t				wakes 		= 0;
+
+/**
+ * @brief Checks a run against its deadline.
+ *
+ * @param 	context			The watched task
+ */
+static void check_run(void* context){
+
+	watched_t*	w 			= (watched_t*)context;
+	clock_us_t	now 		= sys_clock::now();
+	clock_us_t	deadline 	= w->first + CLOCK_MS(w->interval) * w->runs;
+
+	if(clock_before(now, deadline)){
+		w->early++;
+	}else{
+		uint32_t late = (uint32_t)(now - deadline);
+		if(late > TEST_LATE_US){
+			w->late++;
+		}
+		if(late > w->late_max){
+			w->late_max = late;
+		}
+	}
+	w->runs++;
+}
+
+/**
+ * @brief Sleep primitive, counts the time slept.
+ *
+ * @param 	ms				The time to sleep
+ */
+static void counted_sleep(uint32_t ms){
+
+	clock_us_t start = sys_clock::now();
+	sleep(ms);
+	slept_us += sys_clock::now() - start;
+	sleeps++;
+}
+
+/**
+ * @brief Wake primitive, the simulated sleep already ends on the
+ * interrupt.
+ */
+static void counted_wake(){
+	wakes++;
+}
+
+/**
+ * @brief Simulated interrupt asking for a wake up.
+ */
+static void wake_isr(){
+
+	woken_at = sys_clock::now();
+	sched->wake();
+}
+
+int main(){
+
+	static const uint32_t intervals[2] = {50, 130};
+
+	host_reset(0);
+	host_spin(TEST_READ_US);
+	sys_clock::start();
+
+	sched = new scheduler_t();
+	sched->set_sleep(counted_sleep, counted_wake);
+
+	for(uint8_t i = 0; i < 2; i++){
+		watched[i].interval = intervals[i];
+		watched[i].task 	= new task_t(intervals[i], -1, check_run, &watched[i], i);
+		sched->add_task(watched[i].task);
+		watched[i].task->enable();
+		watched[i].first 	= watched[i].task->next_run();
+	}
+
+	/*
+	 * The BIOS loop: run what is due, sleep until the next deadline
+	 */
+	clock_us_t start 	= sys_clock::now();
+	clock_us_t end 		= start + CLOCK_MS(TEST_SPAN_MS);
+	while(clock_before(sys_clock::now(), end)){
+		sched->run();
+		sched->idle();
+	}
+
+	for(uint8_t i = 0; i < 2; i++){
+		watched_t* w = &watched[i];
+		printf("task %u: %u runs, late max %u us\n", i, w->runs, w->late_max);
+		CHECK(w->runs >= (TEST_SPAN_MS / w->interval));
+		CHECK(w->early == 0);
+		CHECK(w->late == 0);
+	}
+
+	/*
+	 * Asleep most of the time, at most one sleep per run
+	 */
+	uint64_t span = sys_clock::now() - start;
+	printf("slept %llu of %llu us in %u sleeps\n",
+			(unsigned long long)slept_us, (unsigned long long)span, sleeps);
+	CHECK(slept_us >= (span * 9) / 10);
+	CHECK(sleeps <= (watched[0].runs + watched[1].runs + 1));
+	CHECK(wakes == 0);
+
+	/*
+	 * A wake request in the middle of a sleep ends the idle period,
+	 * from a pass with a long sleep ahead
+	 */
+	clock_us_t deadline;
+	for(;;){
+		sched->run();
+		CHECK(sched->next_deadline(&deadline));
+		if((deadline - sys_clock::now()) > CLOCK_MS(20)){
+			break;
+		}
+		sched->idle();
+	}
+
+	clock_us_t raised = sys_clock::now() + (deadline - sys_clock::now()) / 2;
+	CHECK(host_event(raised, wake_isr));
+	sched->idle();
+
+	clock_us_t back = sys_clock::now();
+	printf("woken %llu us after the request, %llu us before the deadline\n",
+			(unsigned long long)(back - woken_at), (unsigned long long)(deadline - back));
+	CHECK(woken_at >= raised);
+	CHECK(wakes == 1);
+	CHECK((back - woken_at) <= TEST_LATE_US);
+	CHECK(clock_before(back, deadline));
+
+	return host_report("test_tickless");
+}
@@ -0,0 +1,123 @@
+/*
+ * test_watchdog.cpp
+ *
+ * The task watchdog on the simulated clock: a task over its budget
+ * with TASK_WDT_RESTART runs again afterwards, with its iterations
+ * back to the count it was set with, and TASK_WDT_DISABLE parks it.
+ */
+
+#include "host.h"
+
+#include <task/task.h>
+#include <task/scheduler.h>
+
+/*
+ * Task interval, budget and the run that hangs (ms)
+ */
+#define TEST_INTERVAL_MS	(20)
+#define TEST_BUDGET_MS		(5)
+#define TEST_HANG_MS		(15)
+#define TEST_HANG_RUN		(3)
+
+/*
+ * The finite task
+ */
+#define TEST_ITERATIONS		(6)
+
+/*
+ * Simulated span
+ */
+#define TEST_SPAN_MS		(1000)
+
+/**
+ * @brief A watched task
+ */
+typedef struct {
+
+	task_t*					task;
+	uint32_t				runs;
+	uint32_t				restarts;
+}watched_t;
+
+static watched_t			endless;
+static watched_t			finite;
+static watched_t			parked;
+
+/**
+ * @brief Task body, hangs on one run.
+ *
+ * @param 	context			The watched task
+ */
+static void hang_once(void* context){
+
+	watched_t* w = (watched_t*)context;
+
+	if(++w->runs == TEST_HANG_RUN){
+		delay(TEST_HANG_MS);
+	}
+}
+
+static void endless_restart(){
+	endless.restarts++;
+}
+
+static void finite_restart(){
+	finite.restarts++;
+}
+
+int main(){
+
+	host_reset(0);
+	host_spin(1);
+	sys_clock::start();
+
+	scheduler_t sched;
+
+	endless.task 	= new task_t(TEST_INTERVAL_MS, -1, hang_once, &endless, 0);
+	finite.task 	= new task_t(TEST_INTERVAL_MS, TEST_ITERATIONS, hang_once, &finite, 1);
+	parked.task 	= new task_t(TEST_INTERVAL_MS, -1, hang_once, &parked, 2);
+
+	endless.task->set_budget(TEST_BUDGET_MS, TASK_WDT_RESTART);
+	endless.task->set_restart_callback(endless_restart);
+	finite.task->set_budget(TEST_BUDGET_MS, TASK_WDT_RESTART);
+	finite.task->set_restart_callback(finite_restart);
+	parked.task->set_budget(TEST_BUDGET_MS, TASK_WDT_DISABLE);
+
+	watched_t* all[3] = {&endless, &finite, &parked};
+	for(uint8_t i = 0; i < 3; i++){
+		sched.add_task(all[i]->task);
+		all[i]->task->enable();
+	}
+
+	clock_us_t end = sys_clock::now() + CLOCK_MS(TEST_SPAN_MS);
+	while(clock_before(sys_clock::now(), end)){
+		sched.run();
+		sched.idle();
+	}
+
+	printf("endless: %u runs, %u restarts\n", endless.runs, endless.restarts);
+	printf("finite : %u runs, %u restarts\n", finite.runs, finite.restarts);
+	printf("parked : %u runs\n", parked.runs);
+
+	/*
+	 * Restarted, and running on its interval again
+	 */
+	CHECK(endless.restarts == 1);
+	CHECK(endless.task->is_enabled());
+	CHECK(endless.runs >= (TEST_SPAN_MS - TEST_HANG_MS) / TEST_INTERVAL_MS - 1);
+
+	/*
+	 * Restarted with its full count: the runs before the trip, then
+	 * the set iterations again
+	 */
+	CHECK(finite.restarts == 1);
+	CHECK(finite.runs == TEST_HANG_RUN + TEST_ITERATIONS);
+
+	/*
+	 * Disabled for good
+	 */
+	CHECK(parked.runs == TEST_HANG_RUN);
+	CHECK(!parked.task->is_enabled());
+
+	return host_report("test_watchdog");
+}